@@ -43,7 +43,7 @@ func main() {
 
 ### 2.3 Keywords (preliminary)
 ```
-func, var, let, class, interface, enum, if, else, for, while, return,
+func, var, let, class, struct, interface, enum, if, else, for, while, return,
 import, package, public, private, protected, throw, try, catch, finally,
 async, await, io, compute, unsafe, shared, nil, true, false, new, match,
 operator
@@ -83,6 +83,12 @@ func divide(a: Int, b: Int) -> Int { ... }
 | `String` | UTF-8 string (reference type) |
 | `Void` | No return value |
 
+Arrays (`[T]`) store their elements contiguously at the element's own width:
+a `[Float32]` uses 4 bytes per element and `[Int8]` and `[UInt8]` one. An
+array literal takes its element type from the array it initialises, so
+`var xs: [Int32] = [1, 2, 3]` stores three 32-bit integers. `Bytes` is
+shorthand for `[UInt8]`.
+
 ### 3.2 Type Inference
 Types are inferred where possible. Explicit annotations are always allowed.
 ```
@@ -126,9 +132,23 @@ var intBox = Box.new(42);       // Box<Int>
 var strBox = Box.new("hello");  // Box<String>
 ```
 
-Generic constraints via interfaces:
+Generic functions take type parameters after the name. Type arguments are
+inferred from the call's arguments; each distinct set of type arguments is
+compiled to its own specialised copy, so there is no boxing or indirect call:
 ```
-func printAll<T: Printable>(items: List<T>) {
+func largest<T: Comparable>(a: T, b: T) -> T {
+    if a > b { return a; }
+    return b;
+}
+
+largest(3, 7);        // largest<Int>
+largest(1.5, 2.5);    // largest<Float>
+```
+
+A bound is `Comparable` (numbers and `Char`), `Numeric` (arithmetic), or an
+interface whose methods the body may call:
+```
+func printAll<T: Printable>(items: [T]) {
     for item in items {
         print(item.toString());
     }
@@ -165,6 +185,37 @@ var message = match r {
 };
 ```
 
+### 3.6 SIMD Vectors
+Fixed-width vector values for data-parallel arithmetic. Each maps to a
+hardware vector register (wider vectors are split on narrower hardware).
+
+| Type | Lanes |
+|---|---|
+| `Float32x4`, `Float32x8` | `Float32` |
+| `Float64x2`, `Float64x4` | `Float` |
+| `Int32x4`, `Int32x8` | `Int32` |
+| `Int64x2`, `Int64x4` | `Int` |
+| `Int8x16`, `Int8x32` | `Int8` |
+| `Mask2` … `Mask32` | `Bool`, one per lane |
+
+```
+func dot(a: [Float], b: [Float]) -> Float {
+    var acc = Float64x4.splat(0.0);
+    var i = 0;
+    while i + 4 <= a.length {
+        acc = Float64x4.loadArray(a, i).fma(Float64x4.loadArray(b, i), acc);
+        i = i + 4;
+    }
+    return acc.sum();
+}
+```
+- Operators apply lane by lane to two vectors of the same type: arithmetic, bitwise and shifts (integer lanes), and comparisons, which yield a mask
+- Construct with `T.splat(x)`, `T.load(ptr)`, `T.loadArray(array, index)`, `T.gather(array, indexes)` and `T.select(mask, a, b)`; write back with `v.store(ptr)` and `v.storeArray(array, index)`; `ptr` need not be aligned to the vector or its lanes
+- `v.get(i)` and `v.with(i, x)` read and replace one lane; `v.shuffle(...)` reorders lanes by literal indexes
+- Reductions `sum()`, `min()`, `max()`; `abs()`; `fma(b, c)` and `sqrt()` for float lanes; `toInt()` / `toFloat()` convert between `Float32`/`Int32` and `Float`/`Int` lanes
+- Masks have `any()` and `all()`
+- Array accesses are bounds-checked for every lane, as for indexing, and convert from the array's element type
+
 ---
 
 ## 4. Object Model
@@ -215,8 +266,19 @@ class User : Serializable {
         // parse and return
     }
 }
+
+func save(item: Serializable) -> String {
+    return item.serialize();
+}
 ```
 
+Interfaces can be used as parameter, variable and field types. Methods
+called through a base class or interface dispatch on the object's class at
+run time. Classes in a hierarchy or implementing an interface carry a
+pointer to a constant vtable; the compiler calls the implementation directly
+when only one is possible: the receiver was just constructed, its class has
+no subclasses, or no subclass overrides the method.
+
 ### 4.4 Operator Overloading
 Classes can define custom operators for readability:
 ```
@@ -265,8 +327,26 @@ var doubled = numbers.map((x) => x * 2);
 // Closures capture variables from enclosing scope
 var multiplier = 3;
 var tripled = numbers.map((x) => x * multiplier);
+
+// Fold to a single value of the element type
+var total = numbers.reduce(0, (acc, x) => acc + x);
 ```
 
+When a lambda literal is passed straight to `map`, `filter`, `forEach` or
+`reduce`, its body is compiled into the loop over the array rather than
+called once per element; other function values are called from that loop.
+`map` and `filter` allocate their result once.
+
+A closure captures the variables it uses by value, when it is created, so
+later assignments in the enclosing scope are not seen and assigning to a
+captured variable inside the lambda is an error (E3054). Named functions
+can be passed wherever a function type is expected. A lambda that captures
+nothing is a constant; one that does not outlive its scope (a local that is
+only called, or an argument to a function that only calls it) keeps its
+captures on the stack, and calls through a local with a known lambda are
+direct. Only closures that escape — returned, stored, or passed elsewhere —
+are allocated on the heap.
+
 ### 4.3 Access Modifiers
 | Modifier | Scope |
 |---|---|
@@ -276,6 +356,29 @@ var tripled = numbers.map((x) => x * multiplier);
 
 Default access (no modifier) is `private`.
 
+### 4.6 Value Types: Structs
+A `struct` is declared like a class but is a value: it lives inline in its
+variable, array element or enclosing object, is copied on assignment and when
+passed or returned, and is never allocated on the GC heap. Methods see `this`
+by reference, so `p.move()` updates `p` itself.
+```
+struct Vec2 {
+    public var x: Float;
+    public var y: Float;
+
+    public func scale(k: Float) {
+        this.x = this.x * k;
+        this.y = this.y * k;
+    }
+}
+
+var particles = [Vec2 { x: 1.0, y: 2.0 }, Vec2 { x: 3.0, y: 4.0 }];
+particles[1].x = 5.0;   // updated in place, no allocation
+```
+- Fields are limited to numbers, `Bool`, `Char`, simple enums and other structs
+- Structs cannot inherit, implement interfaces, be generic or be nullable
+- `==` is not defined on structs; compare their fields
+
 ---
 
 ## 5. Memory Management
@@ -299,6 +402,8 @@ Inside `unsafe`:
 - Raw pointers (`Ptr<T>`) are available
 - Manual `alloc<T>()` and `free(ptr)` functions
 - Pointer arithmetic allowed
+- Sized reads and writes through a pointer (`ptrLoadInt32(p)`, `ptrStoreFloat64(p, x)`, `ptrLoadU32BE(p)`, ...) need not be aligned
+- They take an optional trailing alignment the address is known to have, a power-of-two literal: `ptrLoadInt32(p, 4)`, `ptrStoreFloat64(p, x, 8)`
 - No GC tracking — developer is fully responsible
 - The compiler emits warnings for common mistakes (double-free, use-after-free) where detectable
 
@@ -492,14 +597,50 @@ Batteries-included but **modular** — only linked modules are included in the b
 ```bash
 chris new myproject          # Create new project
 chris build                  # Compile to native binary
-chris run                    # Build and run
+chris build -j 8             # Parse and compile up to 8 files at once
+chris run                    # JIT-compile in memory and run
+chris run --aot              # Build a native binary, then run it
 chris test                   # Run tests
+chris test -j 8 --shard 1/4  # Run the first quarter of the test files, 8 at a time
+chris bench                  # Run benchmarks in bench/
+chris bench --output json    # Benchmark results as JSON, usable as a --baseline
 chris add <package>          # Add dependency
 chris fmt                    # Format code (deterministic, single canonical style)
 chris lint                   # Lint code
 chris build --output json    # Build with machine-parseable error output
 ```
 
+`chris build` compiles every imported file to its own object file, cached in
+`.chris-cache/` next to the entry file. A file is recompiled when its source
+changes or when the interface of the program does: declarations and their
+signatures, class layouts, and the full text of files whose bodies other files
+compile (generics, `@Inline`/`@Pure`/`@ReadOnly` functions, initialized
+globals). Instrumented and profile-guided builds compile the program as one
+module. With `-j N`, imported files are parsed and the out-of-date ones
+compiled up to N at a time; the program is still type-checked as a whole.
+
+`chris test` runs each `test_*.chr`/`*_test.chr` file in a process of its own,
+compiling its harness through the JIT, so a crash or `exit` in one file is
+reported against its current test without affecting the others. Output is
+grouped per file, with per-test timings; `--output json` prints one report of
+every file and test instead.
+
+`chris bench` runs the `@Benchmark` functions and `bench_*` functions (no
+parameters) of each `bench_*.chr`/`*_bench.chr` file, one file at a time. Each
+benchmark is called in batches that grow until one lasts the warmup time
+(100 ms) and then until one lasts the bench time (1 s, `--bench-time=<ms>`);
+that batch is reported as ns/op, allocations/op, bytes/op and GCs/op. With
+`--baseline=<report.json>`, a benchmark more than `--max-regression` percent
+(default 10) slower than its baseline fails the run. `blackBox(x)` returns `x`
+without letting the optimiser see or discard the value:
+
+```
+@Benchmark
+func parseSmall() {
+    blackBox(parse(blackBox(sample)));
+}
+```
+
 ### 10.2 Project Structure
 ```
 myproject/
@@ -543,6 +684,17 @@ class CStruct {
 }
 ```
 
+Optimisation hints on functions and methods:
+
+| Annotation | Effect |
+|------------|--------|
+| `@Inline` / `@NoInline` | Always / never inline the function |
+| `@Hot` / `@Cold` | Optimise for a frequently / rarely executed path |
+| `@Pure` | Touches no memory outside its own frame; calls may be merged or hoisted |
+| `@ReadOnly` | May read but never write memory outside its own frame |
+
+Contradictory pairs (`@Inline` with `@NoInline`, `@Hot` with `@Cold`, `@Pure` with `@ReadOnly`) are a compile error. `@Pure` and `@ReadOnly` are checked: a body that visibly breaks the promise (a field store, a call to an unannotated function) gets a warning and the annotation is ignored. Unannotated functions still have their memory effects inferred at build time.
+
 ### 11.2 Reflection
 Basic runtime type inspection:
 ```
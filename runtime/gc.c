@@ -11,6 +11,16 @@
 #define GC_INITIAL_THRESHOLD (1024 * 1024)  // 1 MB
 #define GC_HEAP_GROW_FACTOR  2
 #define GC_ROOT_STACK_INITIAL_CAP 256
+#define GC_INDEX_INITIAL_CAP 1024       // power of two
+
+// Per-thread shadow stack. Each thread pushes and pops (and, after a caught
+// exception, truncates) only its own stack; the collector scans all of them.
+typedef struct GCRootStack {
+    void*** slots;               // array of (void**) — each points to a stack slot holding a GC ptr
+    size_t size;
+    size_t cap;
+    struct GCRootStack* next;    // registry link (guarded by gc_heap.lock)
+} GCRootStack;
 
 typedef struct {
     GCObject* head;              // head of all-objects linked list
@@ -18,11 +28,22 @@ typedef struct {
     size_t next_gc;              // byte threshold to trigger next collection
     size_t object_count;         // number of live GC objects
     size_t total_collections;    // cumulative collection count
+    size_t total_allocations;    // cumulative allocation count
+    size_t total_bytes;          // cumulative bytes allocated (including headers)
+
+    // Open-addressed set of every live object's header, so marking only
+    // follows values that point into the heap (a raw Ptr, an mmap region or
+    // an integer in a scanned field is left alone)
+    GCObject** index;
+    size_t index_cap;
 
-    // Shadow stack for GC roots
-    void*** root_stack;          // array of (void**) — each points to a stack slot holding a GC ptr
-    size_t root_stack_size;
-    size_t root_stack_cap;
+    // Shadow stacks of every thread that has pushed a root
+    GCRootStack* root_stacks;
+    pthread_key_t root_key;      // destructor unregisters a thread's stack on exit
+    unsigned generation;         // bumped by chris_gc_init; stale thread stacks are recreated
+
+    // Collections are skipped while > 0 (see chris_gc_defer_begin)
+    int defer_depth;
 
     // Thread safety
     pthread_mutex_t lock;
@@ -31,19 +52,79 @@ typedef struct {
 
 static GCHeap gc_heap = {0};
 
+static _Thread_local GCRootStack* gc_thread_roots = NULL;
+static _Thread_local unsigned gc_thread_roots_gen = 0;
+
+// Read from the profiler's signal handler on the same thread
+static _Thread_local volatile int gc_thread_phase = CHRIS_GC_IDLE;
+
 // ============================================================================
 // Internal helpers
 // ============================================================================
 
 static void gc_mark_object(GCObject* obj);
 
-static int is_gc_pointer(void* ptr) {
-    // Basic sanity: non-null, reasonably aligned
-    if (!ptr) return 0;
-    if ((uintptr_t)ptr < 0x1000) return 0; // reject very low addresses
+static size_t gc_index_slot(GCObject* obj) {
+    uintptr_t h = (uintptr_t)obj >> 4;
+    h *= (uintptr_t)0x9E3779B97F4A7C15ull;
+    return (size_t)(h >> 16) & (gc_heap.index_cap - 1);
+}
+
+static void gc_index_put(GCObject* obj) {
+    size_t i = gc_index_slot(obj);
+    while (gc_heap.index[i]) i = (i + 1) & (gc_heap.index_cap - 1);
+    gc_heap.index[i] = obj;
+}
+
+// Keep the index at most half full. Caller holds gc_heap.lock.
+static int gc_index_reserve(void) {
+    if ((gc_heap.object_count + 1) * 2 <= gc_heap.index_cap) return 1;
+    GCObject** old = gc_heap.index;
+    size_t old_cap = gc_heap.index_cap;
+    size_t cap = old_cap ? old_cap * 2 : GC_INDEX_INITIAL_CAP;
+    GCObject** grown = (GCObject**)calloc(cap, sizeof(GCObject*));
+    if (!grown) return 0;
+    gc_heap.index = grown;
+    gc_heap.index_cap = cap;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i]) gc_index_put(old[i]);
+    }
+    free(old);
     return 1;
 }
 
+// Remove by shifting later entries of the probe run back, so lookups never
+// need tombstones
+static void gc_index_remove(GCObject* obj) {
+    size_t mask = gc_heap.index_cap - 1;
+    size_t i = gc_index_slot(obj);
+    while (gc_heap.index[i] != obj) {
+        if (!gc_heap.index[i]) return;
+        i = (i + 1) & mask;
+    }
+    for (size_t j = (i + 1) & mask; gc_heap.index[j]; j = (j + 1) & mask) {
+        size_t home = gc_index_slot(gc_heap.index[j]);
+        // Move j into the hole unless its home lies cyclically in (i, j]
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            gc_heap.index[i] = gc_heap.index[j];
+            i = j;
+        }
+    }
+    gc_heap.index[i] = NULL;
+}
+
+// Whether ptr is the user pointer of a live object. Only the header's
+// address is computed; nothing is read until the index has matched it.
+static int is_gc_pointer(void* ptr) {
+    if (!ptr || (uintptr_t)ptr < 0x1000 + sizeof(GCObject)) return 0;
+    if (!gc_heap.index_cap) return 0;
+    GCObject* obj = GC_PTR_TO_OBJ(ptr);
+    for (size_t i = gc_index_slot(obj); gc_heap.index[i]; i = (i + 1) & (gc_heap.index_cap - 1)) {
+        if (gc_heap.index[i] == obj) return 1;
+    }
+    return 0;
+}
+
 // Mark a single object and recursively mark its children
 static void gc_mark_object(GCObject* obj) {
     if (!obj || obj->marked) return;
@@ -56,24 +137,19 @@ static void gc_mark_object(GCObject* obj) {
             // Leaf node — no child pointers to trace
             break;
 
-        case GC_OBJECT: {
+        case GC_OBJECT:
+        case GC_POLY_OBJECT: {
             // Class instance: scan the first num_pointers pointer-sized slots
             // Class fields are laid out sequentially in the struct.
             // We scan all pointer-sized fields. Non-pointer fields (int, float, bool)
             // will be scanned too but won't match any GC object — harmless.
+            // A polymorphic instance's vtable pointer and a closure's code
+            // pointer are static data and are skipped.
             void** fields = (void**)user_ptr;
-            for (uint16_t i = 0; i < obj->num_pointers; i++) {
+            for (uint16_t i = obj->type == GC_POLY_OBJECT ? 1 : 0; i < obj->num_pointers; i++) {
                 void* child = fields[i];
                 if (is_gc_pointer(child)) {
-                    // Verify this looks like a GC-managed pointer by checking
-                    // if the preceding header region is accessible
-                    GCObject* child_obj = GC_PTR_TO_OBJ(child);
-                    // Walk the all-objects list to verify (expensive but safe)
-                    // For performance, we trust the pointer if it's non-null
-                    // and mark it. If it's not a real GC pointer, marked will
-                    // just set a random byte — but we mitigate this with the
-                    // num_pointers field being set accurately by codegen.
-                    gc_mark_object(child_obj);
+                    gc_mark_object(GC_PTR_TO_OBJ(child));
                 }
             }
             break;
@@ -110,20 +186,66 @@ static void gc_mark_object(GCObject* obj) {
     }
 }
 
-// Mark phase: trace from all roots
+// Mark phase: trace from the roots of every thread
 static void gc_mark(void) {
-    for (size_t i = 0; i < gc_heap.root_stack_size; i++) {
-        void** root_slot = gc_heap.root_stack[i];
-        if (!root_slot) continue;
-        void* ptr = *root_slot;
-        if (is_gc_pointer(ptr)) {
-            gc_mark_object(GC_PTR_TO_OBJ(ptr));
+    gc_thread_phase = CHRIS_GC_MARK;
+    for (GCRootStack* rs = gc_heap.root_stacks; rs; rs = rs->next) {
+        for (size_t i = 0; i < rs->size; i++) {
+            void** root_slot = rs->slots[i];
+            if (!root_slot) continue;
+            void* ptr = *root_slot;
+            if (is_gc_pointer(ptr)) {
+                gc_mark_object(GC_PTR_TO_OBJ(ptr));
+            }
         }
     }
+    gc_thread_phase = CHRIS_GC_IDLE;
+}
+
+// Unlink and free a thread's stack. Caller holds gc_heap.lock.
+static void gc_unregister_roots(GCRootStack* rs) {
+    for (GCRootStack** link = &gc_heap.root_stacks; *link; link = &(*link)->next) {
+        if (*link == rs) {
+            *link = rs->next;
+            break;
+        }
+    }
+    free(rs->slots);
+    free(rs);
+}
+
+static void gc_thread_exit(void* value) {
+    GCRootStack* rs = (GCRootStack*)value;
+    pthread_mutex_lock(&gc_heap.lock);
+    if (gc_heap.initialized) gc_unregister_roots(rs);
+    pthread_mutex_unlock(&gc_heap.lock);
+}
+
+// The calling thread's stack, created on first use. Caller holds gc_heap.lock.
+static GCRootStack* gc_current_roots(void) {
+    if (gc_thread_roots && gc_thread_roots_gen == gc_heap.generation) {
+        return gc_thread_roots;
+    }
+    GCRootStack* rs = (GCRootStack*)malloc(sizeof(GCRootStack));
+    if (rs) rs->slots = (void***)malloc(sizeof(void**) * GC_ROOT_STACK_INITIAL_CAP);
+    if (!rs || !rs->slots) {
+        fprintf(stderr, "GC: out of memory allocating root stack\n");
+        pthread_mutex_unlock(&gc_heap.lock);
+        exit(1);
+    }
+    rs->size = 0;
+    rs->cap = GC_ROOT_STACK_INITIAL_CAP;
+    rs->next = gc_heap.root_stacks;
+    gc_heap.root_stacks = rs;
+    pthread_setspecific(gc_heap.root_key, rs);
+    gc_thread_roots = rs;
+    gc_thread_roots_gen = gc_heap.generation;
+    return rs;
 }
 
 // Sweep phase: free unmarked objects, clear marks on survivors
 static void gc_sweep(void) {
+    gc_thread_phase = CHRIS_GC_SWEEP;
     GCObject** obj_ptr = &gc_heap.head;
     while (*obj_ptr) {
         GCObject* obj = *obj_ptr;
@@ -134,6 +256,7 @@ static void gc_sweep(void) {
         } else {
             // Unreachable — remove from list and free
             *obj_ptr = obj->next;
+            gc_index_remove(obj);
 
             size_t total_size = sizeof(GCObject) + obj->size;
             gc_heap.bytes_allocated -= total_size;
@@ -147,6 +270,7 @@ static void gc_sweep(void) {
             free(obj);
         }
     }
+    gc_thread_phase = CHRIS_GC_IDLE;
 }
 
 // ============================================================================
@@ -161,10 +285,13 @@ void chris_gc_init(void) {
     gc_heap.next_gc = GC_INITIAL_THRESHOLD;
     gc_heap.object_count = 0;
     gc_heap.total_collections = 0;
+    gc_heap.total_allocations = 0;
+    gc_heap.total_bytes = 0;
 
-    gc_heap.root_stack_cap = GC_ROOT_STACK_INITIAL_CAP;
-    gc_heap.root_stack_size = 0;
-    gc_heap.root_stack = (void***)malloc(sizeof(void**) * gc_heap.root_stack_cap);
+    gc_heap.root_stacks = NULL;
+    pthread_key_create(&gc_heap.root_key, gc_thread_exit);
+    gc_heap.generation++;
+    gc_heap.defer_depth = 0;
 
     pthread_mutex_init(&gc_heap.lock, NULL);
     gc_heap.initialized = 1;
@@ -174,7 +301,8 @@ void* chris_gc_alloc(size_t size, uint8_t type) {
     pthread_mutex_lock(&gc_heap.lock);
 
     // Check if we should collect before allocating
-    if (gc_heap.bytes_allocated + sizeof(GCObject) + size > gc_heap.next_gc) {
+    if (gc_heap.defer_depth == 0 &&
+        gc_heap.bytes_allocated + sizeof(GCObject) + size > gc_heap.next_gc) {
         gc_mark();
         gc_sweep();
         gc_heap.total_collections++;
@@ -188,21 +316,22 @@ void* chris_gc_alloc(size_t size, uint8_t type) {
 
     size_t total_size = sizeof(GCObject) + size;
     GCObject* obj = (GCObject*)malloc(total_size);
-    if (!obj) {
+    if ((!obj || !gc_index_reserve()) && gc_heap.defer_depth == 0) {
         // Last resort: try to collect and retry
         gc_mark();
         gc_sweep();
         gc_heap.total_collections++;
-        obj = (GCObject*)malloc(total_size);
-        if (!obj) {
-            fprintf(stderr, "GC: out of memory (requested %zu bytes)\n", size);
-            pthread_mutex_unlock(&gc_heap.lock);
-            exit(1);
-        }
+        if (!obj) obj = (GCObject*)malloc(total_size);
+    }
+    if (!obj || !gc_index_reserve()) {
+        fprintf(stderr, "GC: out of memory (requested %zu bytes)\n", size);
+        pthread_mutex_unlock(&gc_heap.lock);
+        exit(1);
     }
 
     obj->next = gc_heap.head;
     gc_heap.head = obj;
+    gc_index_put(obj);
     obj->marked = 0;
     obj->type = type;
     obj->num_pointers = 0;
@@ -211,6 +340,8 @@ void* chris_gc_alloc(size_t size, uint8_t type) {
 
     gc_heap.bytes_allocated += total_size;
     gc_heap.object_count++;
+    gc_heap.total_allocations++;
+    gc_heap.total_bytes += total_size;
 
     void* user_ptr = GC_OBJ_TO_PTR(obj);
     memset(user_ptr, 0, size); // zero-initialize
@@ -234,6 +365,10 @@ void chris_gc_set_num_pointers(void* ptr, uint16_t num_pointers) {
 
 void chris_gc_collect(void) {
     pthread_mutex_lock(&gc_heap.lock);
+    if (gc_heap.defer_depth > 0) {
+        pthread_mutex_unlock(&gc_heap.lock);
+        return;
+    }
     gc_mark();
     gc_sweep();
     gc_heap.total_collections++;
@@ -245,6 +380,18 @@ void chris_gc_collect(void) {
     pthread_mutex_unlock(&gc_heap.lock);
 }
 
+void chris_gc_defer_begin(void) {
+    pthread_mutex_lock(&gc_heap.lock);
+    gc_heap.defer_depth++;
+    pthread_mutex_unlock(&gc_heap.lock);
+}
+
+void chris_gc_defer_end(void) {
+    pthread_mutex_lock(&gc_heap.lock);
+    if (gc_heap.defer_depth > 0) gc_heap.defer_depth--;
+    pthread_mutex_unlock(&gc_heap.lock);
+}
+
 void chris_gc_shutdown(void) {
     if (!gc_heap.initialized) return;
 
@@ -263,12 +410,15 @@ void chris_gc_shutdown(void) {
     gc_heap.head = NULL;
     gc_heap.bytes_allocated = 0;
     gc_heap.object_count = 0;
+    free(gc_heap.index);
+    gc_heap.index = NULL;
+    gc_heap.index_cap = 0;
 
-    // Free root stack
-    free(gc_heap.root_stack);
-    gc_heap.root_stack = NULL;
-    gc_heap.root_stack_size = 0;
-    gc_heap.root_stack_cap = 0;
+    // Free root stacks; deleting the key drops exit destructors of live threads
+    while (gc_heap.root_stacks) {
+        gc_unregister_roots(gc_heap.root_stacks);
+    }
+    pthread_key_delete(gc_heap.root_key);
 
     gc_heap.initialized = 0;
     pthread_mutex_unlock(&gc_heap.lock);
@@ -281,36 +431,53 @@ void chris_gc_shutdown(void) {
 
 void chris_gc_push_root(void** root) {
     pthread_mutex_lock(&gc_heap.lock);
+    GCRootStack* rs = gc_current_roots();
 
-    if (gc_heap.root_stack_size >= gc_heap.root_stack_cap) {
-        gc_heap.root_stack_cap *= 2;
-        gc_heap.root_stack = (void***)realloc(gc_heap.root_stack,
-            sizeof(void**) * gc_heap.root_stack_cap);
-        if (!gc_heap.root_stack) {
+    if (rs->size >= rs->cap) {
+        rs->cap *= 2;
+        rs->slots = (void***)realloc(rs->slots, sizeof(void**) * rs->cap);
+        if (!rs->slots) {
             fprintf(stderr, "GC: out of memory growing root stack\n");
             pthread_mutex_unlock(&gc_heap.lock);
             exit(1);
         }
     }
 
-    gc_heap.root_stack[gc_heap.root_stack_size++] = root;
+    rs->slots[rs->size++] = root;
     pthread_mutex_unlock(&gc_heap.lock);
 }
 
 void chris_gc_pop_root(void) {
     pthread_mutex_lock(&gc_heap.lock);
-    if (gc_heap.root_stack_size > 0) {
-        gc_heap.root_stack_size--;
+    GCRootStack* rs = gc_current_roots();
+    if (rs->size > 0) {
+        rs->size--;
     }
     pthread_mutex_unlock(&gc_heap.lock);
 }
 
 void chris_gc_pop_roots(size_t n) {
     pthread_mutex_lock(&gc_heap.lock);
-    if (n > gc_heap.root_stack_size) {
-        gc_heap.root_stack_size = 0;
+    GCRootStack* rs = gc_current_roots();
+    if (n > rs->size) {
+        rs->size = 0;
     } else {
-        gc_heap.root_stack_size -= n;
+        rs->size -= n;
+    }
+    pthread_mutex_unlock(&gc_heap.lock);
+}
+
+size_t chris_gc_root_depth(void) {
+    // Only this thread changes its own stack size, so no lock is needed
+    if (!gc_thread_roots || gc_thread_roots_gen != gc_heap.generation) return 0;
+    return gc_thread_roots->size;
+}
+
+void chris_gc_restore_roots(size_t depth) {
+    pthread_mutex_lock(&gc_heap.lock);
+    GCRootStack* rs = gc_current_roots();
+    if (depth < rs->size) {
+        rs->size = depth;
     }
     pthread_mutex_unlock(&gc_heap.lock);
 }
@@ -330,3 +497,15 @@ size_t chris_gc_object_count(void) {
 size_t chris_gc_total_collections(void) {
     return gc_heap.total_collections;
 }
+
+size_t chris_gc_total_allocations(void) {
+    return gc_heap.total_allocations;
+}
+
+size_t chris_gc_total_allocated_bytes(void) {
+    return gc_heap.total_bytes;
+}
+
+chris_gc_phase chris_gc_current_phase(void) {
+    return (chris_gc_phase)gc_thread_phase;
+}
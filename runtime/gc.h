@@ -13,12 +13,13 @@ extern "C" {
 #define GC_OBJECT    1
 #define GC_ARRAY     2
 #define GC_CONTAINER 3
+#define GC_POLY_OBJECT 4 // object whose first slot is code: a vtable or a closure's function
 
 // Object header prepended to every GC-managed allocation
 typedef struct GCObject {
     struct GCObject* next;    // intrusive linked list of all GC objects
     uint8_t marked;           // mark bit
-    uint8_t type;             // GC_STRING, GC_OBJECT, GC_ARRAY, GC_CONTAINER
+    uint8_t type;             // GC_STRING, GC_OBJECT, GC_ARRAY, GC_CONTAINER, GC_POLY_OBJECT
     uint16_t num_pointers;    // number of pointer-typed fields (for mark traversal)
     uint32_t size;            // allocation size (excluding header)
     void (*finalizer)(void*); // optional finalizer (for containers with internal malloc'd state)
@@ -51,6 +52,13 @@ void chris_gc_set_num_pointers(void* ptr, uint16_t num_pointers);
 // Run a full mark-and-sweep collection.
 void chris_gc_collect(void);
 
+// Defer collections while other threads run compiled code. Threads are not
+// stopped for a collection, so values a worker holds only in registers could
+// be missed; while deferred the heap only grows. Calls nest; the last
+// chris_gc_defer_end re-enables.
+void chris_gc_defer_begin(void);
+void chris_gc_defer_end(void);
+
 // Shut down the GC, freeing all remaining objects. Called at program exit.
 void chris_gc_shutdown(void);
 
@@ -58,6 +66,9 @@ void chris_gc_shutdown(void);
 // Shadow Stack (root management)
 // ============================================================================
 
+// Each thread has its own shadow stack, created on its first push and
+// released when the thread exits. Collections scan the stacks of all threads.
+
 // Push a pointer-to-pointer as a GC root. The root points to a stack slot
 // that holds a GC-managed pointer. The GC will dereference it during marking.
 void chris_gc_push_root(void** root);
@@ -68,6 +79,13 @@ void chris_gc_pop_root(void);
 // Pop N roots at once (used at function return).
 void chris_gc_pop_roots(size_t n);
 
+// Current number of roots pushed by the calling thread. Recorded on entry to try blocks (and to
+// functions containing them) so unwinding can drop roots of skipped frames.
+size_t chris_gc_root_depth(void);
+
+// Truncate the shadow stack back to a depth from chris_gc_root_depth.
+void chris_gc_restore_roots(size_t depth);
+
 // ============================================================================
 // Statistics (for testing/debugging)
 // ============================================================================
@@ -75,6 +93,18 @@ void chris_gc_pop_roots(size_t n);
 size_t chris_gc_bytes_allocated(void);
 size_t chris_gc_object_count(void);
 size_t chris_gc_total_collections(void);
+// Cumulative since chris_gc_init (read by the benchmark harness)
+size_t chris_gc_total_allocations(void);
+size_t chris_gc_total_allocated_bytes(void);
+
+// Collection phase the calling thread is in (read by the sampling profiler)
+typedef enum {
+    CHRIS_GC_IDLE = 0,
+    CHRIS_GC_MARK,
+    CHRIS_GC_SWEEP,
+} chris_gc_phase;
+
+chris_gc_phase chris_gc_current_phase(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,245 @@
+#include "instrument.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// ============================================================================
+// Function Instrumentation
+// ============================================================================
+//
+// Each thread keeps its own counters and a stack of open frames, so hooks
+// take no locks. Timestamps are raw cycle counts (TSC / CNTVCT) and are
+// converted to milliseconds against the monotonic clock when reporting.
+// A function's total time is only added by its outermost activation, so
+// recursion is not double counted; self time excludes instrumented callees.
+
+typedef struct {
+    unsigned long long calls;
+    unsigned long long total;  // cycles, outermost activations only
+    unsigned long long self;   // cycles, excluding instrumented callees
+    long long active;          // open activations on this thread
+} chris_instrument_counter;
+
+typedef struct {
+    long long id;
+    uint64_t start;
+    uint64_t child;            // cycles spent in instrumented callees
+} chris_instrument_frame;
+
+typedef struct chris_instrument_thread {
+    chris_instrument_counter* counters;
+    long long count;
+    chris_instrument_frame* frames;
+    int depth;
+    int cap;
+    struct chris_instrument_thread* next;
+} chris_instrument_thread;
+
+static const char* const* chris_instrument_names = NULL;
+static long long chris_instrument_count = 0;
+static int chris_instrument_hooked = 0;    // SIGUSR1 and exit report installed
+static chris_instrument_thread* chris_instrument_threads = NULL;
+static pthread_mutex_t chris_instrument_mutex = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local chris_instrument_thread* chris_instrument_self = NULL;
+
+// Set by SIGUSR1; the next hook to run prints the report
+static volatile sig_atomic_t chris_instrument_dump_requested = 0;
+
+// Calibration point for converting cycles to wall time
+static uint64_t chris_instrument_start_cycles = 0;
+static uint64_t chris_instrument_start_ns = 0;
+
+static inline uint64_t chris_instrument_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint64_t chris_instrument_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void chris_instrument_on_signal(int sig) {
+    (void)sig;
+    chris_instrument_dump_requested = 1;
+}
+
+static void chris_instrument_atexit(void) {
+    chris_instrument_report(stderr);
+}
+
+void chris_instrument_register(const char* const* names, long long count) {
+    pthread_mutex_lock(&chris_instrument_mutex);
+    int first = !chris_instrument_hooked;
+    chris_instrument_hooked = 1;
+    chris_instrument_names = names;
+    chris_instrument_count = count;
+    // Re-registering starts over; no hooks may be running
+    for (chris_instrument_thread* t = chris_instrument_threads; t; t = t->next) {
+        free(t->counters);
+        t->counters = (chris_instrument_counter*)calloc((size_t)count, sizeof(chris_instrument_counter));
+        t->count = t->counters ? count : 0;
+        t->depth = 0;
+    }
+    chris_instrument_start_cycles = chris_instrument_cycles();
+    chris_instrument_start_ns = chris_instrument_ns();
+    pthread_mutex_unlock(&chris_instrument_mutex);
+
+    if (first) {
+        signal(SIGUSR1, chris_instrument_on_signal);
+        atexit(chris_instrument_atexit);
+    }
+}
+
+void chris_instrument_finish(void) {
+    // After the program's own output, as at exit
+    fflush(stdout);
+    chris_instrument_report(stderr);
+    pthread_mutex_lock(&chris_instrument_mutex);
+    chris_instrument_names = NULL;
+    chris_instrument_count = 0;
+    for (chris_instrument_thread* t = chris_instrument_threads; t; t = t->next) {
+        t->count = 0;
+        t->depth = 0;
+    }
+    pthread_mutex_unlock(&chris_instrument_mutex);
+}
+
+static chris_instrument_thread* chris_instrument_thread_init(void) {
+    chris_instrument_thread* t =
+        (chris_instrument_thread*)calloc(1, sizeof(chris_instrument_thread));
+    if (!t) return NULL;
+    t->count = chris_instrument_count;
+    t->counters = (chris_instrument_counter*)calloc((size_t)t->count,
+                                                    sizeof(chris_instrument_counter));
+    t->cap = 64;
+    t->frames = (chris_instrument_frame*)malloc((size_t)t->cap * sizeof(chris_instrument_frame));
+    if (!t->counters || !t->frames) {
+        free(t->counters);
+        free(t->frames);
+        free(t);
+        return NULL;
+    }
+    // Counters outlive the thread so the exit report still sees them
+    pthread_mutex_lock(&chris_instrument_mutex);
+    t->next = chris_instrument_threads;
+    chris_instrument_threads = t;
+    pthread_mutex_unlock(&chris_instrument_mutex);
+    chris_instrument_self = t;
+    return t;
+}
+
+long long chris_instrument_enter(long long id) {
+    if (chris_instrument_dump_requested) {
+        chris_instrument_dump_requested = 0;
+        chris_instrument_report(stderr);
+    }
+    chris_instrument_thread* t = chris_instrument_self;
+    if (!t && !(t = chris_instrument_thread_init())) return -1;
+    if (id < 0 || id >= t->count) return -1;
+
+    if (t->depth == t->cap) {
+        chris_instrument_frame* grown = (chris_instrument_frame*)realloc(
+            t->frames, (size_t)t->cap * 2 * sizeof(chris_instrument_frame));
+        if (!grown) return -1;
+        t->frames = grown;
+        t->cap *= 2;
+    }
+    t->counters[id].active++;
+    chris_instrument_frame* frame = &t->frames[t->depth];
+    frame->id = id;
+    frame->child = 0;
+    frame->start = chris_instrument_cycles();
+    return t->depth++;
+}
+
+void chris_instrument_exit(long long depth) {
+    uint64_t now = chris_instrument_cycles();
+    chris_instrument_thread* t = chris_instrument_self;
+    if (!t) return;
+    // An enter that opened no frame must not pop the caller's
+    if (depth < 0) return;
+
+    while (t->depth > depth) {
+        chris_instrument_frame* frame = &t->frames[--t->depth];
+        uint64_t elapsed = now - frame->start;
+        chris_instrument_counter* counter = &t->counters[frame->id];
+        counter->calls++;
+        counter->self += elapsed > frame->child ? elapsed - frame->child : 0;
+        if (--counter->active == 0) counter->total += elapsed;
+        if (t->depth > 0) t->frames[t->depth - 1].child += elapsed;
+    }
+}
+
+typedef struct {
+    long long id;
+    chris_instrument_counter sum;
+} chris_instrument_row;
+
+static int chris_instrument_by_self(const void* a, const void* b) {
+    const chris_instrument_row* x = (const chris_instrument_row*)a;
+    const chris_instrument_row* y = (const chris_instrument_row*)b;
+    if (x->sum.self != y->sum.self) return x->sum.self < y->sum.self ? 1 : -1;
+    return x->id < y->id ? -1 : x->id > y->id;
+}
+
+int chris_instrument_report(FILE* out) {
+    pthread_mutex_lock(&chris_instrument_mutex);
+    long long count = chris_instrument_count;
+    chris_instrument_row* rows =
+        count > 0 ? (chris_instrument_row*)calloc((size_t)count, sizeof(chris_instrument_row)) : NULL;
+    if (!rows) {
+        pthread_mutex_unlock(&chris_instrument_mutex);
+        return 0;
+    }
+    for (long long i = 0; i < count; i++) rows[i].id = i;
+    // Other threads may still be running; their counters are read as-is
+    for (chris_instrument_thread* t = chris_instrument_threads; t; t = t->next) {
+        for (long long i = 0; i < count && i < t->count; i++) {
+            rows[i].sum.calls += t->counters[i].calls;
+            rows[i].sum.total += t->counters[i].total;
+            rows[i].sum.self += t->counters[i].self;
+        }
+    }
+    const char* const* names = chris_instrument_names;
+    uint64_t cycles = chris_instrument_cycles() - chris_instrument_start_cycles;
+    uint64_t ns = chris_instrument_ns() - chris_instrument_start_ns;
+    pthread_mutex_unlock(&chris_instrument_mutex);
+
+    qsort(rows, (size_t)count, sizeof(chris_instrument_row), chris_instrument_by_self);
+    double ms_per_cycle = cycles ? (double)ns / (double)cycles / 1e6 : 0.0;
+    unsigned long long all_self = 0;
+    for (long long i = 0; i < count; i++) all_self += rows[i].sum.self;
+
+    fprintf(out, "\nFunction profile (sorted by self time)\n");
+    fprintf(out, "%12s %12s %12s %7s  %s\n", "calls", "total ms", "self ms", "self %", "function");
+    int listed = 0;
+    for (long long i = 0; i < count; i++) {
+        const chris_instrument_counter* c = &rows[i].sum;
+        if (c->calls == 0) continue;
+        fprintf(out, "%12llu %12.3f %12.3f %6.1f%%  %s\n", c->calls,
+                (double)c->total * ms_per_cycle, (double)c->self * ms_per_cycle,
+                all_self ? 100.0 * (double)c->self / (double)all_self : 0.0, names[rows[i].id]);
+        listed++;
+    }
+    fflush(out);
+    free(rows);
+    return listed;
+}
@@ -0,0 +1,43 @@
+#ifndef CHRIS_INSTRUMENT_H
+#define CHRIS_INSTRUMENT_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Function Instrumentation
+// ============================================================================
+
+// Functions compiled with `chris build --instrument=functions` (or marked
+// @Instrument) call these hooks on entry and before every return. Counters
+// are per thread; the report merges them, sorted by self time, and is
+// printed to stderr at exit and whenever the process receives SIGUSR1.
+
+// Register the names of instrumented functions; hook ids index this table.
+// Called from main() before any hook runs.
+void chris_instrument_register(const char* const* names, long long count);
+
+// Print the report now and forget the names table, so the exit report has
+// nothing left to read. `chris run` calls this before it unmaps the JIT'd
+// program that owns the table.
+void chris_instrument_finish(void);
+
+// Open a frame for function `id`. Returns the depth below it, which the
+// matching exit hook passes back, or -1 when no frame was opened.
+long long chris_instrument_enter(long long id);
+
+// Close the frames down to `depth`: the caller's own, and first any above
+// it that an exception unwound past.
+void chris_instrument_exit(long long depth);
+
+// Write the merged report. Returns the number of functions listed.
+int chris_instrument_report(FILE* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHRIS_INSTRUMENT_H
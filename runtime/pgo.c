@@ -0,0 +1,209 @@
+#include "pgo.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// ============================================================================
+// Raw Profile Writer
+// ============================================================================
+//
+// The instrumentation pass gives every function a record in __llvm_prf_data,
+// its edge counters in __llvm_prf_cnts and its name in __llvm_prf_names. A
+// .profraw file is a header followed by those three sections, each padded to
+// 8 bytes, then the value-profile records. The field lists come from LLVM's
+// InstrProfData.inc, the file the pass itself is built from, so the layout
+// follows the raw format version of the LLVM the compiler links against.
+
+// Format constants and section names
+#include "llvm/ProfileData/InstrProfData.inc"
+
+enum chris_pgo_value_kind {
+#define VALUE_PROF_KIND(Enumerator, Value, Descr) Enumerator = Value,
+#include "llvm/ProfileData/InstrProfData.inc"
+};
+
+typedef void* IntPtrT;
+
+typedef struct __attribute__((aligned(INSTR_PROF_DATA_ALIGNMENT))) {
+#define INSTR_PROF_DATA(Type, LLVMType, Name, Initializer) Type Name;
+#include "llvm/ProfileData/InstrProfData.inc"
+} chris_pgo_data;
+
+typedef struct {
+#define INSTR_PROF_RAW_HEADER(Type, Name, Initializer) Type Name;
+#include "llvm/ProfileData/InstrProfData.inc"
+} chris_pgo_header;
+
+// Section bounds, defined by the linker when instrumented code is linked in
+#if defined(__APPLE__)
+extern const chris_pgo_data chris_pgo_data_begin[] __asm("section$start$__DATA$" INSTR_PROF_DATA_SECT_NAME);
+extern const chris_pgo_data chris_pgo_data_end[] __asm("section$end$__DATA$" INSTR_PROF_DATA_SECT_NAME);
+extern const char chris_pgo_counters_begin[] __asm("section$start$__DATA$" INSTR_PROF_CNTS_SECT_NAME);
+extern const char chris_pgo_counters_end[] __asm("section$end$__DATA$" INSTR_PROF_CNTS_SECT_NAME);
+extern const char chris_pgo_names_begin[] __asm("section$start$__DATA$" INSTR_PROF_NAME_SECT_NAME);
+extern const char chris_pgo_names_end[] __asm("section$end$__DATA$" INSTR_PROF_NAME_SECT_NAME);
+#else
+#define CHRIS_PGO_BOUND __attribute__((weak, visibility("hidden")))
+extern const chris_pgo_data chris_pgo_data_begin[] __asm("__start___llvm_prf_data") CHRIS_PGO_BOUND;
+extern const chris_pgo_data chris_pgo_data_end[] __asm("__stop___llvm_prf_data") CHRIS_PGO_BOUND;
+extern const char chris_pgo_counters_begin[] __asm("__start___llvm_prf_cnts") CHRIS_PGO_BOUND;
+extern const char chris_pgo_counters_end[] __asm("__stop___llvm_prf_cnts") CHRIS_PGO_BOUND;
+extern const char chris_pgo_names_begin[] __asm("__start___llvm_prf_names") CHRIS_PGO_BOUND;
+extern const char chris_pgo_names_end[] __asm("__stop___llvm_prf_names") CHRIS_PGO_BOUND;
+#endif
+
+// Raw version and variant flags, emitted into the instrumented module
+extern const uint64_t INSTR_PROF_RAW_VERSION_VAR __attribute__((weak, visibility("hidden")));
+
+// Referenced by the runtime hook some targets emit into instrumented code
+int INSTR_PROF_PROFILE_RUNTIME_VAR;
+
+// Value profiling hooks. Indirect call targets and memop sizes are not
+// recorded; the profile lists no values for their sites.
+void __llvm_profile_instrument_target(uint64_t TargetValue, void* Data, uint32_t CounterIndex) {
+    (void)TargetValue;
+    (void)Data;
+    (void)CounterIndex;
+}
+
+void __llvm_profile_instrument_memop(uint64_t TargetValue, void* Data, uint32_t CounterIndex) {
+    (void)TargetValue;
+    (void)Data;
+    (void)CounterIndex;
+}
+
+static const char* chris_pgo_path = NULL;
+
+static void chris_pgo_atexit(void) {
+    const char* env = getenv("LLVM_PROFILE_FILE");
+    chris_pgo_write(env && *env ? env : chris_pgo_path);
+}
+
+void chris_pgo_register(const char* path) {
+    int first = chris_pgo_path == NULL;
+    chris_pgo_path = path;
+    if (first) atexit(chris_pgo_atexit);
+}
+
+static uint64_t chris_pgo_padding(uint64_t size) {
+    return (8 - size % 8) % 8;
+}
+
+static int chris_pgo_write_zeros(FILE* out, uint64_t count) {
+    static const char zeros[8] = {0};
+    while (count > 0) {
+        size_t chunk = count < sizeof(zeros) ? (size_t)count : sizeof(zeros);
+        if (fwrite(zeros, 1, chunk, out) != chunk) return 0;
+        count -= chunk;
+    }
+    return 1;
+}
+
+// Every record with value sites is followed by a ValueProfData entry: its
+// total size and kind count, then per kind the site count and one (zero)
+// value count per site, padded to 8 bytes
+static int chris_pgo_write_values(FILE* out, const chris_pgo_data* begin,
+                                  const chris_pgo_data* end) {
+    for (const chris_pgo_data* data = begin; data < end; data++) {
+        uint32_t kinds = 0;
+        uint32_t total = 2 * sizeof(uint32_t);
+        for (int kind = IPVK_First; kind <= IPVK_Last; kind++) {
+            uint32_t sites = data->NumValueSites[kind];
+            if (sites == 0) continue;
+            kinds++;
+            total += 2 * sizeof(uint32_t) + sites + (uint32_t)chris_pgo_padding(sites);
+        }
+        if (kinds == 0) continue;
+        if (fwrite(&total, sizeof(total), 1, out) != 1) return 0;
+        if (fwrite(&kinds, sizeof(kinds), 1, out) != 1) return 0;
+        for (uint32_t kind = IPVK_First; kind <= IPVK_Last; kind++) {
+            uint32_t sites = data->NumValueSites[kind];
+            if (sites == 0) continue;
+            if (fwrite(&kind, sizeof(kind), 1, out) != 1) return 0;
+            if (fwrite(&sites, sizeof(sites), 1, out) != 1) return 0;
+            if (!chris_pgo_write_zeros(out, sites + chris_pgo_padding(sites))) return 0;
+        }
+    }
+    return 1;
+}
+
+// Copy `pattern` into `out`, replacing "%p" with the process id
+static void chris_pgo_expand(const char* pattern, char* out, size_t size) {
+    size_t n = 0;
+    for (const char* p = pattern; *p && n + 1 < size; p++) {
+        if (p[0] == '%' && p[1] == 'p') {
+            int written = snprintf(out + n, size - n, "%ld", (long)getpid());
+            if (written > 0) n += (size_t)written < size - n ? (size_t)written : size - n - 1;
+            p++;
+        } else {
+            out[n++] = *p;
+        }
+    }
+    out[n] = '\0';
+}
+
+long long chris_pgo_write(const char* path) {
+    const chris_pgo_data* DataBegin = chris_pgo_data_begin;
+    const char* CountersBegin = chris_pgo_counters_begin;
+    const char* NamesBegin = chris_pgo_names_begin;
+    if (!path || !DataBegin || chris_pgo_data_end <= DataBegin) return 0;
+
+    uint64_t NumData = (uint64_t)(chris_pgo_data_end - DataBegin);
+    uint64_t NumCounters = (uint64_t)(chris_pgo_counters_end - CountersBegin) / sizeof(uint64_t);
+    uint64_t NamesSize = (uint64_t)(chris_pgo_names_end - NamesBegin);
+    uint64_t PaddingBytesBeforeCounters = 0;
+    uint64_t PaddingBytesAfterCounters = chris_pgo_padding(NumCounters * sizeof(uint64_t));
+    // Names the header's initialisers use in other raw versions. IR PGO
+    // emits no MC/DC bitmaps or vtable names, so those sections are empty.
+    uint64_t DataSize = NumData;
+    uint64_t CountersSize = NumCounters;
+    uint64_t NumBitmapBytes = 0;
+    uint64_t PaddingBytesAfterBitmapBytes = 0;
+    const char* BitmapBegin = (const char*)DataBegin;
+    uint64_t NumVTables = 0;
+    uint64_t VNamesSize = 0;
+    (void)DataSize;
+    (void)CountersSize;
+    (void)NumBitmapBytes;
+    (void)PaddingBytesAfterBitmapBytes;
+    (void)BitmapBegin;
+    (void)NumVTables;
+    (void)VNamesSize;
+
+    uint64_t version = &INSTR_PROF_RAW_VERSION_VAR ? INSTR_PROF_RAW_VERSION_VAR
+                                                   : INSTR_PROF_RAW_VERSION;
+    chris_pgo_header header;
+    memset(&header, 0, sizeof(header));
+#define __llvm_profile_get_magic() (INSTR_PROF_RAW_MAGIC_64)
+#define __llvm_profile_get_version() (version)
+#define __llvm_write_binary_ids(Writer) 0
+#define INSTR_PROF_RAW_HEADER(Type, Name, Initializer) header.Name = Initializer;
+#include "llvm/ProfileData/InstrProfData.inc"
+#undef __llvm_profile_get_magic
+#undef __llvm_profile_get_version
+#undef __llvm_write_binary_ids
+
+    char expanded[4096];
+    chris_pgo_expand(path, expanded, sizeof(expanded));
+    FILE* out = fopen(expanded, "wb");
+    if (!out) {
+        fprintf(stderr, "warning: could not write profile %s\n", expanded);
+        return -1;
+    }
+    int ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+             fwrite(DataBegin, sizeof(chris_pgo_data), (size_t)NumData, out) == NumData &&
+             chris_pgo_write_zeros(out, PaddingBytesBeforeCounters) &&
+             fwrite(CountersBegin, sizeof(uint64_t), (size_t)NumCounters, out) == NumCounters &&
+             chris_pgo_write_zeros(out, PaddingBytesAfterCounters) &&
+             fwrite(NamesBegin, 1, (size_t)NamesSize, out) == NamesSize &&
+             chris_pgo_write_zeros(out, chris_pgo_padding(NamesSize)) &&
+             chris_pgo_write_values(out, DataBegin, chris_pgo_data_end);
+    if (fclose(out) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "warning: could not write profile %s\n", expanded);
+        return -1;
+    }
+    return (long long)NumData;
+}
@@ -0,0 +1,30 @@
+#ifndef CHRIS_PGO_H
+#define CHRIS_PGO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Profile-Guided Optimisation
+// ============================================================================
+
+// Programs built with `chris build --profile-generate` carry LLVM's IR-level
+// PGO counters. main() registers the output path and the counters are
+// written as a .profraw file at exit, ready for `llvm-profdata merge`. The
+// LLVM_PROFILE_FILE environment variable overrides the path; "%p" in either
+// expands to the process id, so repeated runs leave separate files to merge.
+
+// Called from main() before any instrumented code runs.
+void chris_pgo_register(const char* path);
+
+// Write the counters to `path` ("%p" expanded). Returns the number of
+// function records written, 0 if the program carries no counters (no file
+// is created), or -1 if the file could not be written.
+long long chris_pgo_write(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHRIS_PGO_H
@@ -0,0 +1,313 @@
+// ucontext register names and pthread_getattr_np
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include "profile.h"
+#include "gc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+// ============================================================================
+// Sampling Profiler
+// ============================================================================
+//
+// A process-wide ITIMER_PROF timer raises SIGPROF on whichever thread is
+// burning CPU. The handler walks the interrupted thread's frame-pointer chain
+// into a preallocated sample buffer; it never allocates, locks or
+// symbolises. chris_profile_stop (run at exit) resolves the raw addresses
+// through the stack-trace table and writes aggregated folded stacks.
+//
+// Compiled code keeps frame pointers when built with -g, -gline-tables-only
+// or `chris run --profile`; the runtime is always built with them.
+
+#define CHRIS_PROFILE_DEFAULT_HZ 997   // prime, so sampling doesn't lock step with periodic work
+#define CHRIS_PROFILE_MAX_DEPTH  64
+#define CHRIS_PROFILE_MAX_SAMPLES 65536
+
+typedef struct {
+    volatile int ready;        // set last, once frames are written
+    int phase;                 // chris_gc_phase of the sampled thread
+    int depth;
+    void* frames[CHRIS_PROFILE_MAX_DEPTH]; // leaf first
+} chris_profile_sample;
+
+typedef struct {
+    chris_profile_sample* samples; // null once stop has taken the buffer
+    volatile long next;        // slots handed out (may exceed capacity)
+    volatile int in_handler;   // handlers that may still write a sample
+    char* path;
+    struct sigaction previous;
+    int running;
+} chris_profile_state;
+
+static chris_profile_state chris_profiler = {0};
+
+// Bounds of the current thread's stack; a walk never reads outside them
+static _Thread_local uintptr_t chris_profile_stack_lo = 0;
+static _Thread_local uintptr_t chris_profile_stack_hi = 0;
+
+void chris_profile_register_thread(void) {
+    if (!chris_profiler.running || chris_profile_stack_hi) return;
+#if defined(__APPLE__)
+    pthread_t self = pthread_self();
+    uintptr_t hi = (uintptr_t)pthread_get_stackaddr_np(self);
+    chris_profile_stack_lo = hi - pthread_get_stacksize_np(self);
+    chris_profile_stack_hi = hi;
+#elif defined(__linux__)
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return;
+    void* addr = NULL;
+    size_t size = 0;
+    if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+        chris_profile_stack_lo = (uintptr_t)addr;
+        chris_profile_stack_hi = (uintptr_t)addr + size;
+    }
+    pthread_attr_destroy(&attr);
+#endif
+}
+
+// Program counter, frame pointer and stack pointer of the interrupted code
+static int chris_profile_registers(const ucontext_t* uc, uintptr_t* pc, uintptr_t* fp,
+                                   uintptr_t* sp) {
+#if defined(__linux__) && defined(__x86_64__)
+    *pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+    *fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+    *sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+#elif defined(__linux__) && defined(__aarch64__)
+    *pc = (uintptr_t)uc->uc_mcontext.pc;
+    *fp = (uintptr_t)uc->uc_mcontext.regs[29];
+    *sp = (uintptr_t)uc->uc_mcontext.sp;
+#elif defined(__APPLE__) && defined(__aarch64__)
+    *pc = (uintptr_t)uc->uc_mcontext->__ss.__pc;
+    *fp = (uintptr_t)uc->uc_mcontext->__ss.__fp;
+    *sp = (uintptr_t)uc->uc_mcontext->__ss.__sp;
+#elif defined(__APPLE__) && defined(__x86_64__)
+    *pc = (uintptr_t)uc->uc_mcontext->__ss.__rip;
+    *fp = (uintptr_t)uc->uc_mcontext->__ss.__rbp;
+    *sp = (uintptr_t)uc->uc_mcontext->__ss.__rsp;
+#else
+    (void)uc; (void)pc; (void)fp; (void)sp;
+    return 0;
+#endif
+    return 1;
+}
+
+static void chris_profile_handler(int sig, siginfo_t* info, void* context) {
+    (void)sig;
+    (void)info;
+    int saved_errno = errno;
+
+    // Announce this handler before looking for the buffer: stop takes the
+    // buffer first and then waits for the count to drain, so a handler
+    // either sees no buffer or is waited for
+    __atomic_fetch_add(&chris_profiler.in_handler, 1, __ATOMIC_SEQ_CST);
+    chris_profile_sample* samples = __atomic_load_n(&chris_profiler.samples, __ATOMIC_SEQ_CST);
+    uintptr_t pc, fp, sp;
+    long slot = samples ? __atomic_fetch_add(&chris_profiler.next, 1, __ATOMIC_RELAXED) : 0;
+    if (!samples || slot >= CHRIS_PROFILE_MAX_SAMPLES ||
+        !chris_profile_registers((const ucontext_t*)context, &pc, &fp, &sp)) {
+        __atomic_fetch_sub(&chris_profiler.in_handler, 1, __ATOMIC_RELEASE);
+        errno = saved_errno;
+        return;
+    }
+
+    chris_profile_sample* sample = &samples[slot];
+    // Symbolisation steps back into the call instruction; undo that for the leaf
+    sample->frames[0] = (void*)(pc + 1);
+    int depth = 1;
+
+    // Each frame record is {saved fp, return address}; records only move up
+    // the stack, so a corrupt or absent chain ends the walk
+    uintptr_t lo = sp > chris_profile_stack_lo ? sp : chris_profile_stack_lo;
+    uintptr_t hi = chris_profile_stack_hi;
+    while (depth < CHRIS_PROFILE_MAX_DEPTH && fp >= lo && fp + 2 * sizeof(void*) <= hi &&
+           fp % sizeof(void*) == 0) {
+        uintptr_t* record = (uintptr_t*)fp;
+        if (!record[1]) break;
+        sample->frames[depth++] = (void*)record[1];
+        if (record[0] <= fp) break;
+        fp = record[0];
+    }
+
+    sample->depth = depth;
+    sample->phase = chris_gc_current_phase();
+    __atomic_store_n(&sample->ready, 1, __ATOMIC_RELEASE);
+    __atomic_fetch_sub(&chris_profiler.in_handler, 1, __ATOMIC_RELEASE);
+    errno = saved_errno;
+}
+
+static void chris_profile_release(void) {
+    free(chris_profiler.samples);
+    free(chris_profiler.path);
+    chris_profiler.samples = NULL;
+    chris_profiler.path = NULL;
+}
+
+int chris_profile_start(const char* path, int hz) {
+    if (chris_profiler.running || !path || !*path) return -1;
+    if (hz <= 0) hz = CHRIS_PROFILE_DEFAULT_HZ;
+
+    // calloc'd pages are only committed as samples reach them
+    chris_profiler.samples =
+        (chris_profile_sample*)calloc(CHRIS_PROFILE_MAX_SAMPLES, sizeof(chris_profile_sample));
+    chris_profiler.path = strdup(path);
+    if (!chris_profiler.samples || !chris_profiler.path) {
+        chris_profile_release();
+        return -1;
+    }
+    chris_profiler.next = 0;
+    chris_profiler.running = 1;
+    chris_profile_register_thread();
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = chris_profile_handler;
+    // Restart interrupted syscalls so sampling is invisible to blocking I/O
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &chris_profiler.previous);
+
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = 1000000 / hz;
+    if (timer.it_interval.tv_usec == 0) timer.it_interval.tv_usec = 1;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+        sigaction(SIGPROF, &chris_profiler.previous, NULL);
+        chris_profiler.running = 0;
+        chris_profile_release();
+        return -1;
+    }
+    return 0;
+}
+
+static const char chris_profile_native[] = "[native]";
+
+// Render a sample as "root;...;leaf". Runs of runtime/libc frames collapse
+// into one [native] frame (the thread-start frames below the first compiled
+// function are dropped), and samples taken during a collection end in the
+// GC phase rather than the collector's own frames.
+static size_t chris_profile_fold(const chris_profile_sample* sample, char* buf, size_t cap) {
+    const char* names[CHRIS_PROFILE_MAX_DEPTH + 1];
+    int count = 0;
+    for (int i = sample->depth - 1; i >= 0; i--) {
+        const char* name = chris_trace_signature(sample->frames[i]);
+        if (!name) {
+            if (count > 0 && names[count - 1] == chris_profile_native) continue;
+            name = chris_profile_native;
+        }
+        names[count++] = name;
+    }
+
+    int first = 0;
+    if (count > 1 && names[0] == chris_profile_native) first = 1;
+
+    const char* phase = NULL;
+    if (sample->phase == CHRIS_GC_MARK) phase = "[gc mark]";
+    else if (sample->phase == CHRIS_GC_SWEEP) phase = "[gc sweep]";
+    if (phase) {
+        if (count > first && names[count - 1] == chris_profile_native) count--;
+        names[count++] = phase;
+    }
+
+    size_t len = 0;
+    for (int i = first; i < count; i++) {
+        size_t n = strlen(names[i]);
+        if (len + n + 2 > cap) break;
+        if (len) buf[len++] = ';';
+        memcpy(buf + len, names[i], n);
+        len += n;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+static int chris_profile_compare(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+long long chris_profile_stop(void) {
+    if (!chris_profiler.running) return -1;
+
+    struct itimerval off;
+    memset(&off, 0, sizeof(off));
+    setitimer(ITIMER_PROF, &off, NULL);
+    // A SIGPROF the timer raised may still be pending; under the default
+    // action it would kill the process
+    struct sigaction restore = chris_profiler.previous;
+    if (!(restore.sa_flags & SA_SIGINFO) && restore.sa_handler == SIG_DFL) {
+        restore.sa_handler = SIG_IGN;
+    }
+    sigaction(SIGPROF, &restore, NULL);
+    chris_profiler.running = 0;
+
+    // A handler delivered before the timer stopped may still be walking a
+    // stack on another thread; take the buffer away and let it finish
+    chris_profile_sample* samples =
+        __atomic_exchange_n(&chris_profiler.samples, NULL, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&chris_profiler.in_handler, __ATOMIC_ACQUIRE) > 0) {
+        sched_yield();
+    }
+
+    long taken = __atomic_load_n(&chris_profiler.next, __ATOMIC_ACQUIRE);
+    long count = taken < CHRIS_PROFILE_MAX_SAMPLES ? taken : CHRIS_PROFILE_MAX_SAMPLES;
+
+    char** lines = (char**)calloc(count > 0 ? (size_t)count : 1, sizeof(char*));
+    long folded = 0;
+    char buf[4096];
+    for (long i = 0; lines && i < count; i++) {
+        const chris_profile_sample* sample = &samples[i];
+        if (!__atomic_load_n(&sample->ready, __ATOMIC_ACQUIRE)) continue;
+        if (chris_profile_fold(sample, buf, sizeof(buf)) == 0) continue;
+        lines[folded] = strdup(buf);
+        if (lines[folded]) folded++;
+    }
+    qsort(lines, (size_t)folded, sizeof(char*), chris_profile_compare);
+
+    long long written = -1;
+    FILE* out = fopen(chris_profiler.path, "w");
+    if (out) {
+        written = 0;
+        for (long i = 0; i < folded;) {
+            long j = i + 1;
+            while (j < folded && strcmp(lines[i], lines[j]) == 0) j++;
+            fprintf(out, "%s %ld\n", lines[i], j - i);
+            written += j - i;
+            i = j;
+        }
+        fclose(out);
+    } else {
+        fprintf(stderr, "profile: cannot write %s: %s\n", chris_profiler.path, strerror(errno));
+    }
+    if (taken > CHRIS_PROFILE_MAX_SAMPLES) {
+        fprintf(stderr, "profile: buffer full, dropped %ld samples\n",
+                taken - CHRIS_PROFILE_MAX_SAMPLES);
+    }
+
+    for (long i = 0; i < folded; i++) free(lines[i]);
+    free(lines);
+    free(samples);
+    chris_profile_release();
+    return written;
+}
+
+static void chris_profile_atexit(void) {
+    chris_profile_stop();
+}
+
+void chris_profile_autostart(void) {
+    const char* path = getenv("CHRIS_PROFILE");
+    if (!path || !*path) return;
+    const char* hz = getenv("CHRIS_PROFILE_HZ");
+    if (chris_profile_start(path, hz ? atoi(hz) : 0) == 0) {
+        atexit(chris_profile_atexit);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef CHRIS_PROFILE_H
+#define CHRIS_PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Sampling Profiler
+// ============================================================================
+
+// Setting CHRIS_PROFILE=<path> starts the profiler as a compiled program's
+// main() begins and writes folded stacks ("main;render;blend 42" per line,
+// the input format of flamegraph.pl and speedscope) to <path> at exit.
+// CHRIS_PROFILE_HZ overrides the default sampling rate.
+
+// Start the profiler if CHRIS_PROFILE is set. Called first thing by compiled
+// main(), so the compiler and other programs linking the runtime are never
+// sampled themselves.
+void chris_profile_autostart(void);
+
+// Arm a SIGPROF timer sampling at `hz` (0 = default) and record the calling
+// thread's stack bounds. Returns 0 on success, -1 if already running or the
+// timer could not be armed.
+int chris_profile_start(const char* path, int hz);
+
+// Disarm the timer and write the folded stacks. Returns the number of
+// samples written, or -1 if the profiler was not running or the output
+// could not be opened.
+long long chris_profile_stop(void);
+
+// Record the calling thread's stack bounds so its samples can be walked
+// past the leaf frame. Called by the runtime at the start of every thread
+// it creates; a no-op when the profiler is off.
+void chris_profile_register_thread(void);
+
+// Source signature of the compiled function containing `returnAddress`, or
+// NULL for runtime and libc code. Defined with the stack-trace table.
+const char* chris_trace_signature(void* returnAddress);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHRIS_PROFILE_H
@@ -1,55 +1,683 @@
+// dl_iterate_phdr
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <setjmp.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unwind.h>
 #include <ctype.h>
 #include <math.h>
 #include <time.h>
 #include <pthread.h>
 #include "gc.h"
+#include "profile.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <elf.h>
+#include <link.h>
+#endif
+
+// ============================================================================
+// Exception Handling Support
+// ============================================================================
+//
+// Exceptions use the Itanium C++ ABI's two-phase table-based unwinder.
+// Compiled code calls functions inside `try` blocks with `invoke`; entering
+// a try costs nothing beyond recording the GC shadow-stack depth.
+// chris_throw raises through _Unwind_RaiseException, and chris_personality
+// reads each frame's LSDA (call-site table) to find a landing pad.
+
+// "CHRS\0\0\0\0" — identifies exceptions raised by chris_throw
+#define CHRIS_EXCEPTION_CLASS 0x4348525300000000ULL
+
+// Throw sites record only raw return addresses; e.stackTrace formats them.
+#define CHRIS_MAX_TRACE_FRAMES 32
+
+typedef struct {
+    const char* message;
+    const char* file;            // throw site (NULL when raised by the runtime)
+    long long line;
+    long long column;
+    int frame_count;
+    void* frames[CHRIS_MAX_TRACE_FRAMES];
+} chris_stack_trace;
+
+typedef struct {
+    chris_stack_trace trace;
+    struct _Unwind_Exception unwind;
+} chris_exception;
 
-// Exception handling support
-#define CHRIS_MAX_TRY_DEPTH 64
+#define CHRIS_EXC_FROM_UNWIND(ue) \
+    ((chris_exception*)((char*)(ue) - offsetof(chris_exception, unwind)))
 
-static jmp_buf chris_try_stack[CHRIS_MAX_TRY_DEPTH];
-static int chris_try_depth = 0;
-static const char* chris_exception_message = NULL;
+static void chris_exception_cleanup(_Unwind_Reason_Code reason, struct _Unwind_Exception* ue) {
+    (void)reason;
+    free(CHRIS_EXC_FROM_UNWIND(ue));
+}
+
+static _Unwind_Reason_Code chris_capture_frame(struct _Unwind_Context* context, void* arg) {
+    chris_stack_trace* trace = (chris_stack_trace*)arg;
+    if (trace->frame_count >= CHRIS_MAX_TRACE_FRAMES) return _URC_END_OF_STACK;
+    uintptr_t ip = _Unwind_GetIP(context);
+    if (ip) trace->frames[trace->frame_count++] = (void*)ip;
+    return _URC_NO_REASON;
+}
 
-int chris_try_begin(void) {
-    if (chris_try_depth >= CHRIS_MAX_TRY_DEPTH) {
-        fprintf(stderr, "Error: try nesting too deep\n");
+const char* chris_format_stack_trace(const chris_stack_trace* trace);
+
+// Throw with the source location of the `throw` statement
+void chris_throw_at(const char* message, const char* file, long long line, long long column) {
+    chris_exception* exc = (chris_exception*)calloc(1, sizeof(chris_exception));
+    if (!exc) {
+        fprintf(stderr, "Error: failed to allocate exception\n");
         exit(1);
     }
-    return chris_try_depth++;
-}
+    exc->trace.message = message;
+    exc->trace.file = file;
+    exc->trace.line = line;
+    exc->trace.column = column;
+    _Unwind_Backtrace(chris_capture_frame, &exc->trace);
+    exc->unwind.exception_class = CHRIS_EXCEPTION_CLASS;
+    exc->unwind.exception_cleanup = chris_exception_cleanup;
+    _Unwind_RaiseException(&exc->unwind);
 
-void chris_try_end(void) {
-    if (chris_try_depth > 0) chris_try_depth--;
+    // Only returns if no frame handles the exception
+    fprintf(stderr, "Unhandled %s", chris_format_stack_trace(&exc->trace));
+    exit(1);
 }
 
 void chris_throw(const char* message) {
-    chris_exception_message = message;
-    if (chris_try_depth > 0) {
-        chris_try_depth--;
-        longjmp(chris_try_stack[chris_try_depth], 1);
-    } else {
-        fprintf(stderr, "Unhandled exception: %s\n", message ? message : "(nil)");
-        exit(1);
+    chris_throw_at(message, NULL, 0, 0);
+}
+
+// Called at the top of a catch block with the landing pad's exception
+// pointer. Returns the message and releases the exception object. When
+// the catch block reads e.stackTrace, compiled code passes traceOut and
+// receives a GC-managed copy of the captured frames.
+const char* chris_begin_catch(void* unwindException, void** traceOut) {
+    struct _Unwind_Exception* ue = (struct _Unwind_Exception*)unwindException;
+    if (!ue) return NULL;
+    if (ue->exception_class != CHRIS_EXCEPTION_CLASS) {
+        _Unwind_DeleteException(ue);
+        if (traceOut) *traceOut = NULL;
+        return "foreign exception";
+    }
+    chris_stack_trace* trace = &CHRIS_EXC_FROM_UNWIND(ue)->trace;
+    if (traceOut) {
+        chris_stack_trace* copy = (chris_stack_trace*)chris_gc_alloc(sizeof(chris_stack_trace), GC_STRING);
+        memcpy(copy, trace, sizeof(chris_stack_trace));
+        *traceOut = copy;
+    }
+    const char* message = trace->message;
+    _Unwind_DeleteException(ue);
+    return message;
+}
+
+// --- Symbolisation ---
+//
+// Compiled programs register a side table mapping each function's address to
+// its source signature and declaration site. A captured return address is
+// resolved to its enclosing function through the unwinder's FDE lookup and
+// then matched against the table; runtime and libc frames have no entry and
+// are omitted.
+
+typedef struct {
+    void* fn;
+    const char* signature;
+    const char* file;
+    long long line;
+    long long column;
+} chris_trace_entry;
+
+static const chris_trace_entry* chris_trace_table = NULL;
+static long long chris_trace_count = 0;
+
+// Tables of separately compiled modules, added by their constructors
+typedef struct chris_trace_module {
+    const chris_trace_entry* table;
+    long long count;
+    struct chris_trace_module* next;
+} chris_trace_module;
+
+static chris_trace_module* chris_trace_modules = NULL;
+
+void chris_register_trace_table(const chris_trace_entry* table, long long count) {
+    chris_trace_table = table;
+    chris_trace_count = count;
+}
+
+void chris_add_trace_table(const chris_trace_entry* table, long long count) {
+    chris_trace_module* module = malloc(sizeof(chris_trace_module));
+    if (!module) return;
+    module->table = table;
+    module->count = count;
+    module->next = chris_trace_modules;
+    chris_trace_modules = module;
+}
+
+static const chris_trace_entry* chris_trace_find(const chris_trace_entry* table, long long count,
+                                                 void* fn) {
+    for (long long i = 0; i < count; i++) {
+        if (table[i].fn == fn) return &table[i];
+    }
+    return NULL;
+}
+
+static const chris_trace_entry* chris_trace_lookup(void* returnAddress) {
+    // Step back into the call instruction: a call to a noreturn function
+    // may be the last instruction of its caller
+    void* fn = _Unwind_FindEnclosingFunction((char*)returnAddress - 1);
+    if (!fn) return NULL;
+    const chris_trace_entry* entry = chris_trace_find(chris_trace_table, chris_trace_count, fn);
+    for (chris_trace_module* m = chris_trace_modules; m && !entry; m = m->next) {
+        entry = chris_trace_find(m->table, m->count, fn);
+    }
+    return entry;
+}
+
+const char* chris_trace_signature(void* returnAddress) {
+    const chris_trace_entry* entry = chris_trace_lookup(returnAddress);
+    return entry ? entry->signature : NULL;
+}
+
+// --- Line tables ---
+//
+// Frames other than the one that threw are reported at the call they were
+// making, found from their return address in the DWARF line table. The
+// executable's .debug_line is read the first time it is needed; the JIT adds
+// the rows of the code it loads through chris_add_line_table.
+
+typedef struct {
+    void* address;
+    long long line;    // 0 = no source line, -1 = end of a sequence
+    long long column;
+} chris_line_entry;
+
+typedef struct chris_line_table {
+    chris_line_entry* rows;     // sorted by address
+    long long count;
+    struct chris_line_table* next;
+} chris_line_table;
+
+static chris_line_table* chris_line_tables = NULL;
+static chris_line_table chris_exe_line_table = {NULL, 0, NULL};
+static pthread_once_t chris_exe_line_once = PTHREAD_ONCE_INIT;
+
+static int chris_line_entry_compare(const void* a, const void* b) {
+    const chris_line_entry* x = (const chris_line_entry*)a;
+    const chris_line_entry* y = (const chris_line_entry*)b;
+    if (x->address != y->address) return (uintptr_t)x->address < (uintptr_t)y->address ? -1 : 1;
+    // A sequence may start where the previous one ends
+    return (x->line != -1) - (y->line != -1);
+}
+
+static void chris_line_table_sort(chris_line_table* table) {
+    qsort(table->rows, (size_t)table->count, sizeof(chris_line_entry), chris_line_entry_compare);
+}
+
+void chris_add_line_table(const chris_line_entry* rows, long long count) {
+    chris_line_table* table = malloc(sizeof(chris_line_table));
+    if (!table) return;
+    table->rows = malloc((size_t)count * sizeof(chris_line_entry));
+    if (!table->rows) {
+        free(table);
+        return;
+    }
+    memcpy(table->rows, rows, (size_t)count * sizeof(chris_line_entry));
+    table->count = count;
+    chris_line_table_sort(table);
+    table->next = chris_line_tables;
+    chris_line_tables = table;
+}
+
+#ifdef __linux__
+static int chris_line_append(chris_line_table* table, long long* cap, uintptr_t address,
+                             long long line, long long column) {
+    if (table->count == *cap) {
+        long long grown = *cap ? *cap * 2 : 1024;
+        chris_line_entry* rows = realloc(table->rows, (size_t)grown * sizeof(chris_line_entry));
+        if (!rows) return 0;
+        table->rows = rows;
+        *cap = grown;
+    }
+    table->rows[table->count++] = (chris_line_entry){(void*)address, line, column};
+    return 1;
+}
+
+static unsigned long long chris_read_uleb(const unsigned char** p, const unsigned char* end) {
+    unsigned long long value = 0;
+    int shift = 0;
+    while (*p < end) {
+        unsigned char byte = *(*p)++;
+        if (shift < 64) value |= (unsigned long long)(byte & 0x7f) << shift;
+        shift += 7;
+        if (!(byte & 0x80)) break;
+    }
+    return value;
+}
+
+static long long chris_read_sleb(const unsigned char** p, const unsigned char* end) {
+    long long value = 0;
+    int shift = 0;
+    unsigned char byte = 0;
+    while (*p < end) {
+        byte = *(*p)++;
+        if (shift < 64) value |= (long long)(byte & 0x7f) << shift;
+        shift += 7;
+        if (!(byte & 0x80)) break;
+    }
+    if (shift < 64 && (byte & 0x40)) value |= -(1LL << shift);
+    return value;
+}
+
+static unsigned long long chris_read_fixed(const unsigned char** p, const unsigned char* end,
+                                           int size) {
+    unsigned long long value = 0;
+    if (end - *p < size) {
+        *p = end;
+        return 0;
+    }
+    for (int i = 0; i < size; i++) value |= (unsigned long long)(*p)[i] << (8 * i);
+    *p += size;
+    return value;
+}
+
+// Run the line-number programs of a .debug_line section (DWARF 2-5),
+// recording one row per emitted line and an end row per sequence
+static void chris_parse_debug_line(const unsigned char* p, const unsigned char* end,
+                                   uintptr_t bias, chris_line_table* table) {
+    long long cap = 0;
+    while (end - p >= 4) {
+        int offsetSize = 4;
+        unsigned long long length = chris_read_fixed(&p, end, 4);
+        if (length == 0xffffffffULL) {
+            offsetSize = 8;
+            length = chris_read_fixed(&p, end, 8);
+        }
+        if (length > (unsigned long long)(end - p)) return;
+        const unsigned char* unitEnd = p + length;
+        unsigned version = (unsigned)chris_read_fixed(&p, unitEnd, 2);
+        if (version < 2 || version > 5) {
+            p = unitEnd;
+            continue;
+        }
+        if (version >= 5) p += 2; // address_size, segment_selector_size
+        unsigned long long headerLength = chris_read_fixed(&p, unitEnd, offsetSize);
+        if (headerLength > (unsigned long long)(unitEnd - p)) return;
+        const unsigned char* program = p + headerLength;
+        unsigned minInstLength = *p++;
+        if (version >= 4) p++; // maximum_operations_per_instruction
+        p++;                   // default_is_stmt
+        int lineBase = (signed char)*p++;
+        unsigned lineRange = *p++;
+        unsigned opcodeBase = *p++;
+        const unsigned char* opcodeLengths = p;
+        if (lineRange == 0 || opcodeBase == 0) {
+            p = unitEnd;
+            continue;
+        }
+
+        p = program;
+        uintptr_t address = 0;
+        long long line = 1, column = 0;
+        while (p < unitEnd) {
+            unsigned opcode = *p++;
+            if (opcode >= opcodeBase) {
+                unsigned adjusted = opcode - opcodeBase;
+                address += (adjusted / lineRange) * minInstLength;
+                line += lineBase + (int)(adjusted % lineRange);
+                if (!chris_line_append(table, &cap, address + bias, line, column)) return;
+            } else if (opcode == 0) {
+                unsigned long long size = chris_read_uleb(&p, unitEnd);
+                if (size == 0 || size > (unsigned long long)(unitEnd - p)) break;
+                const unsigned char* next = p + size;
+                unsigned sub = *p++;
+                if (sub == 1) { // DW_LNE_end_sequence
+                    if (!chris_line_append(table, &cap, address + bias, -1, 0)) return;
+                    address = 0;
+                    line = 1;
+                    column = 0;
+                } else if (sub == 2) { // DW_LNE_set_address
+                    address = (uintptr_t)chris_read_fixed(&p, next, (int)(size - 1));
+                }
+                p = next;
+            } else if (opcode == 1) { // DW_LNS_copy
+                if (!chris_line_append(table, &cap, address + bias, line, column)) return;
+            } else if (opcode == 2) { // DW_LNS_advance_pc
+                address += chris_read_uleb(&p, unitEnd) * minInstLength;
+            } else if (opcode == 3) { // DW_LNS_advance_line
+                line += chris_read_sleb(&p, unitEnd);
+            } else if (opcode == 5) { // DW_LNS_set_column
+                column = (long long)chris_read_uleb(&p, unitEnd);
+            } else if (opcode == 8) { // DW_LNS_const_add_pc
+                address += ((255 - opcodeBase) / lineRange) * minInstLength;
+            } else if (opcode == 9) { // DW_LNS_fixed_advance_pc
+                address += chris_read_fixed(&p, unitEnd, 2);
+            } else {
+                for (unsigned i = 0; i < opcodeLengths[opcode - 1]; i++) {
+                    chris_read_uleb(&p, unitEnd);
+                }
+            }
+        }
+        p = unitEnd;
+    }
+}
+
+static int chris_exe_bias(struct dl_phdr_info* info, size_t size, void* data) {
+    (void)size;
+    *(uintptr_t*)data = (uintptr_t)info->dlpi_addr;
+    return 1; // the executable comes first
+}
+
+static void chris_load_exe_line_table(void) {
+    int fd = open("/proc/self/exe", O_RDONLY);
+    if (fd < 0) return;
+    Elf64_Ehdr header;
+    Elf64_Shdr* sections = NULL;
+    char* names = NULL;
+    unsigned char* lines = NULL;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 || header.e_ident[EI_CLASS] != ELFCLASS64 ||
+        header.e_shentsize != sizeof(Elf64_Shdr) || header.e_shstrndx >= header.e_shnum) {
+        goto done;
+    }
+    size_t sectionsSize = (size_t)header.e_shnum * sizeof(Elf64_Shdr);
+    sections = malloc(sectionsSize);
+    if (!sections || pread(fd, sections, sectionsSize, (off_t)header.e_shoff) != (ssize_t)sectionsSize) {
+        goto done;
+    }
+    const Elf64_Shdr* nameSection = &sections[header.e_shstrndx];
+    names = malloc(nameSection->sh_size + 1);
+    if (!names || pread(fd, names, nameSection->sh_size, (off_t)nameSection->sh_offset) !=
+                      (ssize_t)nameSection->sh_size) {
+        goto done;
+    }
+    names[nameSection->sh_size] = '\0';
+    for (int i = 0; i < header.e_shnum; i++) {
+        const Elf64_Shdr* section = &sections[i];
+        if (section->sh_name >= nameSection->sh_size) continue;
+        if (strcmp(names + section->sh_name, ".debug_line") != 0) continue;
+        if (section->sh_flags & SHF_COMPRESSED) break;
+        lines = malloc(section->sh_size);
+        if (!lines || pread(fd, lines, section->sh_size, (off_t)section->sh_offset) !=
+                          (ssize_t)section->sh_size) {
+            break;
+        }
+        uintptr_t bias = 0;
+        dl_iterate_phdr(chris_exe_bias, &bias);
+        chris_parse_debug_line(lines, lines + section->sh_size, bias, &chris_exe_line_table);
+        chris_line_table_sort(&chris_exe_line_table);
+        break;
+    }
+done:
+    free(lines);
+    free(names);
+    free(sections);
+    close(fd);
+}
+#else
+static void chris_load_exe_line_table(void) {}
+#endif
+
+// The row covering the call before returnAddress: the last one at or below it
+static const chris_line_entry* chris_line_find(const chris_line_table* table, uintptr_t pc) {
+    long long lo = 0, hi = table->count;
+    while (lo < hi) {
+        long long mid = lo + (hi - lo) / 2;
+        if ((uintptr_t)table->rows[mid].address <= pc) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0 || table->rows[lo - 1].line < 0) return NULL;
+    return &table->rows[lo - 1];
+}
+
+static const chris_line_entry* chris_line_lookup(void* returnAddress) {
+    uintptr_t pc = (uintptr_t)returnAddress - 1;
+    for (chris_line_table* table = chris_line_tables; table; table = table->next) {
+        const chris_line_entry* row = chris_line_find(table, pc);
+        if (row) return row;
+    }
+    pthread_once(&chris_exe_line_once, chris_load_exe_line_table);
+    return chris_line_find(&chris_exe_line_table, pc);
+}
+
+// Copy line `line` (1-based) of `file` into buf without the newline
+static int chris_read_source_line(const char* file, long long line, char* buf, size_t cap) {
+    FILE* f = fopen(file, "r");
+    if (!f) return 0;
+    long long current = 1;
+    int found = 0;
+    while (fgets(buf, (int)cap, f)) {
+        size_t len = strlen(buf);
+        int complete = len > 0 && buf[len - 1] == '\n';
+        if (current == line) {
+            if (complete) buf[len - 1] = '\0';
+            found = 1;
+            break;
+        }
+        if (complete) current++;
+    }
+    fclose(f);
+    return found;
+}
+
+const char* chris_format_stack_trace(const chris_stack_trace* trace) {
+    if (!trace) return "";
+    char* text = NULL;
+    size_t length = 0;
+    FILE* out = open_memstream(&text, &length);
+    if (!out) return trace->message ? trace->message : "";
+
+    fprintf(out, "Error: %s\n", trace->message ? trace->message : "(nil)");
+    int first = 1;
+    for (int i = 0; i < trace->frame_count; i++) {
+        const chris_trace_entry* entry = chris_trace_lookup(trace->frames[i]);
+        if (!entry) continue;
+        const char* file = entry->file;
+        long long line = entry->line;
+        long long column = entry->column;
+        // The innermost compiled frame is the one that threw; the others
+        // are at the call they were making
+        if (first && trace->file) {
+            file = trace->file;
+            line = trace->line;
+            column = trace->column;
+        } else {
+            const chris_line_entry* call = chris_line_lookup(trace->frames[i]);
+            if (call && call->line > 0) {
+                line = call->line;
+                column = call->column;
+            }
+        }
+        fprintf(out, "\n  at %s\n     %s:%lld:%lld\n", entry->signature, file, line, column);
+        char source[512];
+        if (chris_read_source_line(file, line, source, sizeof(source))) {
+            const char* code = source;
+            while (*code == ' ' || *code == '\t') code++;
+            fprintf(out, "     |  %s\n", code);
+        }
+        first = 0;
     }
+    fclose(out);
+
+    char* result = (char*)chris_gc_alloc(length + 1, GC_STRING);
+    memcpy(result, text, length);
+    result[length] = '\0';
+    free(text);
+    return result;
+}
+
+// --- LSDA parsing (DWARF pointer encodings) ---
+
+#define CHRIS_DW_EH_PE_omit    0xff
+#define CHRIS_DW_EH_PE_absptr  0x00
+#define CHRIS_DW_EH_PE_uleb128 0x01
+#define CHRIS_DW_EH_PE_udata2  0x02
+#define CHRIS_DW_EH_PE_udata4  0x03
+#define CHRIS_DW_EH_PE_udata8  0x04
+#define CHRIS_DW_EH_PE_sleb128 0x09
+#define CHRIS_DW_EH_PE_sdata2  0x0A
+#define CHRIS_DW_EH_PE_sdata4  0x0B
+#define CHRIS_DW_EH_PE_sdata8  0x0C
+#define CHRIS_DW_EH_PE_pcrel   0x10
+#define CHRIS_DW_EH_PE_indirect 0x80
+
+static uintptr_t chris_read_uleb128(const uint8_t** p) {
+    uintptr_t result = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+        byte = *(*p)++;
+        result |= (uintptr_t)(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return result;
 }
 
-const char* chris_get_exception(void) {
-    return chris_exception_message;
+static intptr_t chris_read_sleb128(const uint8_t** p) {
+    uintptr_t result = 0;
+    unsigned shift = 0;
+    uint8_t byte;
+    do {
+        byte = *(*p)++;
+        result |= (uintptr_t)(byte & 0x7f) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    if ((byte & 0x40) && shift < sizeof(result) * 8) {
+        result |= ~(uintptr_t)0 << shift;
+    }
+    return (intptr_t)result;
+}
+
+static size_t chris_encoded_size(uint8_t encoding) {
+    switch (encoding & 0x0f) {
+        case CHRIS_DW_EH_PE_absptr: return sizeof(uintptr_t);
+        case CHRIS_DW_EH_PE_udata2:
+        case CHRIS_DW_EH_PE_sdata2: return 2;
+        case CHRIS_DW_EH_PE_udata4:
+        case CHRIS_DW_EH_PE_sdata4: return 4;
+        case CHRIS_DW_EH_PE_udata8:
+        case CHRIS_DW_EH_PE_sdata8: return 8;
+        default: return 0;
+    }
+}
+
+static uintptr_t chris_read_encoded(const uint8_t** p, uint8_t encoding) {
+    const uint8_t* start = *p;
+    uintptr_t result;
+    if (encoding == CHRIS_DW_EH_PE_omit) return 0;
+    switch (encoding & 0x0f) {
+        case CHRIS_DW_EH_PE_absptr: memcpy(&result, *p, sizeof(result)); *p += sizeof(result); break;
+        case CHRIS_DW_EH_PE_uleb128: result = chris_read_uleb128(p); break;
+        case CHRIS_DW_EH_PE_sleb128: result = (uintptr_t)chris_read_sleb128(p); break;
+        case CHRIS_DW_EH_PE_udata2: { uint16_t v; memcpy(&v, *p, 2); *p += 2; result = v; break; }
+        case CHRIS_DW_EH_PE_udata4: { uint32_t v; memcpy(&v, *p, 4); *p += 4; result = v; break; }
+        case CHRIS_DW_EH_PE_udata8: { uint64_t v; memcpy(&v, *p, 8); *p += 8; result = (uintptr_t)v; break; }
+        case CHRIS_DW_EH_PE_sdata2: { int16_t v; memcpy(&v, *p, 2); *p += 2; result = (uintptr_t)(intptr_t)v; break; }
+        case CHRIS_DW_EH_PE_sdata4: { int32_t v; memcpy(&v, *p, 4); *p += 4; result = (uintptr_t)(intptr_t)v; break; }
+        case CHRIS_DW_EH_PE_sdata8: { int64_t v; memcpy(&v, *p, 8); *p += 8; result = (uintptr_t)v; break; }
+        default: abort();
+    }
+    if (result != 0) {
+        if ((encoding & 0x70) == CHRIS_DW_EH_PE_pcrel) result += (uintptr_t)start;
+        if (encoding & CHRIS_DW_EH_PE_indirect) result = *(uintptr_t*)result;
+    }
+    return result;
 }
 
-jmp_buf* chris_get_jmpbuf(int depth) {
-    return &chris_try_stack[depth];
+// Personality routine referenced by every compiled function that contains a
+// try block. Compiled code only emits catch-all clauses (null type info), so a
+// catch matches any chris exception; foreign exceptions pass through.
+_Unwind_Reason_Code chris_personality(int version, _Unwind_Action actions,
+                                      uint64_t exceptionClass,
+                                      struct _Unwind_Exception* ue,
+                                      struct _Unwind_Context* context) {
+    if (version != 1 || !ue || !context) return _URC_FATAL_PHASE1_ERROR;
+
+    const uint8_t* lsda = (const uint8_t*)_Unwind_GetLanguageSpecificData(context);
+    if (!lsda) return _URC_CONTINUE_UNWIND;
+
+    int ipBefore = 0;
+    uintptr_t ip = _Unwind_GetIPInfo(context, &ipBefore);
+    if (!ipBefore) ip--;
+    uintptr_t funcStart = _Unwind_GetRegionStart(context);
+    uintptr_t ipOffset = ip - funcStart;
+
+    // LSDA header
+    uint8_t lpStartEncoding = *lsda++;
+    uintptr_t lpStart = funcStart;
+    if (lpStartEncoding != CHRIS_DW_EH_PE_omit) lpStart = chris_read_encoded(&lsda, lpStartEncoding);
+    uint8_t ttypeEncoding = *lsda++;
+    const uint8_t* ttypeBase = NULL;
+    if (ttypeEncoding != CHRIS_DW_EH_PE_omit) {
+        uintptr_t offset = chris_read_uleb128(&lsda);
+        ttypeBase = lsda + offset;
+    }
+    uint8_t callSiteEncoding = *lsda++;
+    uintptr_t callSiteLength = chris_read_uleb128(&lsda);
+    const uint8_t* callSite = lsda;
+    const uint8_t* actionTable = callSite + callSiteLength;
+    int ours = exceptionClass == CHRIS_EXCEPTION_CLASS;
+
+    while (callSite < actionTable) {
+        uintptr_t start = chris_read_encoded(&callSite, callSiteEncoding);
+        uintptr_t length = chris_read_encoded(&callSite, callSiteEncoding);
+        uintptr_t landingPad = chris_read_encoded(&callSite, callSiteEncoding);
+        uintptr_t action = chris_read_uleb128(&callSite);
+        if (ipOffset < start) break; // table is sorted by start
+        if (ipOffset >= start + length) continue;
+        if (landingPad == 0) return _URC_CONTINUE_UNWIND;
+
+        // Walk the action chain: filter > 0 is a catch, 0 is a cleanup
+        intptr_t selector = 0;
+        int hasCleanup = action == 0;
+        if (action != 0) {
+            const uint8_t* a = actionTable + action - 1;
+            for (;;) {
+                intptr_t filter = chris_read_sleb128(&a);
+                const uint8_t* nextRecord = a;
+                intptr_t next = chris_read_sleb128(&a);
+                if (filter == 0) {
+                    hasCleanup = 1;
+                } else if (filter > 0 && ours && ttypeBase) {
+                    const uint8_t* entry = ttypeBase - (uintptr_t)filter * chris_encoded_size(ttypeEncoding);
+                    if (chris_read_encoded(&entry, ttypeEncoding) == 0) {
+                        selector = filter;
+                        break;
+                    }
+                }
+                if (next == 0) break;
+                a = nextRecord + next;
+            }
+        }
+
+        if (actions & _UA_SEARCH_PHASE) {
+            return selector > 0 ? _URC_HANDLER_FOUND : _URC_CONTINUE_UNWIND;
+        }
+        if (!(actions & _UA_HANDLER_FRAME)) {
+            if (!hasCleanup) return _URC_CONTINUE_UNWIND;
+            selector = 0;
+        }
+        _Unwind_SetGR(context, __builtin_eh_return_data_regno(0), (uintptr_t)ue);
+        _Unwind_SetGR(context, __builtin_eh_return_data_regno(1), (uintptr_t)selector);
+        _Unwind_SetIP(context, lpStart + landingPad);
+        return _URC_INSTALL_CONTEXT;
+    }
+    return _URC_CONTINUE_UNWIND;
 }
 
 void chris_print(const char* str) {
@@ -100,11 +728,11 @@ void* chris_array_alloc(long long elem_size, long long count) {
     return chris_gc_alloc((size_t)(elem_size * count), GC_ARRAY);
 }
 
-void chris_array_bounds_check(long long index, long long length) {
-    if (index < 0 || index >= length) {
-        fprintf(stderr, "Array index out of bounds: index %lld, length %lld\n", index, length);
-        exit(1);
-    }
+// Compiled code checks bounds inline and only calls this on failure
+__attribute__((noreturn, cold))
+void chris_array_bounds_fail(long long index, long long length) {
+    fprintf(stderr, "Array index out of bounds: index %lld, length %lld\n", index, length);
+    exit(1);
 }
 
 // String conversion methods
@@ -231,39 +859,47 @@ const char* chris_str_char_at(const char* str, long long index) {
 // Array struct: {i64 length, ptr data}
 typedef struct { long long length; void* data; } ChrisArray;
 
+// Closure record: the code, then its captured values. The code takes the
+// record as a trailing argument.
+typedef struct { void* code; } ChrisClosure;
+
 // Array methods
-void chris_array_push(ChrisArray* arr, long long elem_size, long long value) {
+// Grow the array by one element and return the new (uninitialised) slot.
+// Compiled code stores the element through it at the element's own width.
+void* chris_array_push_slot(ChrisArray* arr, long long elem_size) {
     long long new_len = arr->length + 1;
     void* new_data = chris_gc_alloc((size_t)(elem_size * new_len), GC_ARRAY);
     if (arr->data && arr->length > 0) {
         memcpy(new_data, arr->data, (size_t)(elem_size * arr->length));
     }
     arr->data = new_data;
-    // Store value at the end
-    memcpy((char*)arr->data + elem_size * arr->length, &value, (size_t)elem_size);
     arr->length = new_len;
+    return (char*)arr->data + elem_size * (new_len - 1);
 }
 
-long long chris_array_pop(ChrisArray* arr, long long elem_size) {
+// Shrink the array by one element and return the removed slot, which stays
+// valid until the next push reallocates.
+void* chris_array_pop_slot(ChrisArray* arr, long long elem_size) {
     if (arr->length <= 0) {
         fprintf(stderr, "Array pop on empty array\n");
         exit(1);
     }
     arr->length--;
-    long long value = 0;
-    memcpy(&value, (char*)arr->data + elem_size * arr->length, (size_t)elem_size);
-    return value;
+    return (char*)arr->data + elem_size * arr->length;
 }
 
 void chris_array_reverse(ChrisArray* arr, long long elem_size) {
     if (arr->length <= 1) return;
     char* data = (char*)arr->data;
-    char tmp[16]; // enough for i64 or double or pointer
     for (long long i = 0; i < arr->length / 2; i++) {
-        long long j = arr->length - 1 - i;
-        memcpy(tmp, data + i * elem_size, (size_t)elem_size);
-        memcpy(data + i * elem_size, data + j * elem_size, (size_t)elem_size);
-        memcpy(data + j * elem_size, tmp, (size_t)elem_size);
+        char* a = data + i * elem_size;
+        char* b = data + (arr->length - 1 - i) * elem_size;
+        // Byte-wise swap: struct elements can be any size
+        for (long long k = 0; k < elem_size; k++) {
+            char tmp = a[k];
+            a[k] = b[k];
+            b[k] = tmp;
+        }
     }
 }
 
@@ -298,42 +934,6 @@ const char* chris_array_join(ChrisArray* arr, const char* sep) {
     return result;
 }
 
-// Callback type for map: i64 -> i64
-typedef long long (*MapCallback)(long long);
-typedef int (*FilterCallback)(long long);
-typedef void (*ForEachCallback)(long long);
-
-void chris_array_map(ChrisArray* arr, long long elem_size, MapCallback cb, ChrisArray* out) {
-    out->length = arr->length;
-    out->data = chris_gc_alloc((size_t)(elem_size * arr->length), GC_ARRAY);
-    long long* src = (long long*)arr->data;
-    long long* dst = (long long*)out->data;
-    for (long long i = 0; i < arr->length; i++) {
-        dst[i] = cb(src[i]);
-    }
-}
-
-void chris_array_filter(ChrisArray* arr, long long elem_size, FilterCallback cb, ChrisArray* out) {
-    // Allocate max possible size
-    long long* src = (long long*)arr->data;
-    long long* tmp = (long long*)chris_gc_alloc((size_t)(elem_size * arr->length), GC_ARRAY);
-    long long count = 0;
-    for (long long i = 0; i < arr->length; i++) {
-        if (cb(src[i])) {
-            tmp[count++] = src[i];
-        }
-    }
-    out->length = count;
-    out->data = tmp;
-}
-
-void chris_array_foreach(ChrisArray* arr, long long elem_size, ForEachCallback cb) {
-    long long* src = (long long*)arr->data;
-    for (long long i = 0; i < arr->length; i++) {
-        cb(src[i]);
-    }
-}
-
 void chris_str_split(const char* str, const char* delim, ChrisArray* out) {
     if (!str || !delim || !out) {
         if (out) { out->length = 0; out->data = NULL; }
@@ -381,18 +981,45 @@ void chris_str_split(const char* str, const char* delim, ChrisArray* out) {
 
 static int chris_test_passed = 0;
 static int chris_test_failed = 0;
+static uint64_t chris_test_started_ns = 0;
+
+// When CHRIS_TEST_REPORT names a file, every finished test appends a
+// "<pass|fail>\t<name>\t<nanoseconds>" line to it for `chris test`
+static FILE* chris_test_report = NULL;
+
+static uint64_t chris_test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void chris_test_finish(const char* status, const char* label, const char* name) {
+    uint64_t elapsed = chris_test_now_ns() - chris_test_started_ns;
+    printf("  [ %s ] %s (%.2f ms)\n", label, name, (double)elapsed / 1e6);
+    if (chris_test_report) {
+        fprintf(chris_test_report, "%s\t%s\t%llu\n", status, name, (unsigned long long)elapsed);
+        fflush(chris_test_report);
+        fflush(stdout); // keep the output of finished tests if a later one crashes
+    }
+}
 
 void chris_test_start(const char* name) {
+    if (!chris_test_report) {
+        const char* path = getenv("CHRIS_TEST_REPORT");
+        if (path && *path) chris_test_report = fopen(path, "a");
+    }
     printf("  [ RUN  ] %s\n", name);
+    if (chris_test_report) fflush(stdout);
+    chris_test_started_ns = chris_test_now_ns();
 }
 
 void chris_test_pass(const char* name) {
-    printf("  [  OK  ] %s\n", name);
+    chris_test_finish("pass", " OK ", name);
     chris_test_passed++;
 }
 
 void chris_test_fail(const char* name) {
-    printf("  [ FAIL ] %s\n", name);
+    chris_test_finish("fail", "FAIL", name);
     chris_test_failed++;
 }
 
@@ -403,6 +1030,95 @@ int chris_test_summary(void) {
     return chris_test_failed;
 }
 
+// ============================================================================
+// Benchmark Runtime Support
+// ============================================================================
+//
+// `chris bench` runs each benchmark in batches:
+//
+//     n = chris_bench_begin("bench_name");
+//     while n > 0 {
+//         chris_bench_batch_start();
+//         for i in 0..n { bench_name(); }
+//         n = chris_bench_batch_end(n);
+//     }
+//
+// Batches grow until one lasts CHRIS_BENCH_WARMUP_MS (default 100), which
+// warms caches and lets the heap reach its working size, then until one
+// lasts CHRIS_BENCH_TIME_MS (default 1000). That last batch is the
+// measurement. Its time, allocations and collections are printed per
+// operation and, when CHRIS_BENCH_REPORT names a file, appended to it as
+// "<name>\t<iterations>\t<ns>\t<allocs>\t<bytes>\t<collections>".
+
+static const char* chris_bench_name = NULL;
+static int chris_bench_warming = 0;
+static uint64_t chris_bench_started_ns = 0;
+static size_t chris_bench_started_allocs = 0;
+static size_t chris_bench_started_bytes = 0;
+static size_t chris_bench_started_collections = 0;
+
+static uint64_t chris_bench_env_ms(const char* name, uint64_t fallback) {
+    const char* value = getenv(name);
+    if (!value || !*value) return fallback;
+    return strtoull(value, NULL, 10);
+}
+
+// A batch size aiming 20% past `target`, growing by at least one and at most 100x
+static long long chris_bench_grow(long long n, uint64_t elapsed, uint64_t target) {
+    double perOp = elapsed > 0 ? (double)elapsed / (double)n : 1.0;
+    double next = (double)target * 1.2 / perOp;
+    if (next > (double)n * 100.0) next = (double)n * 100.0;
+    if (next < (double)n + 1.0) next = (double)n + 1.0;
+    if (next > 1e9) next = 1e9;
+    return (long long)next;
+}
+
+long long chris_bench_begin(const char* name) {
+    chris_bench_name = name;
+    chris_bench_warming = 1;
+    return 1;
+}
+
+void chris_bench_batch_start(void) {
+    chris_bench_started_allocs = chris_gc_total_allocations();
+    chris_bench_started_bytes = chris_gc_total_allocated_bytes();
+    chris_bench_started_collections = chris_gc_total_collections();
+    chris_bench_started_ns = chris_test_now_ns();
+}
+
+// Returns the size of the next batch, or 0 once `n` was the measurement
+long long chris_bench_batch_end(long long n) {
+    uint64_t elapsed = chris_test_now_ns() - chris_bench_started_ns;
+    size_t allocs = chris_gc_total_allocations() - chris_bench_started_allocs;
+    size_t bytes = chris_gc_total_allocated_bytes() - chris_bench_started_bytes;
+    size_t collections = chris_gc_total_collections() - chris_bench_started_collections;
+
+    uint64_t warmup = chris_bench_env_ms("CHRIS_BENCH_WARMUP_MS", 100) * 1000000ull;
+    uint64_t target = chris_bench_env_ms("CHRIS_BENCH_TIME_MS", 1000) * 1000000ull;
+    if (chris_bench_warming) {
+        if (elapsed < warmup && n < 1000000000LL) return chris_bench_grow(n, elapsed, warmup);
+        chris_bench_warming = 0;
+        return chris_bench_grow(n, elapsed, target);
+    }
+    if (elapsed < target && n < 1000000000LL) return chris_bench_grow(n, elapsed, target);
+
+    double ops = (double)n;
+    printf("%-40s %12lld %14.2f ns/op %10.2f allocs/op %12.1f B/op %10.4f GCs/op\n",
+           chris_bench_name, n, (double)elapsed / ops, (double)allocs / ops, (double)bytes / ops,
+           (double)collections / ops);
+    fflush(stdout);
+    const char* path = getenv("CHRIS_BENCH_REPORT");
+    if (path && *path) {
+        FILE* report = fopen(path, "a");
+        if (report) {
+            fprintf(report, "%s\t%lld\t%llu\t%zu\t%zu\t%zu\n", chris_bench_name, n,
+                    (unsigned long long)elapsed, allocs, bytes, collections);
+            fclose(report);
+        }
+    }
+    return 0;
+}
+
 // assert_eq(a, b) — fails the current test if a != b
 void chris_assert_eq(long long a, long long b, const char* expr) {
     if (a != b) {
@@ -449,8 +1165,10 @@ void chris_mutex_destroy(void* ptr) {
 
 #define CHRIS_CHANNEL_MAX_BUFFER 4096
 
+// Elements are copied in and out at the width given to chris_channel_create
 typedef struct chris_channel {
-    long long* buffer;
+    unsigned char* buffer;
+    long long elem_size;
     int capacity;
     int count;
     int head;       // read index
@@ -461,12 +1179,13 @@ typedef struct chris_channel {
     pthread_cond_t  not_full;
 } chris_channel;
 
-// Create a new channel with the given buffer capacity
-chris_channel* chris_channel_create(long long capacity) {
+// Create a new channel with the given buffer capacity and element size
+chris_channel* chris_channel_create(long long capacity, long long elem_size) {
     if (capacity <= 0) capacity = 1;
     if (capacity > CHRIS_CHANNEL_MAX_BUFFER) capacity = CHRIS_CHANNEL_MAX_BUFFER;
     chris_channel* ch = (chris_channel*)malloc(sizeof(chris_channel));
-    ch->buffer = (long long*)malloc(sizeof(long long) * capacity);
+    ch->buffer = (unsigned char*)malloc((size_t)(elem_size * capacity));
+    ch->elem_size = elem_size;
     ch->capacity = (int)capacity;
     ch->count = 0;
     ch->head = 0;
@@ -478,9 +1197,9 @@ chris_channel* chris_channel_create(long long capacity) {
     return ch;
 }
 
-// Send a value into the channel (blocks if full, fails if closed)
+// Send the element at `value` into the channel (blocks if full, fails if closed)
 // Returns 1 on success, 0 if channel is closed
-int chris_channel_send(chris_channel* ch, long long value) {
+int chris_channel_send(chris_channel* ch, const void* value) {
     pthread_mutex_lock(&ch->mutex);
     while (ch->count == ch->capacity && !ch->closed) {
         pthread_cond_wait(&ch->not_full, &ch->mutex);
@@ -489,7 +1208,7 @@ int chris_channel_send(chris_channel* ch, long long value) {
         pthread_mutex_unlock(&ch->mutex);
         return 0;
     }
-    ch->buffer[ch->tail] = value;
+    memcpy(ch->buffer + ch->tail * ch->elem_size, value, (size_t)ch->elem_size);
     ch->tail = (ch->tail + 1) % ch->capacity;
     ch->count++;
     pthread_cond_signal(&ch->not_empty);
@@ -499,7 +1218,7 @@ int chris_channel_send(chris_channel* ch, long long value) {
 
 // Receive a value from the channel (blocks if empty)
 // Returns 1 on success (value written to *out), 0 if channel is closed and empty
-int chris_channel_recv(chris_channel* ch, long long* out) {
+int chris_channel_recv(chris_channel* ch, void* out) {
     pthread_mutex_lock(&ch->mutex);
     while (ch->count == 0 && !ch->closed) {
         pthread_cond_wait(&ch->not_empty, &ch->mutex);
@@ -508,7 +1227,7 @@ int chris_channel_recv(chris_channel* ch, long long* out) {
         pthread_mutex_unlock(&ch->mutex);
         return 0;
     }
-    *out = ch->buffer[ch->head];
+    memcpy(out, ch->buffer + ch->head * ch->elem_size, (size_t)ch->elem_size);
     ch->head = (ch->head + 1) % ch->capacity;
     ch->count--;
     pthread_cond_signal(&ch->not_full);
@@ -541,14 +1260,19 @@ void chris_channel_destroy(chris_channel* ch) {
 #define CHRIS_MAP_INITIAL_CAPACITY 16
 #define CHRIS_MAP_LOAD_FACTOR 0.75
 
+// Values are stored inline after the two header pointers, which keeps
+// malloc's alignment, at the width given to chris_map_create. Compiled code
+// reads and writes them through the slots returned by chris_map_slot and
+// chris_map_find.
 typedef struct chris_map_entry {
     const char* key;
-    long long value;
     struct chris_map_entry* next;
+    unsigned char value[];
 } chris_map_entry;
 
 typedef struct chris_map {
     chris_map_entry** buckets;
+    long long value_size;
     int capacity;
     int size;
 } chris_map;
@@ -561,8 +1285,9 @@ static unsigned long chris_map_hash(const char* key) {
     return hash;
 }
 
-chris_map* chris_map_create(void) {
+chris_map* chris_map_create(long long value_size) {
     chris_map* m = (chris_map*)malloc(sizeof(chris_map));
+    m->value_size = value_size;
     m->capacity = CHRIS_MAP_INITIAL_CAPACITY;
     m->size = 0;
     m->buckets = (chris_map_entry**)calloc(m->capacity, sizeof(chris_map_entry*));
@@ -587,42 +1312,41 @@ static void chris_map_resize(chris_map* m) {
     free(oldBuckets);
 }
 
-void chris_map_set(chris_map* m, const char* key, long long value) {
-    if (!m || !key) return;
+// The value slot for the key, added and zeroed if the key is new
+void* chris_map_slot(chris_map* m, const char* key) {
+    if (!m || !key) return NULL;
     unsigned long idx = chris_map_hash(key) % m->capacity;
     chris_map_entry* e = m->buckets[idx];
     while (e) {
-        if (strcmp(e->key, key) == 0) {
-            e->value = value;
-            return;
-        }
+        if (strcmp(e->key, key) == 0) return e->value;
         e = e->next;
     }
     // New entry
-    chris_map_entry* newEntry = (chris_map_entry*)malloc(sizeof(chris_map_entry));
+    chris_map_entry* newEntry = (chris_map_entry*)calloc(1, sizeof(chris_map_entry) + (size_t)m->value_size);
     size_t klen = strlen(key);
     char* kcopy = (char*)malloc(klen + 1);
     memcpy(kcopy, key, klen + 1);
     newEntry->key = kcopy;
-    newEntry->value = value;
     newEntry->next = m->buckets[idx];
     m->buckets[idx] = newEntry;
     m->size++;
+    // Resizing relinks entries without moving them, so the slot stays valid
     if ((double)m->size / m->capacity > CHRIS_MAP_LOAD_FACTOR) {
         chris_map_resize(m);
     }
+    return newEntry->value;
 }
 
-// Returns the value for the key, or 0 if not found
-long long chris_map_get(chris_map* m, const char* key) {
-    if (!m || !key) return 0;
+// The value slot for the key, or NULL if not found
+void* chris_map_find(chris_map* m, const char* key) {
+    if (!m || !key) return NULL;
     unsigned long idx = chris_map_hash(key) % m->capacity;
     chris_map_entry* e = m->buckets[idx];
     while (e) {
         if (strcmp(e->key, key) == 0) return e->value;
         e = e->next;
     }
-    return 0;
+    return NULL;
 }
 
 // Returns 1 if key exists, 0 otherwise
@@ -974,9 +1698,903 @@ int chris_append_file(const char* path, const char* content) {
 // Check if file exists. Returns 1 if exists, 0 otherwise.
 int chris_file_exists(const char* path) {
     if (!path) return 0;
-    FILE* f = fopen(path, "r");
-    if (f) { fclose(f); return 1; }
-    return 0;
+    return access(path, F_OK) == 0 ? 1 : 0;
+}
+
+// ============================================================================
+// Memory-Mapped File Support
+// ============================================================================
+
+// Access pattern hints for chris_mmap_advise (values match POSIX_MADV_*)
+#define CHRIS_MADV_NORMAL     0
+#define CHRIS_MADV_RANDOM     1
+#define CHRIS_MADV_SEQUENTIAL 2
+#define CHRIS_MADV_WILLNEED   3
+#define CHRIS_MADV_DONTNEED   4
+
+// Mapped file handle. Lives in the GC heap so an unreachable mapping is
+// unmapped by its finalizer; the mapped bytes themselves are never scanned.
+typedef struct {
+    void* data;       // start of the mapping (NULL for empty or closed files)
+    long long size;   // length of the mapping in bytes
+    int writable;     // mapped with PROT_WRITE / MAP_SHARED
+} chris_mapped_file;
+
+void chris_mmap_close(void* handle);
+
+static void chris_mmap_finalize(void* ptr) {
+    chris_mmap_close(ptr);
+}
+
+// Map a file into memory. Returns a handle, or NULL if the file cannot be
+// opened or mapped. Writable mappings are shared: stores reach the file.
+void* chris_mmap_open(const char* path, int writable) {
+    if (!path) return NULL;
+    int fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    void* data = NULL;
+    if (st.st_size > 0) {
+        int prot = PROT_READ | (writable ? PROT_WRITE : 0);
+        data = mmap(NULL, (size_t)st.st_size, prot, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return NULL;
+        }
+    }
+    close(fd); // the mapping keeps its own reference to the file
+
+    chris_mapped_file* mf = (chris_mapped_file*)chris_gc_alloc_with_finalizer(
+        sizeof(chris_mapped_file), GC_CONTAINER, chris_mmap_finalize);
+    mf->data = data;
+    mf->size = (long long)st.st_size;
+    mf->writable = writable;
+    return mf;
+}
+
+// Pointer to the first mapped byte (NULL for empty or closed mappings)
+void* chris_mmap_data(void* handle) {
+    chris_mapped_file* mf = (chris_mapped_file*)handle;
+    return mf ? mf->data : NULL;
+}
+
+// Size of the mapping in bytes, or -1 if the handle is nil
+long long chris_mmap_size(void* handle) {
+    chris_mapped_file* mf = (chris_mapped_file*)handle;
+    return mf ? mf->size : -1;
+}
+
+// Give the kernel a paging hint for the whole mapping. Returns 1 on success.
+int chris_mmap_advise(void* handle, long long advice) {
+    chris_mapped_file* mf = (chris_mapped_file*)handle;
+    if (!mf || !mf->data) return 0;
+    int hint;
+    switch (advice) {
+        case CHRIS_MADV_RANDOM:     hint = POSIX_MADV_RANDOM; break;
+        case CHRIS_MADV_SEQUENTIAL: hint = POSIX_MADV_SEQUENTIAL; break;
+        case CHRIS_MADV_WILLNEED:   hint = POSIX_MADV_WILLNEED; break;
+        case CHRIS_MADV_DONTNEED:   hint = POSIX_MADV_DONTNEED; break;
+        default:                    hint = POSIX_MADV_NORMAL; break;
+    }
+    return posix_madvise(mf->data, (size_t)mf->size, hint) == 0 ? 1 : 0;
+}
+
+// Flush a writable mapping back to the file. Returns 1 on success.
+int chris_mmap_sync(void* handle) {
+    chris_mapped_file* mf = (chris_mapped_file*)handle;
+    if (!mf || !mf->data || !mf->writable) return 0;
+    return msync(mf->data, (size_t)mf->size, MS_SYNC) == 0 ? 1 : 0;
+}
+
+// Copy bytes [start, end) of the mapping into a GC string (clamped to bounds)
+const char* chris_mmap_slice(void* handle, long long start, long long end) {
+    chris_mapped_file* mf = (chris_mapped_file*)handle;
+    if (!mf || !mf->data) return "";
+    if (start < 0) start = 0;
+    if (end > mf->size) end = mf->size;
+    if (start >= end) return "";
+    size_t len = (size_t)(end - start);
+    char* buf = (char*)chris_gc_alloc(len + 1, GC_STRING);
+    memcpy(buf, (const char*)mf->data + start, len);
+    buf[len] = '\0';
+    return buf;
+}
+
+// Offset of the first occurrence of needle at or after `from`, or -1
+long long chris_mmap_index_of(void* handle, const char* needle, long long from) {
+    chris_mapped_file* mf = (chris_mapped_file*)handle;
+    if (!mf || !mf->data || !needle) return -1;
+    size_t nlen = strlen(needle);
+    if (from < 0) from = 0;
+    // Keep base + from and the last start inside the mapping
+    if (from > mf->size || (long long)nlen > mf->size - from) return -1;
+    if (nlen == 0) return from;
+    const char* base = (const char*)mf->data;
+    const char* p = base + from;
+    const char* last = base + mf->size - nlen;
+    while (p <= last) {
+        p = (const char*)memchr(p, needle[0], (size_t)(last - p) + 1);
+        if (!p) return -1;
+        if (memcmp(p, needle, nlen) == 0) return (long long)(p - base);
+        p++;
+    }
+    return -1;
+}
+
+// Unmap the file. Safe to call more than once; the finalizer calls it too.
+void chris_mmap_close(void* handle) {
+    chris_mapped_file* mf = (chris_mapped_file*)handle;
+    if (!mf || !mf->data) return;
+    munmap(mf->data, (size_t)mf->size);
+    mf->data = NULL;
+    mf->size = 0;
+}
+
+// ============================================================================
+// Buffered File Streams
+// ============================================================================
+
+// Open flags for chris_file_reader_open / chris_file_writer_open (bitmask)
+#define CHRIS_FILE_SEQUENTIAL 1  // hint sequential access (posix_fadvise)
+#define CHRIS_FILE_NOCACHE    2  // drop pages from the page cache once consumed
+#define CHRIS_FILE_DIRECT     4  // bypass the page cache (O_DIRECT / F_NOCACHE)
+
+#define CHRIS_FILE_DEFAULT_BUFFER (64 * 1024)
+#define CHRIS_FILE_DIRECT_ALIGN   4096
+
+// Reader/writer handle. Lives in the GC heap so an unreachable stream is
+// flushed and closed by its finalizer; the buffers are malloc'd.
+typedef struct {
+    int fd;              // -1 once closed
+    int writing;         // 1 for writers, 0 for readers
+    int flags;           // CHRIS_FILE_* bits actually in effect
+    char* buf;           // block buffer (4 KiB aligned when direct)
+    long long cap;       // buffer capacity
+    long long pos;       // reader: next unread byte; writer: bytes pending
+    long long len;       // reader: valid bytes in buf
+    long long offset;    // file offset of the start of buf (for NOCACHE)
+    int eof;             // reader hit end of file
+    char* line;          // scratch buffer for lines spanning refills
+    long long lineCap;
+} chris_file_stream;
+
+int chris_file_writer_close(void* handle);
+void chris_file_reader_close(void* handle);
+
+static void chris_file_stream_finalize(void* ptr) {
+    chris_file_stream* fs = (chris_file_stream*)ptr;
+    if (fs->writing) chris_file_writer_close(ptr);
+    else chris_file_reader_close(ptr);
+}
+
+// Open `path` with the requested flags, dropping O_DIRECT if the filesystem
+// refuses it (tmpfs, some network filesystems).
+static int chris_file_open_fd(const char* path, int oflags, int* flags) {
+    int fd = -1;
+#ifdef O_DIRECT
+    if (*flags & CHRIS_FILE_DIRECT) {
+        fd = open(path, oflags | O_DIRECT, 0644);
+        if (fd >= 0) return fd;
+        if (errno != EINVAL) return -1;
+        *flags &= ~CHRIS_FILE_DIRECT;
+    }
+#endif
+    fd = open(path, oflags, 0644);
+    if (fd < 0) return -1;
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+    if (*flags & CHRIS_FILE_DIRECT) {
+        fcntl(fd, F_NOCACHE, 1);
+        *flags &= ~CHRIS_FILE_DIRECT; // no alignment rules without O_DIRECT
+    }
+#elif !defined(O_DIRECT)
+    *flags &= ~CHRIS_FILE_DIRECT;
+#endif
+#if defined(POSIX_FADV_SEQUENTIAL)
+    if (*flags & CHRIS_FILE_SEQUENTIAL) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+    return fd;
+}
+
+static void chris_file_drop_cache(chris_file_stream* fs, long long length) {
+#if defined(POSIX_FADV_DONTNEED)
+    if ((fs->flags & CHRIS_FILE_NOCACHE) && length > 0) {
+        posix_fadvise(fs->fd, (off_t)fs->offset, (off_t)length, POSIX_FADV_DONTNEED);
+    }
+#else
+    (void)fs;
+    (void)length;
+#endif
+}
+
+static chris_file_stream* chris_file_stream_new(int fd, int writing, int flags,
+                                                long long bufferSize) {
+    if (bufferSize <= 0) bufferSize = CHRIS_FILE_DEFAULT_BUFFER;
+    void* buf = NULL;
+    if (flags & CHRIS_FILE_DIRECT) {
+        // O_DIRECT transfers must be block-aligned in address and length
+        bufferSize = (bufferSize + CHRIS_FILE_DIRECT_ALIGN - 1) & ~(long long)(CHRIS_FILE_DIRECT_ALIGN - 1);
+        if (posix_memalign(&buf, CHRIS_FILE_DIRECT_ALIGN, (size_t)bufferSize) != 0) buf = NULL;
+    } else {
+        buf = malloc((size_t)bufferSize);
+    }
+    if (!buf) return NULL;
+
+    chris_file_stream* fs = (chris_file_stream*)chris_gc_alloc_with_finalizer(
+        sizeof(chris_file_stream), GC_CONTAINER, chris_file_stream_finalize);
+    fs->fd = fd;
+    fs->writing = writing;
+    fs->flags = flags;
+    fs->buf = (char*)buf;
+    fs->cap = bufferSize;
+    fs->pos = 0;
+    fs->len = 0;
+    fs->offset = 0;
+    fs->eof = 0;
+    fs->line = NULL;
+    fs->lineCap = 0;
+    return fs;
+}
+
+// Open a file for buffered reading. bufferSize <= 0 selects the default
+// (64 KiB). Returns a handle, or NULL if the file cannot be opened.
+void* chris_file_reader_open(const char* path, long long bufferSize, long long flags) {
+    if (!path) return NULL;
+    int f = (int)flags;
+    int fd = chris_file_open_fd(path, O_RDONLY, &f);
+    if (fd < 0) return NULL;
+    chris_file_stream* fs = chris_file_stream_new(fd, 0, f, bufferSize);
+    if (!fs) close(fd);
+    return fs;
+}
+
+// Refill the read buffer. Returns bytes read, 0 at EOF, -1 on error.
+static long long chris_file_fill(chris_file_stream* fs) {
+    chris_file_drop_cache(fs, fs->len);
+    fs->offset += fs->len;
+    fs->pos = 0;
+    fs->len = 0;
+    if (fs->eof) return 0;
+    ssize_t n;
+    do {
+        n = read(fs->fd, fs->buf, (size_t)fs->cap);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        fs->eof = 1;
+        return n < 0 ? -1 : 0;
+    }
+    fs->len = (long long)n;
+    return n;
+}
+
+// Make room for `need` bytes in the line scratch buffer
+static int chris_file_line_reserve(chris_file_stream* fs, long long need) {
+    if (need <= fs->lineCap) return 1;
+    long long cap = fs->lineCap ? fs->lineCap : 256;
+    while (cap < need) cap *= 2;
+    char* grown = (char*)realloc(fs->line, (size_t)cap);
+    if (!grown) return 0;
+    fs->line = grown;
+    fs->lineCap = cap;
+    return 1;
+}
+
+// Read the next line without its trailing "\n" or "\r\n". Returns NULL at
+// end of file; a final line without a newline is still returned.
+const char* chris_file_read_line(void* handle) {
+    chris_file_stream* fs = (chris_file_stream*)handle;
+    if (!fs || fs->fd < 0 || fs->writing) return NULL;
+
+    long long lineLen = 0;
+    int found = 0;
+    for (;;) {
+        if (fs->pos >= fs->len && chris_file_fill(fs) <= 0) break;
+        char* start = fs->buf + fs->pos;
+        long long avail = fs->len - fs->pos;
+        char* nl = (char*)memchr(start, '\n', (size_t)avail);
+        long long take = nl ? (long long)(nl - start) : avail;
+
+        if (lineLen == 0 && nl) {
+            // Fast path: the whole line is in the buffer
+            long long n = take;
+            if (n > 0 && start[n - 1] == '\r') n--;
+            char* out = (char*)chris_gc_alloc((size_t)n + 1, GC_STRING);
+            memcpy(out, start, (size_t)n);
+            out[n] = '\0';
+            fs->pos += take + 1;
+            return out;
+        }
+
+        if (!chris_file_line_reserve(fs, lineLen + take + 1)) return NULL;
+        memcpy(fs->line + lineLen, start, (size_t)take);
+        lineLen += take;
+        fs->pos += take;
+        if (nl) {
+            fs->pos++;
+            found = 1;
+            break;
+        }
+    }
+
+    if (!found && lineLen == 0) return NULL;
+    if (lineLen > 0 && fs->line[lineLen - 1] == '\r') lineLen--;
+    char* out = (char*)chris_gc_alloc((size_t)lineLen + 1, GC_STRING);
+    if (lineLen > 0) memcpy(out, fs->line, (size_t)lineLen);
+    out[lineLen] = '\0';
+    return out;
+}
+
+// Read up to `count` bytes into `dst`. Returns bytes read, 0 at end of file,
+// -1 on error. Large reads with an empty buffer go straight to the file.
+long long chris_file_read_into(void* handle, void* dst, long long count) {
+    chris_file_stream* fs = (chris_file_stream*)handle;
+    if (!fs || fs->fd < 0 || fs->writing || !dst) return -1;
+    if (count <= 0) return 0;
+
+    long long total = 0;
+    char* out = (char*)dst;
+    while (total < count) {
+        long long avail = fs->len - fs->pos;
+        if (avail > 0) {
+            long long n = (count - total < avail) ? count - total : avail;
+            memcpy(out + total, fs->buf + fs->pos, (size_t)n);
+            fs->pos += n;
+            total += n;
+            continue;
+        }
+        if (fs->eof) break;
+        if (count - total >= fs->cap && !(fs->flags & CHRIS_FILE_DIRECT)) {
+            chris_file_drop_cache(fs, fs->len);
+            fs->offset += fs->len;
+            fs->pos = 0;
+            fs->len = 0;
+            ssize_t n;
+            do {
+                n = read(fs->fd, out + total, (size_t)(count - total));
+            } while (n < 0 && errno == EINTR);
+            if (n < 0) return total > 0 ? total : -1;
+            if (n == 0) {
+                fs->eof = 1;
+                break;
+            }
+            fs->offset += n;
+            total += n;
+            continue;
+        }
+        long long n = chris_file_fill(fs);
+        if (n < 0) return total > 0 ? total : -1;
+        if (n == 0) break;
+    }
+    return total;
+}
+
+// Close a reader. Safe to call more than once; the finalizer calls it too.
+void chris_file_reader_close(void* handle) {
+    chris_file_stream* fs = (chris_file_stream*)handle;
+    if (!fs || fs->fd < 0) return;
+    chris_file_drop_cache(fs, fs->len);
+    close(fs->fd);
+    fs->fd = -1;
+    free(fs->buf);
+    free(fs->line);
+    fs->buf = NULL;
+    fs->line = NULL;
+    fs->len = fs->pos = fs->cap = fs->lineCap = 0;
+}
+
+// Open a file for buffered writing, truncating it unless `append` is set.
+// Returns a handle, or NULL if the file cannot be opened.
+void* chris_file_writer_open(const char* path, int append, long long bufferSize,
+                             long long flags) {
+    if (!path) return NULL;
+    int f = (int)flags;
+    int oflags = O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC);
+    if (append) f &= ~CHRIS_FILE_DIRECT; // appends cannot honour O_DIRECT alignment
+    int fd = chris_file_open_fd(path, oflags, &f);
+    if (fd < 0) return NULL;
+    chris_file_stream* fs = chris_file_stream_new(fd, 1, f, bufferSize);
+    if (!fs) close(fd);
+    return fs;
+}
+
+// write(2) until every byte is out. Returns 1 on success.
+static int chris_file_write_fully(int fd, const char* data, long long count) {
+    while (count > 0) {
+        ssize_t n = write(fd, data, (size_t)count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        data += n;
+        count -= n;
+    }
+    return 1;
+}
+
+// Write out the pending buffer. Returns 1 on success.
+static int chris_file_flush_buffer(chris_file_stream* fs) {
+    if (fs->pos == 0) return 1;
+#ifdef O_DIRECT
+    if ((fs->flags & CHRIS_FILE_DIRECT) && (fs->pos % CHRIS_FILE_DIRECT_ALIGN) != 0) {
+        // A partial trailing block cannot go through O_DIRECT
+        int fl = fcntl(fs->fd, F_GETFL);
+        if (fl >= 0) fcntl(fs->fd, F_SETFL, fl & ~O_DIRECT);
+        fs->flags &= ~CHRIS_FILE_DIRECT;
+    }
+#endif
+    int ok = chris_file_write_fully(fs->fd, fs->buf, fs->pos);
+    if (ok) {
+        chris_file_drop_cache(fs, fs->pos);
+        fs->offset += fs->pos;
+    }
+    fs->pos = 0;
+    return ok;
+}
+
+// Append `count` bytes from `src` to the stream. Writes larger than the
+// buffer skip it. Returns 1 on success, 0 on failure.
+int chris_file_write_all(void* handle, const void* src, long long count) {
+    chris_file_stream* fs = (chris_file_stream*)handle;
+    if (!fs || fs->fd < 0 || !fs->writing) return 0;
+    if (count <= 0) return 1;
+    if (!src) return 0;
+
+    const char* data = (const char*)src;
+    if (count >= fs->cap && !(fs->flags & CHRIS_FILE_DIRECT)) {
+        if (!chris_file_flush_buffer(fs)) return 0;
+        if (!chris_file_write_fully(fs->fd, data, count)) return 0;
+        chris_file_drop_cache(fs, count);
+        fs->offset += count;
+        return 1;
+    }
+    while (count > 0) {
+        long long room = fs->cap - fs->pos;
+        long long n = count < room ? count : room;
+        memcpy(fs->buf + fs->pos, data, (size_t)n);
+        fs->pos += n;
+        data += n;
+        count -= n;
+        if (fs->pos == fs->cap && !chris_file_flush_buffer(fs)) return 0;
+    }
+    return 1;
+}
+
+// Append a string. Returns 1 on success, 0 on failure.
+int chris_file_write(void* handle, const char* s) {
+    if (!s) return 0;
+    return chris_file_write_all(handle, s, (long long)strlen(s));
+}
+
+// Append a string followed by "\n". Returns 1 on success, 0 on failure.
+int chris_file_write_line(void* handle, const char* s) {
+    if (!chris_file_write(handle, s)) return 0;
+    return chris_file_write_all(handle, "\n", 1);
+}
+
+// Push buffered bytes to the file. Returns 1 on success.
+int chris_file_flush(void* handle) {
+    chris_file_stream* fs = (chris_file_stream*)handle;
+    if (!fs || fs->fd < 0 || !fs->writing) return 0;
+    return chris_file_flush_buffer(fs);
+}
+
+// Flush and close a writer. Returns 1 if every buffered byte was written.
+// Safe to call more than once; the finalizer calls it too.
+int chris_file_writer_close(void* handle) {
+    chris_file_stream* fs = (chris_file_stream*)handle;
+    if (!fs || fs->fd < 0) return 0;
+    int ok = chris_file_flush_buffer(fs);
+    if (close(fs->fd) != 0) ok = 0;
+    fs->fd = -1;
+    free(fs->buf);
+    fs->buf = NULL;
+    fs->cap = 0;
+    return ok;
+}
+
+// ============================================================================
+// Filesystem Metadata and Traversal
+// ============================================================================
+
+// Size of a file in bytes, or -1 if it does not exist
+long long chris_file_size(const char* path) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0) return -1;
+    return (long long)st.st_size;
+}
+
+// Modification time in seconds since the epoch, or -1 if it does not exist
+long long chris_file_mtime(const char* path) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0) return -1;
+    return (long long)st.st_mtime;
+}
+
+// 1 if path names a directory (following symlinks), 0 otherwise
+int chris_is_directory(const char* path) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0) return 0;
+    return S_ISDIR(st.st_mode) ? 1 : 0;
+}
+
+static int chris_cmp_cstr(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+// List the entry names in a directory (without "." and ".."), sorted.
+// A missing or unreadable directory yields an empty array.
+void chris_list_dir(const char* path, ChrisArray* out) {
+    out->length = 0;
+    out->data = NULL;
+    DIR* dir = path ? opendir(path) : NULL;
+    if (!dir) return;
+
+    long long count = 0, cap = 16;
+    const char** names = (const char**)malloc(sizeof(const char*) * (size_t)cap);
+    struct dirent* ent;
+    while (names && (ent = readdir(dir)) != NULL) {
+        const char* n = ent->d_name;
+        if (n[0] == '.' && (n[1] == '\0' || (n[1] == '.' && n[2] == '\0'))) continue;
+        if (count == cap) {
+            cap *= 2;
+            const char** grown = (const char**)realloc(names, sizeof(const char*) * (size_t)cap);
+            if (!grown) break;
+            names = grown;
+        }
+        size_t len = strlen(n);
+        char* copy = (char*)chris_gc_alloc(len + 1, GC_STRING);
+        memcpy(copy, n, len + 1);
+        names[count++] = copy;
+    }
+    closedir(dir);
+    if (!names) return;
+
+    qsort(names, (size_t)count, sizeof(const char*), chris_cmp_cstr);
+    const char** data = (const char**)chris_gc_alloc(sizeof(const char*) * (size_t)(count ? count : 1), GC_ARRAY);
+    memcpy(data, names, sizeof(const char*) * (size_t)count);
+    free(names);
+    out->length = count;
+    out->data = data;
+}
+
+#ifdef __linux__
+// Raw getdents64 record; glibc only exposes a wrapper from 2.30 on
+struct chris_dirent64 {
+    unsigned long long d_ino;
+    long long d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#define CHRIS_DENTS_BUFFER (32 * 1024)
+#endif
+
+// One open directory on the walk stack
+typedef struct {
+#ifdef __linux__
+    int fd;
+    char* buf;           // getdents64 batch
+    long bpos, blen;
+#else
+    DIR* dir;
+#endif
+    size_t pathLen;      // length of this directory's path in walker->path
+} chris_walk_frame;
+
+// Recursive directory walker. Entries are read in batches straight from the
+// kernel and the current path lives in one reused buffer, so nothing is
+// allocated per entry until a matching file is handed back to the program.
+typedef struct {
+    chris_walk_frame* frames;
+    int depth;
+    int cap;
+    char* path;
+    size_t pathCap;
+    char* pattern;       // fnmatch pattern on the file name, NULL for all
+} chris_dir_walker;
+
+void chris_walk_close(void* handle);
+
+static void chris_walk_finalize(void* ptr) {
+    chris_walk_close(ptr);
+}
+
+static int chris_walk_path_reserve(chris_dir_walker* w, size_t need) {
+    if (need <= w->pathCap) return 1;
+    size_t cap = w->pathCap ? w->pathCap : 256;
+    while (cap < need) cap *= 2;
+    char* grown = (char*)realloc(w->path, cap);
+    if (!grown) return 0;
+    w->path = grown;
+    w->pathCap = cap;
+    return 1;
+}
+
+// Push an open directory descriptor; takes ownership of fd
+static int chris_walk_push(chris_dir_walker* w, int fd, size_t pathLen) {
+    if (w->depth == w->cap) {
+        int cap = w->cap ? w->cap * 2 : 16;
+        chris_walk_frame* grown = (chris_walk_frame*)realloc(w->frames, sizeof(chris_walk_frame) * (size_t)cap);
+        if (!grown) { close(fd); return 0; }
+        w->frames = grown;
+        w->cap = cap;
+    }
+    chris_walk_frame* f = &w->frames[w->depth];
+#ifdef __linux__
+    f->buf = (char*)malloc(CHRIS_DENTS_BUFFER);
+    if (!f->buf) { close(fd); return 0; }
+    f->fd = fd;
+    f->bpos = f->blen = 0;
+#else
+    f->dir = fdopendir(fd);
+    if (!f->dir) { close(fd); return 0; }
+#endif
+    f->pathLen = pathLen;
+    w->depth++;
+    return 1;
+}
+
+static void chris_walk_pop(chris_dir_walker* w) {
+    chris_walk_frame* f = &w->frames[--w->depth];
+#ifdef __linux__
+    close(f->fd);
+    free(f->buf);
+#else
+    closedir(f->dir);
+#endif
+}
+
+static int chris_walk_frame_fd(chris_walk_frame* f) {
+#ifdef __linux__
+    return f->fd;
+#else
+    return dirfd(f->dir);
+#endif
+}
+
+// Next raw entry of a frame: name and d_type. Returns 0 when exhausted.
+static int chris_walk_read(chris_walk_frame* f, const char** name, unsigned char* type) {
+#ifdef __linux__
+    if (f->bpos >= f->blen) {
+        long n = syscall(SYS_getdents64, f->fd, f->buf, CHRIS_DENTS_BUFFER);
+        if (n <= 0) return 0;
+        f->blen = n;
+        f->bpos = 0;
+    }
+    struct chris_dirent64* d = (struct chris_dirent64*)(f->buf + f->bpos);
+    f->bpos += d->d_reclen;
+    *name = d->d_name;
+    *type = d->d_type;
+    return 1;
+#else
+    struct dirent* d = readdir(f->dir);
+    if (!d) return 0;
+    *name = d->d_name;
+    *type = d->d_type;
+    return 1;
+#endif
+}
+
+// Start a recursive walk of `root`. pattern (may be NULL or "") filters
+// yielded files by name with fnmatch. Returns NULL if root cannot be opened.
+void* chris_walk_open(const char* root, const char* pattern) {
+    if (!root) return NULL;
+    int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    chris_dir_walker* w = (chris_dir_walker*)chris_gc_alloc_with_finalizer(
+        sizeof(chris_dir_walker), GC_CONTAINER, chris_walk_finalize);
+    size_t len = strlen(root);
+    while (len > 1 && root[len - 1] == '/') len--;
+    if (!chris_walk_path_reserve(w, len + 1)) { close(fd); return NULL; }
+    memcpy(w->path, root, len);
+    w->path[len] = '\0';
+    if (pattern && pattern[0]) {
+        w->pattern = strdup(pattern);
+    }
+    if (!chris_walk_push(w, fd, len)) return NULL;
+    return w;
+}
+
+// Advance to the next matching non-directory entry. Returns a pointer to the
+// walker's internal path buffer (valid until the next call) or NULL when done.
+const char* chris_walk_next_path(void* handle) {
+    chris_dir_walker* w = (chris_dir_walker*)handle;
+    if (!w) return NULL;
+    while (w->depth > 0) {
+        chris_walk_frame* f = &w->frames[w->depth - 1];
+        const char* name;
+        unsigned char type;
+        if (!chris_walk_read(f, &name, &type)) {
+            chris_walk_pop(w);
+            continue;
+        }
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+        size_t nameLen = strlen(name);
+        size_t len = f->pathLen + 1 + nameLen;
+        if (!chris_walk_path_reserve(w, len + 1)) return NULL;
+        f = &w->frames[w->depth - 1];
+        int needSlash = !(f->pathLen == 1 && w->path[0] == '/');
+        if (!needSlash) len--;
+        if (needSlash) w->path[f->pathLen] = '/';
+        memcpy(w->path + f->pathLen + needSlash, name, nameLen + 1);
+
+        if (type == DT_UNKNOWN) {
+            struct stat st;
+            if (fstatat(chris_walk_frame_fd(f), name, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            type = S_ISDIR(st.st_mode) ? DT_DIR : DT_REG;
+        }
+        if (type == DT_DIR) {
+            // Symlinked directories are reported as DT_LNK and not followed
+            int fd = openat(chris_walk_frame_fd(f), name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd >= 0) chris_walk_push(w, fd, len);
+            continue;
+        }
+        if (w->pattern && fnmatch(w->pattern, w->path + len - nameLen, 0) != 0) continue;
+        return w->path;
+    }
+    return NULL;
+}
+
+// Next matching path as a GC string, or NULL when the walk is finished
+const char* chris_walk_next(void* handle) {
+    const char* p = chris_walk_next_path(handle);
+    if (!p) return NULL;
+    size_t len = strlen(p);
+    char* out = (char*)chris_gc_alloc(len + 1, GC_STRING);
+    memcpy(out, p, len + 1);
+    return out;
+}
+
+// Release all open directories. Safe to call more than once.
+void chris_walk_close(void* handle) {
+    chris_dir_walker* w = (chris_dir_walker*)handle;
+    if (!w) return;
+    while (w->depth > 0) chris_walk_pop(w);
+    free(w->frames);
+    free(w->path);
+    free(w->pattern);
+    w->frames = NULL;
+    w->path = NULL;
+    w->pattern = NULL;
+    w->cap = 0;
+    w->pathCap = 0;
+}
+
+// ============================================================================
+// Parallel File Processing
+// ============================================================================
+
+#define CHRIS_PATH_QUEUE_CAP 1024
+#define CHRIS_MAX_FILE_WORKERS 64
+
+typedef void (*chris_path_fn)(const char*, ChrisClosure*);
+
+// Bounded queue between the walking thread and the workers. Queued paths
+// are malloc'd: nothing roots them until a worker picks them up.
+typedef struct {
+    char* items[CHRIS_PATH_QUEUE_CAP];
+    int head, tail, count;
+    int closed;
+    ChrisClosure* fn;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} chris_path_queue;
+
+// Call fn with a GC copy of path, rooted on this thread's shadow stack
+static void chris_run_path_fn(ChrisClosure* fn, char* path) {
+    size_t len = strlen(path);
+    char* gcPath = (char*)chris_gc_alloc(len + 1, GC_STRING);
+    memcpy(gcPath, path, len + 1);
+    free(path);
+    chris_gc_push_root((void**)&gcPath);
+    ((chris_path_fn)fn->code)(gcPath, fn);
+    chris_gc_pop_root();
+}
+
+static void* chris_file_worker(void* arg) {
+    chris_path_queue* q = (chris_path_queue*)arg;
+    chris_profile_register_thread();
+    for (;;) {
+        pthread_mutex_lock(&q->mutex);
+        while (q->count == 0 && !q->closed) {
+            pthread_cond_wait(&q->not_empty, &q->mutex);
+        }
+        if (q->count == 0) {
+            pthread_mutex_unlock(&q->mutex);
+            return NULL;
+        }
+        char* path = q->items[q->head];
+        q->head = (q->head + 1) % CHRIS_PATH_QUEUE_CAP;
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+        pthread_mutex_unlock(&q->mutex);
+        chris_run_path_fn(q->fn, path);
+    }
+}
+
+// Walk `root` and call the closure fn(path) for every file whose name
+// matches pattern, on a pool of one worker per online CPU. Returns the number
+// of files handed out, or -1 if root cannot be opened. Collection is deferred
+// until the workers have finished: threads are not stopped for a collection,
+// so one worker's fresh, not yet rooted allocations could be swept by
+// another's.
+long long chris_parallel_for_each_file(const char* root, const char* pattern, void* fn) {
+    if (!fn) return -1;
+    void* walker = chris_walk_open(root, pattern);
+    if (!walker) return -1;
+
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int nworkers = ncpu > 0 ? (int)ncpu : 1;
+    if (nworkers > CHRIS_MAX_FILE_WORKERS) nworkers = CHRIS_MAX_FILE_WORKERS;
+
+    chris_path_queue* q = (chris_path_queue*)calloc(1, sizeof(chris_path_queue));
+    if (!q) {
+        chris_walk_close(walker);
+        return -1;
+    }
+    q->fn = (ChrisClosure*)fn;
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+
+    chris_gc_defer_begin();
+
+    pthread_t threads[CHRIS_MAX_FILE_WORKERS];
+    int started = 0;
+    for (int i = 0; i < nworkers; i++) {
+        if (pthread_create(&threads[started], NULL, chris_file_worker, q) == 0) started++;
+    }
+
+    long long total = 0;
+    const char* next;
+    while ((next = chris_walk_next_path(walker)) != NULL) {
+        char* path = strdup(next);
+        if (!path) {
+            fprintf(stderr, "Error: failed to allocate path\n");
+            exit(1);
+        }
+        if (started == 0) {
+            chris_run_path_fn(q->fn, path); // no threads available: run inline
+            total++;
+            continue;
+        }
+        pthread_mutex_lock(&q->mutex);
+        while (q->count == CHRIS_PATH_QUEUE_CAP) {
+            pthread_cond_wait(&q->not_full, &q->mutex);
+        }
+        q->items[q->tail] = path;
+        q->tail = (q->tail + 1) % CHRIS_PATH_QUEUE_CAP;
+        q->count++;
+        pthread_cond_signal(&q->not_empty);
+        pthread_mutex_unlock(&q->mutex);
+        total++;
+    }
+    chris_walk_close(walker);
+
+    pthread_mutex_lock(&q->mutex);
+    q->closed = 1;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_mutex_unlock(&q->mutex);
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    chris_gc_defer_end();
+
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    free(q);
+    return total;
 }
 
 // ============================================================================
@@ -992,8 +2610,9 @@ int chris_file_exists(const char* path) {
 #define CHRIS_TASK_RUNNING   1
 #define CHRIS_TASK_COMPLETED 2
 
-// Thunk function type: takes void* args, returns i64 result
-typedef long long (*chris_thunk_fn)(void*);
+// Thunk function type: unpacks its arguments and writes the function's
+// result, at the result type's own width, to the slot it is given
+typedef void (*chris_thunk_fn)(void* args, void* result);
 
 // Future/Task structure
 typedef struct chris_future {
@@ -1001,10 +2620,11 @@ typedef struct chris_future {
     void*          args;       // packed arguments pointer
     int            kind;       // CHRIS_ASYNC_IO or CHRIS_ASYNC_COMPUTE
     int            state;      // CHRIS_TASK_PENDING/RUNNING/COMPLETED
-    long long      result;     // return value (valid when state == COMPLETED)
+    long long      result_size;
     pthread_t      thread;     // thread handle
     pthread_mutex_t mutex;     // protects state and result
     pthread_cond_t  cond;      // signaled when task completes
+    _Alignas(16) unsigned char result[]; // return value (valid when state == COMPLETED)
 } chris_future;
 
 // Global task registry for run_loop
@@ -1024,16 +2644,16 @@ static void chris_register_task(chris_future* f) {
 // Thread entry point
 static void* chris_async_thread_entry(void* arg) {
     chris_future* f = (chris_future*)arg;
+    chris_profile_register_thread();
 
     pthread_mutex_lock(&f->mutex);
     f->state = CHRIS_TASK_RUNNING;
     pthread_mutex_unlock(&f->mutex);
 
-    // Execute the thunk
-    long long res = f->func(f->args);
+    // Execute the thunk; only this thread touches the result until completion
+    f->func(f->args, f->result);
 
     pthread_mutex_lock(&f->mutex);
-    f->result = res;
     f->state = CHRIS_TASK_COMPLETED;
     pthread_cond_signal(&f->cond);
     pthread_mutex_unlock(&f->mutex);
@@ -1044,9 +2664,9 @@ static void* chris_async_thread_entry(void* arg) {
     return NULL;
 }
 
-// chris_async_spawn(func_ptr, arg_ptr, kind) -> Future*
-void* chris_async_spawn(void* func_ptr, void* arg_ptr, int kind) {
-    chris_future* f = (chris_future*)malloc(sizeof(chris_future));
+// chris_async_spawn(func_ptr, arg_ptr, kind, result_size) -> Future*
+void* chris_async_spawn(void* func_ptr, void* arg_ptr, int kind, long long result_size) {
+    chris_future* f = (chris_future*)calloc(1, sizeof(chris_future) + (size_t)result_size);
     if (!f) {
         fprintf(stderr, "Error: failed to allocate async task\n");
         exit(1);
@@ -1056,7 +2676,7 @@ void* chris_async_spawn(void* func_ptr, void* arg_ptr, int kind) {
     f->args   = arg_ptr;
     f->kind   = kind;
     f->state  = CHRIS_TASK_PENDING;
-    f->result = 0;
+    f->result_size = result_size;
     pthread_mutex_init(&f->mutex, NULL);
     pthread_cond_init(&f->cond, NULL);
 
@@ -1074,17 +2694,18 @@ void* chris_async_spawn(void* func_ptr, void* arg_ptr, int kind) {
     return (void*)f;
 }
 
-// chris_async_await(Future*) -> i64
-long long chris_async_await(void* future_ptr) {
+// chris_async_await(Future*, out) -> void
+// Copies the result to `out`, which holds result_size bytes
+void chris_async_await(void* future_ptr, void* out) {
     chris_future* f = (chris_future*)future_ptr;
-    if (!f) return 0;
+    if (!f) return;
 
     // Wait for the task to complete
     pthread_mutex_lock(&f->mutex);
     while (f->state != CHRIS_TASK_COMPLETED) {
         pthread_cond_wait(&f->cond, &f->mutex);
     }
-    long long result = f->result;
+    if (out) memcpy(out, f->result, (size_t)f->result_size);
     pthread_mutex_unlock(&f->mutex);
 
     // Join the thread to clean up
@@ -1094,8 +2715,6 @@ long long chris_async_await(void* future_ptr) {
     pthread_mutex_destroy(&f->mutex);
     pthread_cond_destroy(&f->cond);
     free(f);
-
-    return result;
 }
 
 // chris_async_run_loop() -> void
@@ -1558,7 +3177,7 @@ typedef struct {
 
 void* chris_cmap_create(void) {
     chris_concurrent_map* cm = (chris_concurrent_map*)malloc(sizeof(chris_concurrent_map));
-    cm->map = (chris_map*)chris_map_create();
+    cm->map = (chris_map*)chris_map_create(sizeof(long long));
     pthread_mutex_init(&cm->mutex, NULL);
     return cm;
 }
@@ -1566,14 +3185,16 @@ void* chris_cmap_create(void) {
 void chris_cmap_set(void* handle, const char* key, long long value) {
     chris_concurrent_map* cm = (chris_concurrent_map*)handle;
     pthread_mutex_lock(&cm->mutex);
-    chris_map_set(cm->map, key, value);
+    long long* slot = (long long*)chris_map_slot(cm->map, key);
+    if (slot) *slot = value;
     pthread_mutex_unlock(&cm->mutex);
 }
 
 long long chris_cmap_get(void* handle, const char* key) {
     chris_concurrent_map* cm = (chris_concurrent_map*)handle;
     pthread_mutex_lock(&cm->mutex);
-    long long val = chris_map_get(cm->map, key);
+    long long* slot = (long long*)chris_map_find(cm->map, key);
+    long long val = slot ? *slot : 0;
     pthread_mutex_unlock(&cm->mutex);
     return val;
 }
@@ -2276,50 +3897,3 @@ void* chris_alloc(long long size) {
 void chris_free(void* ptr) {
     free(ptr);
 }
-
-// ==================== Sized Pointer Load/Store ====================
-
-long long chris_ptr_load_i32(void* ptr) {
-    if (!ptr) return 0;
-    return (long long)(*(int32_t*)ptr);
-}
-
-void chris_ptr_store_i32(void* ptr, long long val) {
-    if (!ptr) return;
-    *(int32_t*)ptr = (int32_t)val;
-}
-
-long long chris_ptr_load_i16(void* ptr) {
-    if (!ptr) return 0;
-    return (long long)(*(int16_t*)ptr);
-}
-
-void chris_ptr_store_i16(void* ptr, long long val) {
-    if (!ptr) return;
-    *(int16_t*)ptr = (int16_t)val;
-}
-
-long long chris_ptr_load_f64(void* ptr) {
-    if (!ptr) return 0;
-    double d = *(double*)ptr;
-    long long result;
-    memcpy(&result, &d, sizeof(double));
-    return result;
-}
-
-void chris_ptr_store_f64(void* ptr, double val) {
-    if (!ptr) return;
-    *(double*)ptr = val;
-}
-
-void chris_memcpy(void* dst, void* src, long long count) {
-    if (dst && src && count > 0) {
-        memcpy(dst, src, (size_t)count);
-    }
-}
-
-void chris_memset(void* dst, long long val, long long count) {
-    if (dst && count > 0) {
-        memset(dst, (int)val, (size_t)count);
-    }
-}
@@ -284,6 +284,15 @@ std::string FuncDecl::toString(int indent) const {
         else if (asyncKind == AsyncKind::Compute) result += "compute ";
     }
     result += name;
+    if (!typeParams.empty()) {
+        result += "<";
+        for (size_t i = 0; i < typeParams.size(); i++) {
+            if (i > 0) result += ", ";
+            result += typeParams[i];
+            if (!typeParamBounds[i].empty()) result += ": " + typeParamBounds[i];
+        }
+        result += ">";
+    }
     result += "\n" + indentStr(indent + 1) + "(Params";
     for (const auto& p : parameters) {
         result += "\n" + indentStr(indent + 2) + "(Param " + p.name;
@@ -324,7 +333,7 @@ std::string ImportDecl::toString(int indent) const {
 }
 
 std::string ClassDecl::toString(int indent) const {
-    std::string result = indentStr(indent) + "(ClassDecl " + (isPublic ? "public " : "") + (isShared ? "shared " : "") + name;
+    std::string result = indentStr(indent) + "(ClassDecl " + (isPublic ? "public " : "") + (isShared ? "shared " : "") + (isStruct ? "struct " : "") + name;
     if (!typeParams.empty()) {
         result += "<";
         for (size_t i = 0; i < typeParams.size(); i++) {
@@ -12,6 +12,7 @@ namespace chris {
 struct Expr;
 struct Stmt;
 struct TypeExpr;
+struct Type; // semantic type (sema/types.h)
 
 using ExprPtr = std::unique_ptr<Expr>;
 using StmtPtr = std::unique_ptr<Stmt>;
@@ -52,6 +53,7 @@ enum class AccessModifier { Private, Protected, Public };
 
 struct Expr {
     SourceLocation location;
+    std::shared_ptr<Type> type; // set by the type checker
     virtual ~Expr() = default;
     virtual std::string toString(int indent = 0) const = 0;
 };
@@ -113,12 +115,15 @@ struct UnaryExpr : Expr {
 struct CallExpr : Expr {
     ExprPtr callee;
     std::vector<ExprPtr> arguments;
+    std::vector<std::shared_ptr<Type>> typeArgs; // inferred for generic callees, set by the type checker
+    std::shared_ptr<Type> calleeType; // function type of the callee, set by the type checker
     std::string toString(int indent = 0) const override;
 };
 
 struct MemberExpr : Expr {
     ExprPtr object;
     std::string member;
+    std::string receiverType; // static class or interface of object, set by the type checker
     std::string toString(int indent = 0) const override;
 };
 
@@ -176,6 +181,7 @@ struct StringInterpolationExpr : Expr {
 // Array literal: [1, 2, 3]
 struct ArrayLiteralExpr : Expr {
     std::vector<ExprPtr> elements;
+    std::shared_ptr<Type> elementType; // set by the type checker
     std::string toString(int indent = 0) const override;
 };
 
@@ -196,6 +202,9 @@ struct LambdaExpr : Expr {
     std::vector<LambdaParam> params;
     ExprPtr bodyExpr;                    // for single-expression lambdas
     std::unique_ptr<struct Block> bodyBlock; // for multi-line lambdas
+    std::vector<std::string> captures;   // enclosing locals the body reads, set by the type checker
+    bool escapes = true;                 // false when the closure provably dies with its creating frame
+    std::shared_ptr<Type> functionType;  // inferred (params) -> ret, set by the type checker
     std::string toString(int indent = 0) const override;
 };
 
@@ -312,6 +321,8 @@ struct FuncDecl : Stmt {
     bool isOperator = false; // true for operator overloads (e.g. operator+)
     bool isAsync = false; // true for async functions
     AsyncKind asyncKind = AsyncKind::None; // io or compute annotation
+    std::vector<std::string> typeParams; // generic type parameters, e.g. <T, U>
+    std::vector<std::string> typeParamBounds; // bound per type parameter ("" if unbounded)
     std::vector<Parameter> parameters;
     TypeExprPtr returnType; // optional (Void if absent)
     std::unique_ptr<Block> body;
@@ -336,6 +347,7 @@ struct ClassDecl : Stmt {
     std::vector<Annotation> annotations;
     bool isPublic = false;
     bool isShared = false; // true for shared classes (thread-safe synchronized access)
+    bool isStruct = false; // true for structs (value types: copied, never heap-allocated)
     std::vector<std::string> typeParams; // generic type parameters, e.g. <T, U>
     std::string baseClass;  // empty if no inheritance
     std::vector<std::string> interfaces; // implemented interfaces
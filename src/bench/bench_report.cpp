@@ -0,0 +1,67 @@
+#include "bench/bench_report.h"
+#include <cstdlib>
+#include <sstream>
+#include "common/diagnostic.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+
+namespace chris {
+
+std::string reportField(const std::string& line, const std::string& key) {
+    std::string marker = "\"" + key + "\":";
+    auto pos = line.find(marker);
+    if (pos == std::string::npos) return "";
+    pos += marker.size();
+    if (pos < line.size() && line[pos] == '"') {
+        auto end = line.find('"', pos + 1);
+        while (end != std::string::npos && line[end - 1] == '\\') end = line.find('"', end + 1);
+        return end == std::string::npos ? "" : line.substr(pos + 1, end - pos - 1);
+    }
+    auto end = line.find_first_of(",}", pos);
+    return line.substr(pos, end - pos);
+}
+
+std::string benchBaselineKey(const std::string& file, const std::string& name) {
+    // Escaping leaves slashes and dots alone, so the escaped path normalises
+    // like the path itself
+    llvm::SmallString<128> path(file);
+    llvm::sys::path::remove_dots(path, true, llvm::sys::path::Style::posix);
+    return std::string(path.str()) + "\t" + name;
+}
+
+std::map<std::string, double> parseBenchBaseline(const std::string& report) {
+    std::map<std::string, double> baseline;
+    std::istringstream lines(report);
+    std::string line;
+    while (std::getline(lines, line)) {
+        std::string name = reportField(line, "name");
+        std::string ns = reportField(line, "ns_per_op");
+        if (name.empty() || ns.empty()) continue;
+        baseline[benchBaselineKey(reportField(line, "file"), name)] = std::strtod(ns.c_str(), nullptr);
+    }
+    return baseline;
+}
+
+std::vector<const BenchResult*> applyBenchBaseline(std::vector<BenchResult>& results,
+                                                   const std::map<std::string, double>& baseline) {
+    std::vector<const BenchResult*> missing;
+    for (auto& result : results) {
+        auto it = baseline.find(benchBaselineKey(escapeJson(result.file), escapeJson(result.name)));
+        if (it == baseline.end()) {
+            missing.push_back(&result);
+            continue;
+        }
+        result.baselineNsPerOp = it->second;
+    }
+    return missing;
+}
+
+double benchChange(const BenchResult& result) {
+    return (result.nsPerOp - result.baselineNsPerOp) / result.baselineNsPerOp * 100.0;
+}
+
+bool isBenchRegression(const BenchResult& result, double maxRegression) {
+    return result.baselineNsPerOp > 0 && benchChange(result) > maxRegression;
+}
+
+} // namespace chris
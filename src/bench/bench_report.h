@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace chris {
+
+// `chris bench --output json` writes one benchmark per line, so a report
+// diffs cleanly and a later run can read it back with --baseline.
+// Benchmarks are matched with their baseline by file and name; files are
+// compared with `.` and `..` segments and repeated slashes removed, so
+// `bench/x.chr` and `./bench/x.chr` are the same benchmark file.
+
+struct BenchResult {
+    std::string file;
+    std::string name;
+    long long iterations = 0;
+    double nsPerOp = 0;
+    double allocsPerOp = 0;
+    double bytesPerOp = 0;
+    double collectionsPerOp = 0;
+    double baselineNsPerOp = -1; // < 0: not in the baseline
+};
+
+// The raw text of `"key":value` in one line of a report, quotes stripped
+std::string reportField(const std::string& line, const std::string& key);
+
+// What a benchmark is looked up under, from its JSON-escaped file and name
+std::string benchBaselineKey(const std::string& file, const std::string& name);
+
+// ns/op of every benchmark in the text of a report, by benchBaselineKey
+std::map<std::string, double> parseBenchBaseline(const std::string& report);
+
+// Set each result's baselineNsPerOp from `baseline`. Returns the results it
+// has no entry for.
+std::vector<const BenchResult*> applyBenchBaseline(std::vector<BenchResult>& results,
+                                                   const std::map<std::string, double>& baseline);
+
+// Change in ns/op from the baseline, in percent
+double benchChange(const BenchResult& result);
+
+// Slower than its baseline by more than maxRegression percent
+bool isBenchRegression(const BenchResult& result, double maxRegression);
+
+} // namespace chris
@@ -0,0 +1,252 @@
+#include "cache/module_cache.h"
+#include <fstream>
+#include <sstream>
+#include "common/source_file.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/SHA1.h"
+
+namespace chris {
+
+static std::string annotationsOf(const std::vector<Annotation>& annotations) {
+    std::string result;
+    for (auto& ann : annotations) {
+        result += "@" + ann.name;
+        for (auto& arg : ann.arguments) result += " \"" + arg + "\"";
+        result += " ";
+    }
+    return result;
+}
+
+static std::string accessOf(AccessModifier access) {
+    switch (access) {
+        case AccessModifier::Public: return "public ";
+        case AccessModifier::Protected: return "protected ";
+        case AccessModifier::Private: return "";
+    }
+    return "";
+}
+
+static std::string typeParamsOf(const std::vector<std::string>& params,
+                                const std::vector<std::string>& bounds = {}) {
+    if (params.empty()) return "";
+    std::string result = "<";
+    for (size_t i = 0; i < params.size(); i++) {
+        if (i > 0) result += ", ";
+        result += params[i];
+        if (i < bounds.size() && !bounds[i].empty()) result += ": " + bounds[i];
+    }
+    return result + ">";
+}
+
+static std::string signatureOf(const std::vector<Parameter>& params, const TypeExprPtr& returnType) {
+    std::string result = "(";
+    for (size_t i = 0; i < params.size(); i++) {
+        if (i > 0) result += ", ";
+        result += params[i].name + ": " + (params[i].type ? params[i].type->toString() : "?");
+    }
+    result += ")";
+    if (returnType) result += " -> " + returnType->toString();
+    return result;
+}
+
+static std::string funcInterface(const FuncDecl& func) {
+    std::string result = annotationsOf(func.annotations) + accessOf(func.access);
+    if (func.isAsync) result += "async ";
+    return result + "func " + func.name + typeParamsOf(func.typeParams, func.typeParamBounds) +
+           signatureOf(func.parameters, func.returnType);
+}
+
+static std::string varInterface(const VarDecl& var) {
+    return accessOf(var.access) + (var.isMutable ? "var " : "let ") + var.name + ": " +
+           (var.typeAnnotation ? var.typeAnnotation->toString() : "?");
+}
+
+std::string declarationInterface(const Stmt& decl) {
+    std::ostringstream out;
+    if (auto* func = dynamic_cast<const FuncDecl*>(&decl)) {
+        out << funcInterface(*func) << "\n";
+    } else if (auto* ext = dynamic_cast<const ExternFuncDecl*>(&decl)) {
+        out << "extern func " << ext->name << signatureOf(ext->parameters, ext->returnType)
+            << (ext->isVariadic ? " ..." : "") << "\n";
+    } else if (auto* cls = dynamic_cast<const ClassDecl*>(&decl)) {
+        out << annotationsOf(cls->annotations) << (cls->isPublic ? "public " : "")
+            << (cls->isShared ? "shared " : "") << (cls->isStruct ? "struct " : "class ")
+            << cls->name << typeParamsOf(cls->typeParams);
+        if (!cls->baseClass.empty()) out << " : " << cls->baseClass;
+        for (auto& iface : cls->interfaces) out << " + " << iface;
+        out << "\n";
+        for (auto& field : cls->fields) out << "    " << varInterface(*field) << "\n";
+        for (auto& method : cls->methods) out << "    " << funcInterface(*method) << "\n";
+    } else if (auto* iface = dynamic_cast<const InterfaceDecl*>(&decl)) {
+        out << annotationsOf(iface->annotations) << "interface " << iface->name << "\n";
+        for (auto& method : iface->methods) out << "    " << funcInterface(*method) << "\n";
+    } else if (auto* enm = dynamic_cast<const EnumDecl*>(&decl)) {
+        out << annotationsOf(enm->annotations) << "enum " << enm->name << "\n";
+        for (auto& variant : enm->variants) {
+            out << "    " << variant.name;
+            if (variant.associatedType) out << "(" << variant.associatedType->toString() << ")";
+            out << "\n";
+        }
+        for (auto& name : enm->cases) out << "    case " << name << "\n";
+    } else if (auto* var = dynamic_cast<const VarDecl*>(&decl)) {
+        out << varInterface(*var) << "\n";
+    } else if (auto* imp = dynamic_cast<const ImportDecl*>(&decl)) {
+        out << "import " << imp->path << "\n";
+    } else {
+        out << decl.toString() << "\n";
+    }
+    return out.str();
+}
+
+static bool sharesBody(const FuncDecl& func) {
+    if (!func.typeParams.empty()) return true;
+    for (auto& ann : func.annotations) {
+        if (ann.name == "Inline" || ann.name == "Pure" || ann.name == "ReadOnly") return true;
+    }
+    return false;
+}
+
+bool exposesBody(const Stmt& decl) {
+    if (auto* func = dynamic_cast<const FuncDecl*>(&decl)) return sharesBody(*func);
+    if (auto* cls = dynamic_cast<const ClassDecl*>(&decl)) {
+        if (!cls->typeParams.empty()) return true;
+        for (auto& field : cls->fields) {
+            if (field->initializer) return true;
+        }
+        for (auto& method : cls->methods) {
+            if (sharesBody(*method)) return true;
+        }
+        return false;
+    }
+    if (auto* var = dynamic_cast<const VarDecl*>(&decl)) return var->initializer != nullptr;
+    return !dynamic_cast<const ExternFuncDecl*>(&decl) && !dynamic_cast<const InterfaceDecl*>(&decl) &&
+           !dynamic_cast<const EnumDecl*>(&decl) && !dynamic_cast<const ImportDecl*>(&decl);
+}
+
+ModuleCache::ModuleCache(const std::string& dir) : dir_(dir) {}
+
+std::string ModuleCache::hash(const std::string& data) {
+    return llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(data)), true);
+}
+
+std::string ModuleCache::summaryPath(const std::string& file) const {
+    return dir_ + "/" + hash(file) + ".iface";
+}
+
+// One warning per line: code, line, column, file and message, tab-separated
+std::string ModuleCache::warningsPath(const std::string& key) const {
+    return dir_ + "/" + key + ".warnings";
+}
+
+static std::vector<Diagnostic> readWarnings(const std::string& path) {
+    std::vector<Diagnostic> warnings;
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (int i = 0; i < 4; i++) {
+            size_t tab = line.find('\t', start);
+            if (tab == std::string::npos) break;
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        if (fields.size() != 4) continue;
+        Diagnostic warning;
+        warning.code = fields[0];
+        warning.severity = DiagnosticSeverity::Warning;
+        warning.location = SourceLocation(fields[3], std::stoul(fields[1]), std::stoul(fields[2]));
+        warning.message = line.substr(start);
+        warnings.push_back(warning);
+    }
+    return warnings;
+}
+
+bool ModuleCache::plan(const Program& program, const std::string& entryFile,
+                       const std::vector<std::string>& instantiations, const std::string& options,
+                       std::vector<ModuleUnit>& units) {
+    // Files in the order their declarations were merged, each with its summary
+    std::vector<std::string> files;
+    std::vector<std::string> interfaces;
+    std::vector<bool> exposed;
+    auto indexOf = [&](const std::string& file) {
+        for (size_t i = 0; i < files.size(); i++) {
+            if (files[i] == file) return i;
+        }
+        files.push_back(file);
+        interfaces.emplace_back();
+        exposed.push_back(false);
+        return files.size() - 1;
+    };
+    indexOf(entryFile);
+    for (auto& decl : program.declarations) {
+        size_t i = indexOf(decl->location.file);
+        interfaces[i] += declarationInterface(*decl);
+        if (exposesBody(*decl)) exposed[i] = true;
+    }
+
+    std::vector<std::string> sources;
+    std::string programInterface;
+    summaries_.clear();
+    for (size_t i = 0; i < files.size(); i++) {
+        SourceFile source(files[i]);
+        if (!source.load()) return false;
+        sources.push_back(source.content());
+        if (exposed[i]) interfaces[i] += "source " + hash(source.content()) + "\n";
+        programInterface += "module " + files[i] + "\n" + interfaces[i];
+        summaries_.emplace_back(files[i], interfaces[i]);
+    }
+
+    if (!llvm::sys::fs::is_directory(dir_) && llvm::sys::fs::create_directories(dir_)) return false;
+
+    units.clear();
+    for (size_t i = 0; i < files.size(); i++) {
+        ModuleUnit unit;
+        unit.file = files[i];
+        unit.isEntry = files[i] == entryFile;
+        std::string keyData = options + '\0' + files[i] + '\0' + sources[i] + '\0' + programInterface;
+        if (unit.isEntry) {
+            for (auto& name : instantiations) keyData += '\0' + name;
+        }
+        unit.key = hash(keyData);
+        unit.objectPath = dir_ + "/" + unit.key + ".o";
+        unit.cached = llvm::sys::fs::exists(unit.objectPath);
+        if (unit.cached) unit.warnings = readWarnings(warningsPath(unit.key));
+        units.push_back(unit);
+    }
+    return true;
+}
+
+bool ModuleCache::commit(const ModuleUnit& unit, const std::string& builtObject,
+                         const std::vector<Diagnostic>& warnings) {
+    if (llvm::sys::fs::rename(builtObject, unit.objectPath)) return false;
+
+    std::string path = summaryPath(unit.file);
+    std::ifstream previous(path);
+    std::string line;
+    if (previous && std::getline(previous, line) && line.rfind("key ", 0) == 0 &&
+        line.substr(4) != unit.key) {
+        llvm::sys::fs::remove(dir_ + "/" + line.substr(4) + ".o");
+        llvm::sys::fs::remove(warningsPath(line.substr(4)));
+    }
+    previous.close();
+
+    std::ofstream saved(warningsPath(unit.key));
+    for (auto& warning : warnings) {
+        if (warning.severity != DiagnosticSeverity::Warning) continue;
+        saved << warning.code << '\t' << warning.location.line << '\t' << warning.location.column
+              << '\t' << warning.location.file << '\t' << warning.message << '\n';
+    }
+    if (!saved.good()) return false;
+    saved.close();
+
+    std::ofstream summary(path);
+    summary << "key " << unit.key << "\n" << "file " << unit.file << "\n";
+    for (auto& [file, interface] : summaries_) {
+        if (file == unit.file) summary << interface;
+    }
+    return summary.good();
+}
+
+} // namespace chris
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ast/ast.h"
+#include "common/diagnostic.h"
+
+namespace chris {
+
+// Incremental builds. Every build still parses and checks the whole program,
+// but each .chr file is compiled to its own object file, cached in
+// .chris-cache/ under a hash of the file's source and of the program's
+// interface. The interface is one summary per file: the signatures of its
+// declarations, its class layouts and hierarchy, and, for files whose bodies
+// other units also compile (generic templates, @Inline, @Pure and @ReadOnly
+// functions, global initializers), a hash of the whole file. Editing any
+// other function body recompiles only the file it is in.
+
+// What other files see of a top-level declaration
+std::string declarationInterface(const Stmt& decl);
+
+// Whether units other than its own compile part of `decl`'s body
+bool exposesBody(const Stmt& decl);
+
+struct ModuleUnit {
+    std::string file;
+    bool isEntry = false;   // holds main(), globals and generic instantiations
+    std::string key;        // hash the object is cached under
+    std::string objectPath;
+    bool cached = false;    // objectPath is already up to date
+    std::vector<Diagnostic> warnings; // reported when a cached object was built
+};
+
+class ModuleCache {
+public:
+    explicit ModuleCache(const std::string& dir);
+
+    // One unit per file that declares something in `program`, entry file
+    // included. `options` names everything else the objects depend on
+    // (compiler, debug info level). Fails if a file can no longer be read.
+    bool plan(const Program& program, const std::string& entryFile,
+              const std::vector<std::string>& instantiations, const std::string& options,
+              std::vector<ModuleUnit>& units);
+
+    // Move a freshly built object into place and write the file's interface
+    // summary and the warnings its compilation reported next to it; the
+    // object built from its previous contents is deleted
+    bool commit(const ModuleUnit& unit, const std::string& builtObject,
+                const std::vector<Diagnostic>& warnings = {});
+
+    static std::string hash(const std::string& data);
+
+private:
+    std::string summaryPath(const std::string& file) const;
+    std::string warningsPath(const std::string& key) const;
+
+    std::string dir_;
+    std::vector<std::pair<std::string, std::string>> summaries_; // file -> interface
+};
+
+} // namespace chris
@@ -4,7 +4,9 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <memory>
+#include <optional>
 
+#include "llvm/IR/DIBuilder.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -15,8 +17,24 @@
 #include "sema/types.h"
 #include "common/diagnostic.h"
 
+namespace llvm {
+class MemoryBuffer;
+class TargetMachine;
+namespace orc {
+class LLJIT;
+}
+}
+
 namespace chris {
 
+// DWARF emitted by `chris build -g` / `-gline-tables-only`. Line tables
+// are emitted at every level for stack traces; None keeps frame pointers off
+enum class DebugInfoLevel {
+    None,
+    LineTablesOnly, // subprograms and line locations only
+    Full,           // plus parameters and local variables
+};
+
 class CodeGen {
 public:
     CodeGen(const std::string& moduleName, DiagnosticEngine& diagnostics);
@@ -27,13 +45,42 @@ public:
     bool linkExecutable(const std::string& objectPath, const std::string& runtimePath,
                         const std::string& outputPath,
                         const std::vector<std::string>& extraFlags = {});
+    bool linkExecutable(const std::vector<std::string>& objectPaths, const std::string& runtimePath,
+                        const std::string& outputPath,
+                        const std::vector<std::string>& extraFlags = {});
+    // Compile the module in memory and call its main(), resolving runtime
+    // functions in this process. The module is handed to the JIT, so
+    // nothing else may be done with it afterwards.
+    bool runJIT(int& exitCode);
     std::string getIR() const;
+    void setDebugInfoLevel(DebugInfoLevel level) { debugInfoLevel_ = level; }
+    // Insert entry/exit hooks in every function not marked @NoInstrument
+    void setInstrumentFunctions(bool enabled) { instrumentFunctions_ = enabled; }
+    // IR-level PGO: instrument so the program writes default_<pid>.profraw
+    // into `dir` (the working directory when empty), or optimise with the
+    // counts merged into a .profdata file
+    void setProfileGenerate(const std::string& dir) { profileGenerate_ = true; profileDir_ = dir; }
+    void setProfileUse(const std::string& path) { profileUse_ = path; }
+    // Separate compilation: generate only the bodies declared in `file` and
+    // declare everything else. Other files' @Inline, @Pure and @ReadOnly
+    // functions are copied in as available_externally so they can still be
+    // inlined and checked. The entry unit also owns main(), the global
+    // variables and every generic instantiation.
+    void setCompilationUnit(const std::string& file, bool isEntry) {
+        unitFile_ = file;
+        unitIsEntry_ = isEntry;
+    }
+    // Hashes of the running compiler and of the runtime library at
+    // runtimePath, so cached objects are rebuilt after either changes and
+    // identical builds share them
+    static std::string compilerId(const std::string& runtimePath);
 
     llvm::Module& module() { return *module_; }
 
 private:
     // Declarations
-    void emitFuncDecl(FuncDecl& func);
+    llvm::Function* declareFuncDecl(FuncDecl& func, const std::string& symbolName);
+    void emitFuncDecl(FuncDecl& func, const std::string& symbolName = "");
     void emitClassDecl(ClassDecl& decl);
 
     // Statements
@@ -43,11 +90,13 @@ private:
     void emitIfStmt(IfStmt& stmt);
     void emitWhileStmt(WhileStmt& stmt);
     void emitForStmt(ForStmt& stmt);
+    void emitStreamForLoop(ForStmt& stmt, llvm::Value* handle, llvm::Function* next);
     void emitReturnStmt(ReturnStmt& stmt);
     void emitExprStmt(ExprStmt& stmt);
 
     // Expressions — returns the LLVM Value
     llvm::Value* emitExpr(Expr& expr);
+    llvm::Value* emitExprNode(Expr& expr);
     llvm::Value* emitIntLiteral(IntLiteralExpr& expr);
     llvm::Value* emitFloatLiteral(FloatLiteralExpr& expr);
     llvm::Value* emitStringLiteral(StringLiteralExpr& expr);
@@ -68,13 +117,82 @@ private:
     llvm::Value* emitOptionalChainExpr(OptionalChainExpr& expr);
     llvm::Value* emitMatchExpr(MatchExpr& expr);
     llvm::Value* emitLambdaExpr(LambdaExpr& expr);
+    llvm::Value* emitInlineArrayLoop(CallExpr& call, llvm::Value* arrPtr, llvm::Type* elemType,
+                                     LambdaExpr* lambda, llvm::Value* callback, llvm::Value* initial);
+    llvm::Value* emitInlineLambdaBody(LambdaExpr& lambda, const std::vector<llvm::Value*>& args,
+                                      llvm::Type* resultType);
     llvm::Value* emitArrayLiteralExpr(ArrayLiteralExpr& expr);
     llvm::Value* emitIndexExpr(IndexExpr& expr);
+
+    // Array element storage
+    std::shared_ptr<Type> numericElementType(TypeExpr* elemType);
+    llvm::Type* elementStorageType(const std::shared_ptr<Type>& elemType);
+    void trackArrayElements(const std::string& name, const std::shared_ptr<Type>& elemType);
+    llvm::Value* emitArrayAddress(Expr& arrayExpr);
+    void trackArrayElements(const std::string& name, const Expr& arrayExpr);
+    std::shared_ptr<Type> arrayElementOf(const Expr& arrayExpr);
+    llvm::Type* arrayElemType(const Expr& arrayExpr);
+    std::optional<bool> byteElements(const Expr& arrayExpr);
+    llvm::Type* arrayValueType(const Expr& arrayExpr);
+    llvm::Value* loadArrayElement(const Expr& arrayExpr, llvm::Type* elemType, llvm::Value* elemPtr);
+    llvm::Type* mapValueType(const Expr& mapExpr);
+    llvm::Type* asyncResultType(const std::shared_ptr<Type>& resultType);
+    llvm::Constant* zeroValueGlobal(llvm::Type* type);
+    void storeArrayElement(llvm::Value* value, llvm::Type* elemType, llvm::Value* elemPtr);
     llvm::Value* emitIfExpr(IfExpr& expr);
     llvm::Value* emitAwaitExpr(AwaitExpr& expr);
     void emitEnumDecl(EnumDecl& decl);
     void emitThrowStmt(ThrowStmt& stmt);
     void emitTryCatchStmt(TryCatchStmt& stmt);
+    llvm::Value* getFuncEntryRootDepth(llvm::Function* func);
+    llvm::Value* emitCatchStackTrace(const std::string& varName);
+    void recordTraceEntry(llvm::Function* func, const std::string& signature,
+                          const SourceLocation& location);
+    void emitTraceTable();
+    llvm::Constant* sourceFileString(const std::string& file);
+
+    // Function instrumentation
+    bool shouldInstrument(const std::vector<Annotation>& annotations) const;
+    void emitInstrumentEnter(const std::string& name);
+    void emitInstrumentExit();
+    void emitInstrumentTable();
+
+    // Profile-guided optimisation
+    void emitProfileRegistration();
+    bool runOptimizationPipeline(llvm::TargetMachine* targetMachine);
+    void registerJITLineTables(llvm::orc::LLJIT& jit,
+                               const std::vector<std::unique_ptr<llvm::MemoryBuffer>>& objects);
+
+    // SIMD vectors (Float32x8, Int32x4, Mask8, ...)
+    llvm::Value* emitVectorCall(CallExpr& expr, MemberExpr& callee, const std::shared_ptr<Type>& type);
+    llvm::Value* emitVectorBinary(const std::string& op, llvm::Value* left, llvm::Value* right);
+    llvm::Value* convertLanes(llvm::Value* value, llvm::Type* to);
+
+    // Optimisation annotations (@Inline, @Cold, @Pure, ...)
+    void applyFunctionAnnotations(llvm::Function* llvmFunc, FuncDecl& func);
+    void applyMemoryAnnotations();
+
+    // Separate compilation (see setCompilationUnit)
+    bool ownsBody(const SourceLocation& location) const;
+    static bool sharesBody(const std::vector<Annotation>& annotations);
+    bool emitsBody(const FuncDecl& func) const;
+
+    // Array bounds checks
+    void emitBoundsCheck(Expr& object, Expr& index, llvm::Value* idxVal, llvm::Value* length);
+    void emitBoundsFailBranch(llvm::Value* inBounds, llvm::Value* idxVal, llvm::Value* length);
+    bool isUncheckedFunction(const std::vector<Annotation>& annotations) const;
+
+    // Debug info
+    void initDebugInfo();
+    llvm::DIFile* getDebugFile(const std::string& path);
+    void beginFunctionDebugInfo(llvm::Function* func, const std::string& name,
+                                const SourceLocation& location);
+    void endFunctionDebugInfo();
+    void setDebugLocation(const SourceLocation& location);
+    llvm::DIType* getDebugType(llvm::Type* type, const std::string& typeName);
+    void emitDebugDeclare(llvm::Value* storage, const std::string& name,
+                          const std::string& typeName, const SourceLocation& location,
+                          unsigned argNo = 0);
 
     // Helpers
     void declareRuntimeFunctions();
@@ -86,14 +204,48 @@ private:
     llvm::Type* getLLVMType(TypeExpr* typeExpr);
     llvm::Type* getLLVMTypeFromSema(const std::shared_ptr<Type>& type);
     llvm::Value* emitMemberStore(MemberExpr& member, llvm::Value* value);
+    llvm::Value* emitPtrLoad(llvm::Value* ptr, llvm::Type* memTy, bool byteSwap, bool isSigned,
+                             llvm::Align align = llvm::Align(1));
+    void emitPtrStore(llvm::Value* ptr, llvm::Value* val, llvm::Type* memTy, bool byteSwap,
+                      llvm::Align align = llvm::Align(1));
+    llvm::Align ptrAccessAlign(const CallExpr& expr, size_t valueArgs);
     int getFieldIndex(const std::string& className, const std::string& fieldName);
 
+    // Value-type structs
+    std::string valueStructName(llvm::Type* type) const;
+    std::string valueStructOf(Expr& expr);
+    std::string valueFieldOwner(MemberExpr& expr);
+    llvm::Value* emitValueStructAddress(Expr& expr);
+    llvm::Value* coerceStructField(llvm::Value* value, llvm::Type* fieldType);
+
+    // Dynamic dispatch
+    void emitVtables();
+    void emitVptrStore(const std::string& className, llvm::Value* obj);
+    llvm::Function* resolveMethod(const std::string& className, const std::string& method);
+    bool isSubtypeOf(const std::string& className, const std::string& typeName);
+    std::string exactClassOf(Expr& expr);
+    bool emitDynamicMethodCall(CallExpr& expr, MemberExpr& callee, llvm::Value* objPtr,
+                               llvm::Value*& result);
+
     // Generics
+    std::string genericInstanceName(const std::string& name,
+                                    const std::vector<std::shared_ptr<Type>>& typeArgs);
     void emitGenericClassInstance(ClassDecl& templateDecl,
                                   const std::string& mangledName,
                                   const std::vector<std::string>& typeParams,
                                   const std::vector<std::shared_ptr<Type>>& typeArgs);
 
+    // Closures
+    llvm::StructType* closureHeaderType();
+    llvm::Constant* closureHeader();
+    llvm::Constant* staticClosure(llvm::Function* code);
+    llvm::Constant* functionClosure(llvm::Function* func);
+    llvm::FunctionType* closureCodeType(const std::shared_ptr<Type>& type);
+    llvm::Value* emitClosureCall(llvm::Value* closure, llvm::FunctionType* codeType,
+                                 const std::vector<llvm::Value*>& args, llvm::Function* code,
+                                 const std::string& name = "lambdacall");
+    llvm::Value* coerceCallArg(llvm::Value* value, llvm::Type* paramType);
+
     // Variable storage (alloca-based)
     llvm::AllocaInst* createEntryBlockAlloca(llvm::Function* func,
                                               const std::string& name,
@@ -127,8 +279,19 @@ private:
         std::string parentClass; // empty if no inheritance
         bool isShared = false; // true for shared classes (has mutex field at index 0)
         bool isCLayout = false; // true for @CLayout classes (C-compatible, no GC)
+        bool isValue = false; // true for structs: held and passed as LLVM aggregates
+        bool hasVtable = false; // true for polymorphic classes (vtable pointer at index 0)
+        std::vector<std::string> interfaces; // interfaces named on the class itself
+        std::vector<std::string> vtableSlots; // method names in vtable slot order
+        llvm::GlobalVariable* vtable = nullptr;
+        unsigned mutexIndex() const { return hasVtable ? 1 : 0; }
     };
     std::unordered_map<std::string, ClassInfo> classInfos_;
+    struct InterfaceInfo {
+        unsigned index = 0; // itable pointer slot at the start of every vtable
+        std::vector<std::string> methodNames;
+    };
+    std::unordered_map<std::string, InterfaceInfo> interfaceInfos_;
     llvm::Value* thisPtr_ = nullptr; // current 'this' pointer in method
     std::string currentClassName_; // name of class being emitted (for member resolution)
     std::unordered_map<std::string, std::string> varClassMap_; // variable name -> class name
@@ -144,8 +307,19 @@ private:
     };
     std::unordered_map<std::string, EnumInfo> enumInfos_;
     std::unordered_map<std::string, ClassDecl*> genericClassDecls_; // generic templates for instantiation
+    std::unordered_map<std::string, FuncDecl*> genericFuncDecls_; // generic function templates
+    const GenericInstantiation* currentInstance_ = nullptr; // generic function instance being emitted
     int lambdaCounter_ = 0; // unique lambda name counter
     llvm::Type* lambdaParamTypeHint_ = nullptr; // hint for untyped lambda params (e.g. from array element type)
+    llvm::BasicBlock* inlineReturnTarget_ = nullptr; // end of a lambda body inlined into an array loop
+    llvm::AllocaInst* inlineReturnSlot_ = nullptr; // where that body's return value is stored
+    llvm::Value* asyncResultSlot_ = nullptr; // where an async thunk's return value is stored
+    llvm::Type* asyncResultType_ = nullptr;  // the type it is stored as
+    llvm::Function* lastLambdaCode_ = nullptr; // code of the last lambda emitted
+    llvm::StructType* closureHeaderType_ = nullptr; // GC header in front of static and stack closures
+    std::unordered_map<llvm::Function*, llvm::Constant*> staticClosures_; // code -> capture-free record
+    std::unordered_map<llvm::AllocaInst*, llvm::Function*> knownClosures_; // variables whose closure's code is known
+    std::unordered_map<llvm::Value*, llvm::Function*> functionClosures_; // thunk record -> the function it wraps
 
     // Runtime function declarations
     llvm::Function* runtimePrint_ = nullptr;
@@ -155,14 +329,19 @@ private:
     llvm::Function* runtimeBoolToStr_ = nullptr;
     llvm::Function* runtimeCharToStr_ = nullptr;
     llvm::Function* printfFunc_ = nullptr;
-    llvm::Function* runtimeTryBegin_ = nullptr;
-    llvm::Function* runtimeTryEnd_ = nullptr;
     llvm::Function* runtimeThrow_ = nullptr;
-    llvm::Function* runtimeGetException_ = nullptr;
-    llvm::Function* runtimeGetJmpbuf_ = nullptr;
-    llvm::Function* setjmpFunc_ = nullptr;
+    llvm::Function* runtimeBeginCatch_ = nullptr;
+    llvm::Function* runtimePersonality_ = nullptr;
+    llvm::Function* runtimeRegisterTraceTable_ = nullptr;
+    llvm::Function* runtimeAddTraceTable_ = nullptr;
+    llvm::Function* runtimeInstrumentRegister_ = nullptr;
+    llvm::Function* runtimeInstrumentEnter_ = nullptr;
+    llvm::Function* runtimeInstrumentExit_ = nullptr;
+    llvm::Function* runtimePgoRegister_ = nullptr;
+    llvm::Function* runtimeProfileAutostart_ = nullptr;
+    llvm::Function* runtimeFormatStackTrace_ = nullptr;
     llvm::Function* runtimeArrayAlloc_ = nullptr;
-    llvm::Function* runtimeArrayBoundsCheck_ = nullptr;
+    llvm::Function* runtimeArrayBoundsFail_ = nullptr;
     llvm::Function* runtimeStrToInt_ = nullptr;
     llvm::Function* runtimeStrToFloat_ = nullptr;
     llvm::Function* runtimeStrLen_ = nullptr;
@@ -177,18 +356,19 @@ private:
     llvm::Function* runtimeStrToLower_ = nullptr;
     llvm::Function* runtimeStrSplit_ = nullptr;
     llvm::Function* runtimeStrCharAt_ = nullptr;
-    llvm::Function* runtimeArrayPush_ = nullptr;
-    llvm::Function* runtimeArrayPop_ = nullptr;
+    llvm::Function* runtimeArrayPushSlot_ = nullptr;
+    llvm::Function* runtimeArrayPopSlot_ = nullptr;
     llvm::Function* runtimeArrayReverse_ = nullptr;
     llvm::Function* runtimeArrayJoin_ = nullptr;
-    llvm::Function* runtimeArrayMap_ = nullptr;
-    llvm::Function* runtimeArrayFilter_ = nullptr;
-    llvm::Function* runtimeArrayForEach_ = nullptr;
     llvm::StructType* arrayStructType_ = nullptr; // {i64 length, ptr data}
     llvm::StructType* futureStructType_ = nullptr; // opaque Future* from runtime
 
     // Track variable -> array element type for indexing
     std::unordered_map<std::string, llvm::Type*> varArrayElemType_;
+    // Arrays of Int8 (true) or UInt8 (false), stored one byte per element
+    std::unordered_map<std::string, bool> varByteArrays_;
+    // Zero constants read by lookups that find nothing, one per type
+    std::unordered_map<llvm::Type*, llvm::Constant*> zeroGlobals_;
 
     // Async runtime functions
     llvm::Function* runtimeAsyncSpawn_ = nullptr;
@@ -218,10 +398,42 @@ private:
     llvm::Function* runtimeAppendFile_ = nullptr;
     llvm::Function* runtimeFileExists_ = nullptr;
 
+    // Memory-mapped file runtime functions
+    llvm::Function* runtimeMmapOpen_ = nullptr;
+    llvm::Function* runtimeMmapData_ = nullptr;
+    llvm::Function* runtimeMmapSize_ = nullptr;
+    llvm::Function* runtimeMmapAdvise_ = nullptr;
+    llvm::Function* runtimeMmapSync_ = nullptr;
+    llvm::Function* runtimeMmapSlice_ = nullptr;
+    llvm::Function* runtimeMmapIndexOf_ = nullptr;
+    llvm::Function* runtimeMmapClose_ = nullptr;
+
+    // Buffered file stream runtime functions
+    llvm::Function* runtimeFileReaderOpen_ = nullptr;
+    llvm::Function* runtimeFileReadLine_ = nullptr;
+    llvm::Function* runtimeFileReadInto_ = nullptr;
+    llvm::Function* runtimeFileReaderClose_ = nullptr;
+    llvm::Function* runtimeFileWriterOpen_ = nullptr;
+    llvm::Function* runtimeFileWrite_ = nullptr;
+    llvm::Function* runtimeFileWriteLine_ = nullptr;
+    llvm::Function* runtimeFileWriteAll_ = nullptr;
+    llvm::Function* runtimeFileFlush_ = nullptr;
+    llvm::Function* runtimeFileWriterClose_ = nullptr;
+
+    // Filesystem metadata and traversal runtime functions
+    llvm::Function* runtimeFileSize_ = nullptr;
+    llvm::Function* runtimeFileMtime_ = nullptr;
+    llvm::Function* runtimeIsDirectory_ = nullptr;
+    llvm::Function* runtimeListDir_ = nullptr;
+    llvm::Function* runtimeWalkOpen_ = nullptr;
+    llvm::Function* runtimeWalkNext_ = nullptr;
+    llvm::Function* runtimeWalkClose_ = nullptr;
+    llvm::Function* runtimeParallelForEachFile_ = nullptr;
+
     // Map runtime functions
     llvm::Function* runtimeMapCreate_ = nullptr;
-    llvm::Function* runtimeMapSet_ = nullptr;
-    llvm::Function* runtimeMapGet_ = nullptr;
+    llvm::Function* runtimeMapSlot_ = nullptr;
+    llvm::Function* runtimeMapFind_ = nullptr;
     llvm::Function* runtimeMapHas_ = nullptr;
     llvm::Function* runtimeMapDelete_ = nullptr;
     llvm::Function* runtimeMapSize_ = nullptr;
@@ -347,12 +559,6 @@ private:
     llvm::Function* runtimeFsize_ = nullptr;
     llvm::Function* runtimeAlloc_ = nullptr;
     llvm::Function* runtimeDealloc_ = nullptr;
-    llvm::Function* runtimePtrLoadI32_ = nullptr;
-    llvm::Function* runtimePtrStoreI32_ = nullptr;
-    llvm::Function* runtimePtrLoadI16_ = nullptr;
-    llvm::Function* runtimePtrStoreI16_ = nullptr;
-    llvm::Function* runtimeMemcpy_ = nullptr;
-    llvm::Function* runtimeMemset_ = nullptr;
 
     // Test framework runtime functions
     llvm::Function* runtimeAssert_ = nullptr;
@@ -371,9 +577,81 @@ private:
     llvm::Function* runtimeGcPushRoot_ = nullptr;
     llvm::Function* runtimeGcPopRoot_ = nullptr;
     llvm::Function* runtimeGcPopRoots_ = nullptr;
+    llvm::Function* runtimeGcRootDepth_ = nullptr;
+    llvm::Function* runtimeGcRestoreRoots_ = nullptr;
 
     // Track GC root count per function for pop_roots at return
     size_t currentFuncGcRootCount_ = 0;
+
+    // Shadow-stack depth on entry to functions containing a try block. An
+    // exception may skip pushes and pops, so these functions restore the
+    // depth on return instead of popping a fixed count.
+    std::unordered_map<llvm::Function*, llvm::Value*> funcEntryRootDepth_;
+
+    // Stack-trace side table: compiled function -> source signature and
+    // declaration site, registered with the runtime from main() (or, in a
+    // unit without main, from a global constructor)
+    struct TraceEntry {
+        llvm::Function* func;
+        std::string signature;
+        SourceLocation location;
+    };
+    std::vector<TraceEntry> traceEntries_;
+    std::unordered_map<std::string, llvm::Constant*> sourceFileStrings_;
+
+    // Catch clauses being emitted, innermost last. The captured frames are
+    // only copied out of the exception if the body reads e.stackTrace.
+    struct CatchTraceSlot {
+        std::string varName;
+        llvm::AllocaInst* messageAlloca;
+        llvm::CallInst* beginCatch;
+        llvm::AllocaInst* traceAlloca = nullptr;
+    };
+    std::vector<CatchTraceSlot> catchTraceSlots_;
+
+    // Function instrumentation: hook ids index instrumentNames_, which is
+    // registered with the runtime from main(). instrumentDepth_ is what the
+    // entry hook of the function being emitted returned, which its exit
+    // hooks pass back, or null when it is not instrumented.
+    bool instrumentFunctions_ = false;
+    std::vector<std::string> instrumentNames_;
+    llvm::Value* instrumentDepth_ = nullptr;
+
+    // @Pure / @ReadOnly functions, given memory attributes after emission
+    struct MemoryAnnotation {
+        llvm::Function* func;
+        FuncDecl* decl;
+        bool pure; // @Pure; otherwise @ReadOnly
+    };
+    std::vector<MemoryAnnotation> memoryAnnotations_;
+
+    // Profile-guided optimisation (see setProfileGenerate / setProfileUse)
+    bool profileGenerate_ = false;
+    std::string profileDir_;
+    std::string profileUse_;
+
+    // The file whose bodies this module holds; empty for whole-program
+    // compilation (see setCompilationUnit)
+    std::string unitFile_;
+    bool unitIsEntry_ = true;
+
+    // Bounds-check elimination. provenIndexes_ holds the (array, loop
+    // variable) pairs that enclosing range loops keep in bounds;
+    // uncheckedDepth_ is non-zero inside unsafe blocks and @Unchecked
+    // functions, where no checks are emitted at all.
+    std::vector<std::pair<std::string, std::string>> provenIndexes_;
+    int uncheckedDepth_ = 0;
+
+    // DWARF debug info. diScope_ is the subprogram of the function being
+    // emitted; lambdas nest inside their enclosing function's emission.
+    DebugInfoLevel debugInfoLevel_ = DebugInfoLevel::None;
+    std::unique_ptr<llvm::DIBuilder> diBuilder_;
+    llvm::DICompileUnit* diCompileUnit_ = nullptr;
+    llvm::DISubprogram* diScope_ = nullptr;
+    std::vector<std::pair<llvm::DISubprogram*, llvm::DebugLoc>> diScopeStack_;
+    std::unordered_map<std::string, llvm::DIFile*> diFiles_;
+    llvm::DIType* diArrayType_ = nullptr;
+    std::unordered_map<std::string, llvm::DIType*> diStructTypes_;
 };
 
 } // namespace chris
@@ -1,4 +1,5 @@
 #include "common/diagnostic.h"
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 
@@ -26,7 +27,7 @@ std::string Diagnostic::toString() const {
     return oss.str();
 }
 
-static std::string escapeJson(const std::string& s) {
+std::string escapeJson(const std::string& s) {
     std::ostringstream oss;
     for (char c : s) {
         switch (c) {
@@ -35,7 +36,15 @@ static std::string escapeJson(const std::string& s) {
             case '\n': oss << "\\n"; break;
             case '\r': oss << "\\r"; break;
             case '\t': oss << "\\t"; break;
-            default:   oss << c; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    oss << escaped;
+                } else {
+                    oss << c;
+                }
+                break;
         }
     }
     return oss.str();
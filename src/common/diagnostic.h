@@ -7,6 +7,9 @@
 
 namespace chris {
 
+// `s` with quotes, backslashes and control characters escaped for a JSON string
+std::string escapeJson(const std::string& s);
+
 enum class DiagnosticSeverity {
     Error,
     Warning,
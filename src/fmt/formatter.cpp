@@ -149,7 +149,17 @@ std::string Formatter::formatFuncDecl(const FuncDecl& func, int indent) {
     if (func.isOperator) {
         result += "func operator" + func.name + "(";
     } else {
-        result += "func " + func.name + "(";
+        result += "func " + func.name;
+        if (!func.typeParams.empty()) {
+            result += "<";
+            for (size_t i = 0; i < func.typeParams.size(); i++) {
+                if (i > 0) result += ", ";
+                result += func.typeParams[i];
+                if (!func.typeParamBounds[i].empty()) result += ": " + func.typeParamBounds[i];
+            }
+            result += ">";
+        }
+        result += "(";
     }
 
     result += formatParams(func.parameters) + ")";
@@ -215,7 +225,7 @@ std::string Formatter::formatClassDecl(const ClassDecl& decl, int indent) {
     result += ind(indent);
     if (decl.isPublic) result += "public ";
     if (decl.isShared) result += "shared ";
-    result += "class " + decl.name;
+    result += (decl.isStruct ? "struct " : "class ") + decl.name;
 
     if (!decl.typeParams.empty()) {
         result += "<";
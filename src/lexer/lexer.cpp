@@ -8,6 +8,7 @@ const std::unordered_map<std::string, TokenType> Lexer::keywords_ = {
     {"var",       TokenType::KwVar},
     {"let",       TokenType::KwLet},
     {"class",     TokenType::KwClass},
+    {"struct",    TokenType::KwStruct},
     {"interface", TokenType::KwInterface},
     {"enum",      TokenType::KwEnum},
     {"if",        TokenType::KwIf},
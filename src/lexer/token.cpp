@@ -31,6 +31,7 @@ std::string Token::typeToString(TokenType type) {
         case TokenType::KwVar:             return "var";
         case TokenType::KwLet:             return "let";
         case TokenType::KwClass:           return "class";
+        case TokenType::KwStruct:          return "struct";
         case TokenType::KwInterface:       return "interface";
         case TokenType::KwEnum:            return "enum";
         case TokenType::KwIf:              return "if";
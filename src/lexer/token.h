@@ -25,6 +25,7 @@ enum class TokenType {
     KwVar,
     KwLet,
     KwClass,
+    KwStruct,
     KwInterface,
     KwEnum,
     KwIf,
@@ -817,6 +817,7 @@ std::vector<Json> LspServer::getCompletionItems(const std::string& uri, int line
         {"compute", "Compute-bound async"},
         {"unsafe", "Unsafe block"},
         {"shared", "Thread-safe class"},
+        {"struct", "Value type"},
         {"match", "Match expression"},
         {"operator", "Operator overload"},
         {"extern", "External function"},
@@ -861,6 +862,37 @@ std::vector<Json> LspServer::getCompletionItems(const std::string& uri, int line
         {"writeFile", "func writeFile(path: String, content: String) -> Bool"},
         {"appendFile", "func appendFile(path: String, content: String) -> Bool"},
         {"fileExists", "func fileExists(path: String) -> Bool"},
+        {"mmapOpen", "func mmapOpen(path: String) -> Ptr"},
+        {"mmapOpenWritable", "func mmapOpenWritable(path: String) -> Ptr"},
+        {"mmapData", "func mmapData(file: Ptr) -> Ptr"},
+        {"mmapSize", "func mmapSize(file: Ptr) -> Int"},
+        {"mmapAdvise", "func mmapAdvise(file: Ptr, advice: Int) -> Bool"},
+        {"mmapSync", "func mmapSync(file: Ptr) -> Bool"},
+        {"mmapSlice", "func mmapSlice(file: Ptr, start: Int, end: Int) -> String"},
+        {"mmapIndexOf", "func mmapIndexOf(file: Ptr, needle: String, from: Int) -> Int"},
+        {"mmapClose", "func mmapClose(file: Ptr)"},
+        {"fileReaderOpen", "func fileReaderOpen(path: String) -> Ptr"},
+        {"fileReaderOpenWith", "func fileReaderOpenWith(path: String, bufferSize: Int, flags: Int) -> Ptr"},
+        {"fileReadLine", "func fileReadLine(reader: Ptr) -> String?"},
+        {"fileLines", "func fileLines(reader: Ptr)"},
+        {"fileReadInto", "func fileReadInto(reader: Ptr, buffer: Ptr, count: Int) -> Int"},
+        {"fileReaderClose", "func fileReaderClose(reader: Ptr)"},
+        {"fileWriterOpen", "func fileWriterOpen(path: String, append: Bool) -> Ptr"},
+        {"fileWriterOpenWith", "func fileWriterOpenWith(path: String, append: Bool, bufferSize: Int, flags: Int) -> Ptr"},
+        {"fileWrite", "func fileWrite(writer: Ptr, text: String) -> Bool"},
+        {"fileWriteLine", "func fileWriteLine(writer: Ptr, text: String) -> Bool"},
+        {"fileWriteAll", "func fileWriteAll(writer: Ptr, buffer: Ptr, count: Int) -> Bool"},
+        {"fileFlush", "func fileFlush(writer: Ptr) -> Bool"},
+        {"fileWriterClose", "func fileWriterClose(writer: Ptr) -> Bool"},
+        {"fileSize", "func fileSize(path: String) -> Int"},
+        {"fileModifiedTime", "func fileModifiedTime(path: String) -> Int"},
+        {"isDirectory", "func isDirectory(path: String) -> Bool"},
+        {"listDir", "func listDir(path: String) -> [String]"},
+        {"walk", "func walk(root: String) -> Ptr"},
+        {"walkMatching", "func walkMatching(root: String, pattern: String) -> Ptr"},
+        {"walkNext", "func walkNext(walker: Ptr) -> String?"},
+        {"walkClose", "func walkClose(walker: Ptr)"},
+        {"parallelForEachFile", "func parallelForEachFile(root: String, pattern: String, fn: (String) -> Void) -> Int"},
         {"exec", "func exec(cmd: String) -> Int"},
         {"execOutput", "func execOutput(cmd: String) -> String"},
         {"abs", "func abs(x: Int) -> Int"},
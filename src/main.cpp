@@ -4,15 +4,29 @@
 #include <algorithm>
 #include <fstream>
 #include <cstdio>
+#include <cstdlib>
+#include <cctype>
 #include <set>
+#include <map>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <chrono>
+#include <sstream>
+#include <cerrno>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include "common/source_file.h"
 #include "common/diagnostic.h"
 #include "lexer/lexer.h"
 #include "parser/parser.h"
 #include "sema/type_checker.h"
 #include "codegen/codegen.h"
+#include "cache/module_cache.h"
+#include "bench/bench_report.h"
 #include "fmt/formatter.h"
 
 namespace chris {
@@ -23,6 +37,20 @@ struct CLIOptions {
     bool jsonOutput = false;
     bool showHelp = false;
     bool showVersion = false;
+    DebugInfoLevel debugInfo = DebugInfoLevel::None;
+    bool instrument = false;   // --instrument=functions
+    bool profile = false;
+    std::string profilePath; // empty: <file>.folded
+    bool profileGenerate = false; // --profile-generate[=<dir>]
+    std::string profileDir;       // empty: the working directory
+    std::string profileUse;       // --profile-use=<file.profdata>
+    bool aot = false;             // --aot: run builds and links an executable
+    unsigned jobs = 1;            // -j N: files parsed and compiled at once
+    unsigned shard = 1;           // --shard i/n: with test, run the i-th of n slices
+    unsigned shardCount = 1;
+    std::string baseline;         // --baseline=<file>: with bench, compare against a JSON report
+    double maxRegression = 10;    // --max-regression=<percent>
+    std::string benchTime;        // --bench-time=<ms>: empty for the runtime's default
     std::vector<std::string> linkerFlags;
 };
 
@@ -40,6 +68,42 @@ CLIOptions parseArgs(int argc, char* argv[]) {
                 opts.jsonOutput = true;
             }
             i++;
+        } else if (args[i] == "-g") {
+            opts.debugInfo = DebugInfoLevel::Full;
+        } else if (args[i] == "-gline-tables-only") {
+            opts.debugInfo = DebugInfoLevel::LineTablesOnly;
+        } else if (args[i] == "--instrument=functions") {
+            opts.instrument = true;
+        } else if (args[i] == "--profile") {
+            opts.profile = true;
+        } else if (args[i].rfind("--profile=", 0) == 0) {
+            opts.profile = true;
+            opts.profilePath = args[i].substr(10);
+        } else if (args[i] == "--profile-generate") {
+            opts.profileGenerate = true;
+        } else if (args[i].rfind("--profile-generate=", 0) == 0) {
+            opts.profileGenerate = true;
+            opts.profileDir = args[i].substr(19);
+        } else if (args[i].rfind("--profile-use=", 0) == 0) {
+            opts.profileUse = args[i].substr(14);
+        } else if (args[i] == "--aot") {
+            opts.aot = true;
+        } else if ((args[i] == "-j" || args[i] == "--jobs") && i + 1 < args.size()) {
+            opts.jobs = std::max(1, std::atoi(args[++i].c_str()));
+        } else if (args[i].size() > 2 && args[i].rfind("-j", 0) == 0 &&
+                   std::isdigit(static_cast<unsigned char>(args[i][2]))) {
+            opts.jobs = std::max(1, std::atoi(args[i].c_str() + 2));
+        } else if ((args[i] == "--shard" && i + 1 < args.size()) || args[i].rfind("--shard=", 0) == 0) {
+            std::string value = args[i] == "--shard" ? args[++i] : args[i].substr(8);
+            if (std::sscanf(value.c_str(), "%u/%u", &opts.shard, &opts.shardCount) != 2) {
+                opts.shard = 0; // rejected by the test command
+            }
+        } else if (args[i].rfind("--baseline=", 0) == 0) {
+            opts.baseline = args[i].substr(11);
+        } else if (args[i].rfind("--max-regression=", 0) == 0) {
+            opts.maxRegression = std::atof(args[i].c_str() + 17);
+        } else if (args[i].rfind("--bench-time=", 0) == 0) {
+            opts.benchTime = args[i].substr(13);
         } else if (opts.command.empty()) {
             opts.command = args[i];
         } else if (opts.inputFile.empty()) {
@@ -65,13 +129,26 @@ void printUsage() {
     std::cout << "chrisplusplus compiler v0.1.0\n\n"
               << "Usage:\n"
               << "  chris build <file.chr> [-lLIB ...]  Compile and link a .chr file\n"
-              << "  chris run <file.chr>         Build and run a .chr file\n"
-              << "  chris test                   Run tests\n"
+              << "  chris run <file.chr>         Compile and run a .chr file in memory\n"
+              << "  chris test [dir|file.chr]    Run tests (test_*.chr, *_test.chr)\n"
+              << "  chris bench [dir|file.chr]   Run benchmarks (@Benchmark, bench_*)\n"
               << "  chris fmt <file.chr>         Format source code\n"
               << "  chris lint <file.chr>        Lint source code\n"
               << "  chris new <project>          Create a new project\n"
               << "\nOptions:\n"
               << "  --output json                Output diagnostics as JSON\n"
+              << "  -g                           Emit DWARF debug info (lines, locals)\n"
+              << "  -gline-tables-only           Keep frame pointers for perf\n"
+              << "  --instrument=functions       Count calls and time every function (report at exit)\n"
+              << "  --profile[=<out.folded>]     With run: sample the program, write folded stacks\n"
+              << "  --profile-generate[=<dir>]   Optimise and instrument for PGO; runs write .profraw\n"
+              << "  --profile-use=<file>         Optimise with counts merged by llvm-profdata\n"
+              << "  --aot                        With run: build and link an executable, then run it\n"
+              << "  -j N, --jobs N               Parse and compile (with test: run) up to N files at once\n"
+              << "  --shard i/n                  With test: run only the i-th of n slices of the files\n"
+              << "  --bench-time=<ms>            With bench: measure each benchmark for about <ms>\n"
+              << "  --baseline=<file.json>       With bench: compare with an earlier --output json run\n"
+              << "  --max-regression=<percent>   With bench: slowdown that fails the run (default 10)\n"
               << "  --help, -h                   Show this help\n"
               << "  --version, -v                Show version\n";
 }
@@ -87,45 +164,116 @@ std::string dirName(const std::string& filePath) {
     return filePath.substr(0, pos);
 }
 
-// Recursively process imports: lex+parse imported .chr files and merge declarations
-bool processImports(Program& program, const std::string& baseDir,
-                    DiagnosticEngine& diagnostics, std::set<std::string>& imported) {
-    // Collect import paths first (avoid modifying declarations while iterating)
-    std::vector<std::string> importPaths;
+// Run body(0) .. body(count - 1) on up to `jobs` threads, the calling
+// thread included
+void parallelFor(size_t count, unsigned jobs, const std::function<void(size_t)>& body) {
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i = next++; i < count; i = next++) body(i);
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < std::min<size_t>(jobs, count); t++) threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+}
+
+// The .chr files `program` imports, resolved against its directory
+std::vector<std::string> importedFiles(const Program& program, const std::string& baseDir) {
+    std::vector<std::string> files;
     for (auto& decl : program.declarations) {
         if (auto* imp = dynamic_cast<ImportDecl*>(decl.get())) {
-            std::string path = imp->path;
+            const std::string& path = imp->path;
             // Only handle file imports (ending in .chr)
             if (path.size() >= 4 && path.substr(path.size() - 4) == ".chr") {
-                // Resolve relative to base directory
-                std::string fullPath = baseDir + "/" + path;
-                if (imported.count(fullPath)) continue; // already imported
-                importPaths.push_back(fullPath);
-                imported.insert(fullPath);
+                files.push_back(baseDir + "/" + path);
             }
         }
     }
+    return files;
+}
+
+// Read, lex and parse one imported file
+bool parseImport(const std::string& fullPath, DiagnosticEngine& diagnostics, Program& program) {
+    SourceFile importSource(fullPath);
+    if (!importSource.load()) {
+        diagnostics.error("E1001", "Could not open imported file: " + fullPath,
+                         SourceLocation("<import>", 0, 0));
+        return false;
+    }
+
+    Lexer importLexer(importSource.content(), fullPath, diagnostics);
+    auto importTokens = importLexer.tokenize();
+    if (diagnostics.hasErrors()) return false;
+
+    Parser importParser(importTokens, diagnostics);
+    program = importParser.parse();
+    return !diagnostics.hasErrors();
+}
+
+// An imported file parsed ahead of the merge, with its own diagnostics
+struct ParsedImport {
+    Program program;
+    DiagnosticEngine diagnostics;
+    bool ok = false;
+};
+using ParsedImports = std::map<std::string, ParsedImport>;
+
+// Parse every file reachable through imports from `program`, up to `jobs`
+// at a time. A file's imports are only known once it is parsed, so this
+// goes one level of the import graph at a time.
+ParsedImports parseImports(const Program& program, const std::string& baseDir, unsigned jobs) {
+    ParsedImports parsed;
+    std::vector<std::string> level = importedFiles(program, baseDir);
+    while (!level.empty()) {
+        std::vector<std::pair<std::string, ParsedImport*>> files;
+        for (auto& file : level) {
+            if (parsed.count(file)) continue;
+            files.emplace_back(file, &parsed[file]);
+        }
+        parallelFor(files.size(), jobs, [&](size_t i) {
+            auto& [file, entry] = files[i];
+            entry->ok = parseImport(file, entry->diagnostics, entry->program);
+        });
+        level.clear();
+        for (auto& [file, entry] : files) {
+            if (!entry->ok) continue;
+            auto next = importedFiles(entry->program, dirName(file));
+            level.insert(level.end(), next.begin(), next.end());
+        }
+    }
+    return parsed;
+}
+
+// Recursively process imports: lex+parse imported .chr files and merge
+// declarations. Files already in `parsed` are taken from there.
+bool processImports(Program& program, const std::string& baseDir,
+                    DiagnosticEngine& diagnostics, std::set<std::string>& imported,
+                    ParsedImports* parsed = nullptr) {
+    // Collect import paths first (avoid modifying declarations while iterating)
+    std::vector<std::string> importPaths;
+    for (auto& fullPath : importedFiles(program, baseDir)) {
+        if (imported.count(fullPath)) continue; // already imported
+        importPaths.push_back(fullPath);
+        imported.insert(fullPath);
+    }
 
     // Process each import
     for (auto& fullPath : importPaths) {
-        SourceFile importSource(fullPath);
-        if (!importSource.load()) {
-            diagnostics.error("E1001", "Could not open imported file: " + fullPath,
-                             SourceLocation("<import>", 0, 0));
+        Program importProgram;
+        auto it = parsed ? parsed->find(fullPath) : ParsedImports::iterator();
+        if (parsed && it != parsed->end()) {
+            for (auto& diagnostic : it->second.diagnostics.diagnostics()) {
+                diagnostics.report(diagnostic);
+            }
+            if (!it->second.ok) return false;
+            importProgram = std::move(it->second.program);
+        } else if (!parseImport(fullPath, diagnostics, importProgram)) {
             return false;
         }
 
-        Lexer importLexer(importSource.content(), fullPath, diagnostics);
-        auto importTokens = importLexer.tokenize();
-        if (diagnostics.hasErrors()) return false;
-
-        Parser importParser(importTokens, diagnostics);
-        auto importProgram = importParser.parse();
-        if (diagnostics.hasErrors()) return false;
-
         // Recursively process imports in the imported file
         std::string importDir = dirName(fullPath);
-        if (!processImports(importProgram, importDir, diagnostics, imported)) {
+        if (!processImports(importProgram, importDir, diagnostics, imported, parsed)) {
             return false;
         }
 
@@ -141,8 +289,11 @@ bool processImports(Program& program, const std::string& baseDir,
     return true;
 }
 
-int buildCommand(const std::string& inputFile, bool jsonOutput,
-                 const std::vector<std::string>& linkerFlags = {}) {
+// Lex, parse and check `inputFile` and the files it imports (parsing up to
+// `jobs` of them at once), then hand the program to `next`, whose result is
+// returned
+int checkProgram(const std::string& inputFile, bool jsonOutput, unsigned jobs,
+                 const std::function<int(Program&, TypeChecker&, DiagnosticEngine&)>& next) {
     DiagnosticEngine diagnostics;
 
     if (inputFile.empty()) {
@@ -185,7 +336,8 @@ int buildCommand(const std::string& inputFile, bool jsonOutput,
     // Phase 2.5: Process imports
     std::string baseDir = dirName(inputFile);
     std::set<std::string> imported;
-    if (!processImports(program, baseDir, diagnostics, imported)) {
+    ParsedImports parsed = parseImports(program, baseDir, jobs);
+    if (!processImports(program, baseDir, diagnostics, imported, &parsed)) {
         diagnostics.printAll(jsonOutput);
         return 1;
     }
@@ -198,28 +350,37 @@ int buildCommand(const std::string& inputFile, bool jsonOutput,
         diagnostics.printAll(jsonOutput);
         return 1;
     }
+    return next(program, checker, diagnostics);
+}
 
-    // Phase 4: Code Generation
-    CodeGen codegen(inputFile, diagnostics);
-    if (!codegen.generate(program, checker.genericInstantiations())) {
-        diagnostics.printAll(jsonOutput);
+// Check and generate code for `inputFile` as a single module, then hand the
+// module to `emit`, whose result is returned
+int compileCommand(const std::string& inputFile, bool jsonOutput, DebugInfoLevel debugInfo,
+                   bool instrument, bool profileGenerate, const std::string& profileDir,
+                   const std::string& profileUse,
+                   const std::function<int(CodeGen&, DiagnosticEngine&)>& emit) {
+    if (profileGenerate && !profileUse.empty()) {
+        std::cerr << "error: --profile-generate and --profile-use cannot be combined" << std::endl;
         return 1;
     }
 
-    // Determine output paths
-    std::string baseName = inputFile.substr(0, inputFile.size() - 4);
-    std::string objectPath = baseName + ".o";
-    std::string outputPath = baseName;
-
-    // Emit object file
-    if (!codegen.emitObjectFile(objectPath)) {
-        diagnostics.printAll(jsonOutput);
-        return 1;
-    }
+    return checkProgram(inputFile, jsonOutput, 1,
+                        [&](Program& program, TypeChecker& checker, DiagnosticEngine& diagnostics) {
+        CodeGen codegen(inputFile, diagnostics);
+        codegen.setDebugInfoLevel(debugInfo);
+        codegen.setInstrumentFunctions(instrument);
+        if (profileGenerate) codegen.setProfileGenerate(profileDir);
+        codegen.setProfileUse(profileUse);
+        if (!codegen.generate(program, checker.genericInstantiations())) {
+            diagnostics.printAll(jsonOutput);
+            return 1;
+        }
+        return emit(codegen, diagnostics);
+    });
+}
 
-    // Find runtime library — look relative to the compiler binary or in build dir
-    std::string runtimePath;
-    // Try common locations
+// Find runtime library — look relative to the compiler binary or in build dir
+std::string findRuntimeLibrary() {
     std::vector<std::string> runtimeSearchPaths = {
         "libchris_runtime.a",
         "build/libchris_runtime.a",
@@ -227,41 +388,194 @@ int buildCommand(const std::string& inputFile, bool jsonOutput,
     };
     for (const auto& path : runtimeSearchPaths) {
         std::ifstream test(path);
-        if (test.good()) {
-            runtimePath = path;
-            break;
-        }
+        if (test.good()) return path;
     }
+    std::cerr << "error: could not find chris runtime library (libchris_runtime.a)" << std::endl;
+    std::cerr << "hint: build the project first with 'cmake --build build'" << std::endl;
+    return "";
+}
 
-    if (runtimePath.empty()) {
-        std::cerr << "error: could not find chris runtime library (libchris_runtime.a)" << std::endl;
-        std::cerr << "hint: build the project first with 'cmake --build build'" << std::endl;
-        return 1;
-    }
+// Compile each file of the program to its own object in .chris-cache/,
+// reusing the objects of files whose source and dependencies are unchanged.
+// Up to `jobs` files are compiled at once, each in its own LLVM context.
+int incrementalBuild(const std::string& inputFile, bool jsonOutput,
+                     const std::vector<std::string>& linkerFlags, DebugInfoLevel debugInfo,
+                     unsigned jobs) {
+    return checkProgram(inputFile, jsonOutput, jobs,
+                        [&](Program& program, TypeChecker& checker, DiagnosticEngine& diagnostics) {
+        std::string runtimePath = findRuntimeLibrary();
+        if (runtimePath.empty()) return 1;
+
+        std::vector<std::string> instantiations;
+        for (auto& inst : checker.genericInstantiations()) {
+            instantiations.push_back(inst.mangledName);
+        }
+        std::string options = CodeGen::compilerId(runtimePath) + " debug=" +
+                              std::to_string(static_cast<int>(debugInfo));
+
+        ModuleCache cache(dirName(inputFile) + "/.chris-cache");
+        std::vector<ModuleUnit> units;
+        if (!cache.plan(program, inputFile, instantiations, options, units)) {
+            std::cerr << "error: could not prepare the build cache for " << inputFile << std::endl;
+            return 1;
+        }
+
+        std::vector<std::string> objects;
+        std::vector<ModuleUnit*> pending;
+        for (auto& unit : units) {
+            objects.push_back(unit.objectPath);
+            if (!unit.cached) pending.push_back(&unit);
+        }
+
+        // Diagnostics are collected per unit and reported in unit order
+        std::vector<DiagnosticEngine> unitDiagnostics(pending.size());
+        std::vector<char> built(pending.size(), 0);
+        parallelFor(pending.size(), jobs, [&](size_t i) {
+            const ModuleUnit& unit = *pending[i];
+            CodeGen codegen(unit.file, unitDiagnostics[i]);
+            codegen.setDebugInfoLevel(debugInfo);
+            codegen.setCompilationUnit(unit.file, unit.isEntry);
+            built[i] = codegen.generate(program, checker.genericInstantiations()) &&
+                       codegen.emitObjectFile(unit.objectPath + ".tmp");
+        });
+        // Cached units replay the warnings their compilation reported
+        bool allBuilt = true;
+        size_t next = 0;
+        for (auto& unit : units) {
+            if (unit.cached) {
+                for (auto& warning : unit.warnings) diagnostics.report(warning);
+                continue;
+            }
+            for (auto& diagnostic : unitDiagnostics[next].diagnostics()) diagnostics.report(diagnostic);
+            allBuilt = allBuilt && built[next];
+            next++;
+        }
+        if (!allBuilt) {
+            diagnostics.printAll(jsonOutput);
+            return 1;
+        }
+        for (size_t i = 0; i < pending.size(); i++) {
+            ModuleUnit* unit = pending[i];
+            if (!cache.commit(*unit, unit->objectPath + ".tmp", unitDiagnostics[i].diagnostics())) {
+                std::cerr << "error: could not write " << unit->objectPath << std::endl;
+                return 1;
+            }
+        }
+        size_t compiled = pending.size();
+
+        std::string outputPath = inputFile.substr(0, inputFile.size() - 4);
+        CodeGen linker(inputFile, diagnostics);
+        if (!linker.linkExecutable(objects, runtimePath, outputPath, linkerFlags)) {
+            diagnostics.printAll(jsonOutput);
+            return 1;
+        }
 
-    // Link
-    if (!codegen.linkExecutable(objectPath, runtimePath, outputPath, linkerFlags)) {
         diagnostics.printAll(jsonOutput);
-        return 1;
+        if (units.size() > 1) {
+            std::cout << "Compiled " << compiled << " of " << units.size() << " files ("
+                      << units.size() - compiled << " cached)" << std::endl;
+        }
+        std::cout << "Built: " << outputPath << std::endl;
+        return 0;
+    });
+}
+
+int buildCommand(const std::string& inputFile, bool jsonOutput,
+                 const std::vector<std::string>& linkerFlags = {},
+                 DebugInfoLevel debugInfo = DebugInfoLevel::None,
+                 bool instrument = false, bool profileGenerate = false,
+                 const std::string& profileDir = "", const std::string& profileUse = "",
+                 unsigned jobs = 1) {
+    // Instrumented and profile-guided builds register whole-program tables
+    // and optimise across files, so they are compiled as one module
+    if (!instrument && !profileGenerate && profileUse.empty()) {
+        return incrementalBuild(inputFile, jsonOutput, linkerFlags, debugInfo, jobs);
     }
 
-    // Clean up object file
-    std::remove(objectPath.c_str());
+    return compileCommand(inputFile, jsonOutput, debugInfo, instrument, profileGenerate,
+                          profileDir, profileUse,
+                          [&](CodeGen& codegen, DiagnosticEngine& diagnostics) {
+        // Determine output paths
+        std::string baseName = inputFile.substr(0, inputFile.size() - 4);
+        std::string objectPath = baseName + ".o";
+        std::string outputPath = baseName;
 
-    diagnostics.printAll(jsonOutput);
-    std::cout << "Built: " << outputPath << std::endl;
-    return 0;
+        // Emit object file
+        if (!codegen.emitObjectFile(objectPath)) {
+            diagnostics.printAll(jsonOutput);
+            return 1;
+        }
+
+        std::string runtimePath = findRuntimeLibrary();
+        if (runtimePath.empty()) return 1;
+
+        // Link
+        if (!codegen.linkExecutable(objectPath, runtimePath, outputPath, linkerFlags)) {
+            diagnostics.printAll(jsonOutput);
+            return 1;
+        }
+
+        // Clean up object file
+        std::remove(objectPath.c_str());
+
+        diagnostics.printAll(jsonOutput);
+        std::cout << "Built: " << outputPath << std::endl;
+        return 0;
+    });
+}
+
+// Compile `inputFile` in memory and call its main() in this process; the
+// runtime is linked into the compiler
+int jitCommand(const std::string& inputFile, bool jsonOutput, DebugInfoLevel debugInfo,
+               bool instrument, const std::string& profileUse) {
+    return compileCommand(inputFile, jsonOutput, debugInfo, instrument, false, "", profileUse,
+                          [&](CodeGen& codegen, DiagnosticEngine& diagnostics) {
+        diagnostics.printAll(jsonOutput);
+        diagnostics.clear();
+        std::cout << "Running: " << inputFile << std::endl;
+        std::cout << "---" << std::endl;
+        int exitCode = 0;
+        if (!codegen.runJIT(exitCode)) {
+            diagnostics.printAll(jsonOutput);
+            return 1;
+        }
+        return exitCode;
+    });
 }
 
 int runCommand(const std::string& inputFile, bool jsonOutput,
-               const std::vector<std::string>& linkerFlags = {}) {
-    int buildResult = buildCommand(inputFile, jsonOutput, linkerFlags);
+               const std::vector<std::string>& linkerFlags = {},
+               DebugInfoLevel debugInfo = DebugInfoLevel::None,
+               bool profile = false, const std::string& profilePath = "",
+               bool instrument = false, bool profileGenerate = false,
+               const std::string& profileDir = "", const std::string& profileUse = "",
+               bool aot = false, unsigned jobs = 1) {
+    // Profiles are sampled from the start of main() and PGO counters are found
+    // through linker-defined sections, so those runs, and runs that link
+    // extra libraries, build an executable
+    if (!aot && !profile && !profileGenerate && linkerFlags.empty()) {
+        return jitCommand(inputFile, jsonOutput, debugInfo, instrument, profileUse);
+    }
+
+    // The profiler walks frame pointers, which debug info keeps
+    if (profile && debugInfo == DebugInfoLevel::None) {
+        debugInfo = DebugInfoLevel::LineTablesOnly;
+    }
+    int buildResult = buildCommand(inputFile, jsonOutput, linkerFlags, debugInfo, instrument,
+                                   profileGenerate, profileDir, profileUse, jobs);
     if (buildResult != 0) return buildResult;
 
     // Determine the executable path (same as build output)
     std::string baseName = inputFile.substr(0, inputFile.size() - 4);
     std::string execPath = baseName;
 
+    // The program starts sampling as main() begins when CHRIS_PROFILE is set
+    std::string foldedPath;
+    if (profile) {
+        foldedPath = profilePath.empty() ? baseName + ".folded" : profilePath;
+        setenv("CHRIS_PROFILE", foldedPath.c_str(), 1);
+    }
+
     // Make it a proper path if it's a relative name without directory
     if (execPath.find('/') == std::string::npos) {
         execPath = "./" + execPath;
@@ -274,6 +588,13 @@ int runCommand(const std::string& inputFile, bool jsonOutput,
     // Clean up the binary after running
     std::remove(execPath.c_str());
 
+    if (profile) {
+        unsetenv("CHRIS_PROFILE");
+        std::cout << "---" << std::endl;
+        std::cout << "Profile: " << foldedPath
+                  << " (folded stacks; render with flamegraph.pl or speedscope)" << std::endl;
+    }
+
     // std::system returns the full status; extract the exit code
     return WEXITSTATUS(exitCode);
 }
@@ -341,18 +662,20 @@ int newCommand(const std::string& projectName) {
     return 0;
 }
 
-// Discover test .chr files in a directory
-std::vector<std::string> findTestFiles(const std::string& dir) {
+// Discover test .chr files in a directory: <kind>_*.chr or *_<kind>.chr
+std::vector<std::string> findTestFiles(const std::string& dir, const std::string& kind = "test") {
     std::vector<std::string> files;
     DIR* d = opendir(dir.c_str());
     if (!d) return files;
     struct dirent* entry;
     while ((entry = readdir(d)) != nullptr) {
         std::string name = entry->d_name;
-        // Match test_*.chr or *_test.chr
+        std::string prefix = kind + "_";
+        std::string suffix = "_" + kind + ".chr";
         if (name.size() >= 4 && name.substr(name.size() - 4) == ".chr") {
-            if (name.substr(0, 5) == "test_" ||
-                (name.size() >= 9 && name.substr(name.size() - 9) == "_test.chr")) {
+            if (name.rfind(prefix, 0) == 0 ||
+                (name.size() >= suffix.size() &&
+                 name.substr(name.size() - suffix.size()) == suffix)) {
                 files.push_back(dir + "/" + name);
             }
         }
@@ -375,8 +698,299 @@ std::vector<std::string> findTestFunctions(Program& program) {
     return names;
 }
 
-int testCommand(const std::string& inputFileOrDir, bool jsonOutput) {
+// Generate a harness around a test file: its source plus a main() that
+// calls each test function with reporting
+std::string testHarness(const std::string& source, const std::vector<std::string>& testNames) {
+    std::string harness = source;
+    harness += "\n";
+    harness += "// --- Generated test harness ---\n";
+    harness += "extern func chris_test_start(name: String);\n";
+    harness += "extern func chris_test_pass(name: String);\n";
+    harness += "extern func chris_test_fail(name: String);\n";
+    harness += "extern func chris_test_summary() -> Int;\n";
+    harness += "func main() -> Int {\n";
+
+    for (auto& name : testNames) {
+        harness += "    chris_test_start(\"" + name + "\");\n";
+        harness += "    try {\n";
+        harness += "        " + name + "();\n";
+        harness += "        chris_test_pass(\"" + name + "\");\n";
+        harness += "    } catch (e: Error) {\n";
+        harness += "        chris_test_fail(\"" + name + "\");\n";
+        harness += "    }\n";
+    }
+
+    harness += "    return chris_test_summary();\n";
+    harness += "}\n";
+    return harness;
+}
+
+// Read and parse a test or benchmark file, printing its errors
+bool loadTestProgram(const std::string& file, bool jsonOutput, std::string& source,
+                     Program& program) {
+    SourceFile sourceFile(file);
+    if (!sourceFile.load()) {
+        std::cerr << "error: could not open file: " << file << std::endl;
+        return false;
+    }
+    source = sourceFile.content();
+
     DiagnosticEngine diagnostics;
+    Lexer lexer(source, file, diagnostics);
+    auto tokens = lexer.tokenize();
+    if (diagnostics.hasErrors()) {
+        diagnostics.printAll(jsonOutput);
+        return false;
+    }
+
+    Parser parser(tokens, diagnostics);
+    program = parser.parse();
+    if (diagnostics.hasErrors()) {
+        diagnostics.printAll(jsonOutput);
+        return false;
+    }
+    return true;
+}
+
+// Compile `harness`, the source of `file` with a generated main(), and run it
+// in this process through the JIT, calling `compiled` just before it runs
+int runHarness(const std::string& file, const std::string& harness, bool jsonOutput,
+               const std::function<void()>& compiled) {
+    DiagnosticEngine harnDiag;
+    Lexer harnLexer(harness, file, harnDiag);
+    auto harnTokens = harnLexer.tokenize();
+    if (harnDiag.hasErrors()) {
+        harnDiag.printAll(jsonOutput);
+        return 1;
+    }
+
+    Parser harnParser(harnTokens, harnDiag);
+    auto harnProgram = harnParser.parse();
+    if (harnDiag.hasErrors()) {
+        harnDiag.printAll(jsonOutput);
+        return 1;
+    }
+
+    std::string baseDir = dirName(file);
+    std::set<std::string> imported;
+    if (!processImports(harnProgram, baseDir, harnDiag, imported)) {
+        harnDiag.printAll(jsonOutput);
+        return 1;
+    }
+
+    TypeChecker checker(harnDiag);
+    checker.check(harnProgram);
+    if (harnDiag.hasErrors()) {
+        harnDiag.printAll(jsonOutput);
+        return 1;
+    }
+
+    CodeGen codegen(file, harnDiag);
+    if (!codegen.generate(harnProgram, checker.genericInstantiations())) {
+        harnDiag.printAll(jsonOutput);
+        return 1;
+    }
+    compiled();
+
+    int exitCode = 0;
+    if (!codegen.runJIT(exitCode)) {
+        harnDiag.printAll(jsonOutput);
+        return 1;
+    }
+    return exitCode;
+}
+
+// Compile one test file's harness and run it in this process through the
+// JIT. `reportPath` receives a "test\t<name>" line per test function, then
+// "compiled" once the harness has been generated; the runtime appends a
+// result line per finished test.
+int runTestFile(const std::string& testFile, const std::string& reportPath, bool jsonOutput) {
+    std::string source;
+    Program program;
+    if (!loadTestProgram(testFile, jsonOutput, source, program)) return 1;
+
+    auto testNames = findTestFunctions(program);
+    if (testNames.empty()) return 0;
+    std::ofstream report(reportPath);
+    for (auto& name : testNames) report << "test\t" << name << "\n";
+    report.flush();
+
+    return runHarness(testFile, testHarness(source, testNames), jsonOutput, [&] {
+        report << "compiled\n";
+        report.close();
+    });
+}
+
+struct TestResult {
+    std::string name;
+    std::string status = "not_run"; // pass, fail or not_run
+    double ms = 0;
+};
+
+// One test file, run in a child process of its own
+struct TestFileRun {
+    std::string file;
+    std::vector<TestResult> tests;
+    std::string output; // everything the file's process printed
+    std::string error;  // why the file did not run to completion
+    double ms = 0;
+    bool done = false;
+
+    pid_t pid = -1;
+    std::string outputPath;
+    std::string reportPath;
+    std::chrono::steady_clock::time_point started;
+};
+
+std::string readWholeFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::string makeTempFile(const char* prefix) {
+    std::string path = std::string("/tmp/") + prefix + "-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) return "";
+    close(fd);
+    return path;
+}
+
+// Fork a process that compiles and runs `run.file`, its output going to a
+// temporary file
+bool startTestFile(TestFileRun& run, bool jsonOutput) {
+    run.outputPath = makeTempFile("chris-test-out");
+    run.reportPath = makeTempFile("chris-test-report");
+    if (run.outputPath.empty() || run.reportPath.empty()) return false;
+
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    run.started = std::chrono::steady_clock::now();
+    run.pid = fork();
+    if (run.pid < 0) return false;
+    if (run.pid == 0) {
+        int fd = open(run.outputPath.c_str(), O_WRONLY | O_TRUNC);
+        if (fd >= 0) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        setenv("CHRIS_TEST_REPORT", run.reportPath.c_str(), 1);
+        int exitCode = runTestFile(run.file, run.reportPath, jsonOutput);
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        _exit(exitCode == 0 ? 0 : 1);
+    }
+    return true;
+}
+
+// Collect a finished process's output and results
+void finishTestFile(TestFileRun& run, int status) {
+    run.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                       run.started).count();
+    run.output = readWholeFile(run.outputPath);
+
+    bool compiled = false;
+    std::istringstream report(readWholeFile(run.reportPath));
+    std::string line;
+    while (std::getline(report, line)) {
+        std::vector<std::string> fields;
+        std::istringstream fieldStream(line);
+        for (std::string field; std::getline(fieldStream, field, '\t');) fields.push_back(field);
+        if (fields.size() == 2 && fields[0] == "test") {
+            TestResult result;
+            result.name = fields[1];
+            run.tests.push_back(result);
+        } else if (fields.size() == 1 && fields[0] == "compiled") {
+            compiled = true;
+        } else if (fields.size() == 3 && (fields[0] == "pass" || fields[0] == "fail")) {
+            for (auto& result : run.tests) {
+                if (result.name == fields[1] && result.status == "not_run") {
+                    result.status = fields[0];
+                    result.ms = std::strtoull(fields[2].c_str(), nullptr, 10) / 1e6;
+                    break;
+                }
+            }
+        }
+    }
+    std::remove(run.outputPath.c_str());
+    std::remove(run.reportPath.c_str());
+
+    std::string unfinished;
+    for (auto& result : run.tests) {
+        if (result.status == "not_run") {
+            unfinished = result.name;
+            break;
+        }
+    }
+    if (WIFSIGNALED(status)) {
+        run.error = "crashed (signal " + std::to_string(WTERMSIG(status)) + ")";
+        if (!unfinished.empty()) run.error += " in " + unfinished;
+    } else if (!run.tests.empty() && !compiled) {
+        run.error = "failed to compile";
+    } else if (run.tests.empty() && WEXITSTATUS(status) != 0) {
+        run.error = "failed to load";
+    } else if (!unfinished.empty()) {
+        run.error = "exited with code " + std::to_string(WEXITSTATUS(status)) + " in " + unfinished;
+    }
+    run.done = true;
+}
+
+void printTestFile(const TestFileRun& run) {
+    if (run.tests.empty() && run.error.empty()) {
+        std::cout << "  (no test functions in " << run.file << ")" << std::endl;
+        return;
+    }
+    char elapsed[32];
+    std::snprintf(elapsed, sizeof(elapsed), "%.1f ms", run.ms);
+    std::cout << "\n=== " << run.file << " (" << run.tests.size() << " test(s), " << elapsed
+              << ") ===" << std::endl;
+    std::cout << run.output;
+    if (!run.output.empty() && run.output.back() != '\n') std::cout << "\n";
+    if (!run.error.empty()) std::cout << "  [ERROR ] " << run.error << std::endl;
+}
+
+void printTestReport(const std::vector<TestFileRun>& runs, int passed, int failed, int total,
+                     unsigned shard, unsigned shardCount) {
+    auto ms = [](double value) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.3f", value);
+        return std::string(text);
+    };
+    std::cout << "{\"files\":[";
+    for (size_t i = 0; i < runs.size(); i++) {
+        auto& run = runs[i];
+        if (i > 0) std::cout << ",";
+        std::cout << "{\"file\":\"" << escapeJson(run.file) << "\",\"time_ms\":" << ms(run.ms)
+                  << ",\"tests\":[";
+        for (size_t j = 0; j < run.tests.size(); j++) {
+            auto& test = run.tests[j];
+            if (j > 0) std::cout << ",";
+            std::cout << "{\"name\":\"" << escapeJson(test.name) << "\",\"status\":\"" << test.status
+                      << "\",\"time_ms\":" << ms(test.ms) << "}";
+        }
+        std::cout << "]";
+        if (!run.error.empty()) std::cout << ",\"error\":\"" << escapeJson(run.error) << "\"";
+        std::cout << ",\"output\":\"" << escapeJson(run.output) << "\"}";
+    }
+    std::cout << "],\"total\":" << total << ",\"passed\":" << passed << ",\"failed\":" << failed
+              << ",\"shard\":" << shard << ",\"shards\":" << shardCount << "}" << std::endl;
+}
+
+// Run test files, up to `jobs` at once, each compiled and run through the
+// JIT in a process of its own so that a crash, exit() or runtime state in
+// one file cannot affect another. Output is printed per file, in file order;
+// with --output json a single report is printed at the end instead. With
+// `shardCount` > 1 only every shardCount-th file, starting at `shard`
+// (1-based), is run.
+int testCommand(const std::string& inputFileOrDir, bool jsonOutput, unsigned jobs = 1,
+                unsigned shard = 1, unsigned shardCount = 1) {
+    if (shard < 1 || shard > shardCount) {
+        std::cerr << "error: --shard must be i/n with 1 <= i <= n" << std::endl;
+        return 1;
+    }
+
     std::vector<std::string> testFiles;
 
     if (!inputFileOrDir.empty() &&
@@ -395,175 +1009,293 @@ int testCommand(const std::string& inputFileOrDir, bool jsonOutput) {
         }
     }
 
+    std::vector<TestFileRun> runs;
+    for (size_t i = 0; i < testFiles.size(); i++) {
+        if (i % shardCount != shard - 1) continue;
+        runs.emplace_back();
+        runs.back().file = testFiles[i];
+    }
+
+    size_t started = 0;
+    size_t printed = 0;
+    size_t running = 0;
+    while (printed < runs.size()) {
+        while (running < jobs && started < runs.size()) {
+            auto& run = runs[started++];
+            if (startTestFile(run, jsonOutput)) {
+                running++;
+            } else {
+                run.error = "could not start a test process";
+                run.done = true;
+            }
+        }
+        if (running > 0) {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, 0);
+            if (pid < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            for (auto& run : runs) {
+                if (run.pid == pid && !run.done) {
+                    finishTestFile(run, status);
+                    running--;
+                    break;
+                }
+            }
+        }
+        while (printed < started && runs[printed].done) {
+            if (!jsonOutput) printTestFile(runs[printed]);
+            printed++;
+        }
+    }
+
     int totalPassed = 0;
     int totalFailed = 0;
     int totalTests = 0;
-
-    for (auto& testFile : testFiles) {
-        // Load and parse the test file to discover test functions
-        SourceFile source(testFile);
-        if (!source.load()) {
-            std::cerr << "error: could not open test file: " << testFile << std::endl;
-            totalFailed++;
-            continue;
+    for (auto& run : runs) {
+        // A file that could not be loaded or parsed counts as one failure
+        if (run.tests.empty() && !run.error.empty()) totalFailed++;
+        for (auto& test : run.tests) {
+            totalTests++;
+            if (test.status == "pass") {
+                totalPassed++;
+            } else {
+                totalFailed++;
+            }
         }
+    }
 
-        Lexer lexer(source.content(), testFile, diagnostics);
-        auto tokens = lexer.tokenize();
-        if (diagnostics.hasErrors()) {
-            diagnostics.printAll(jsonOutput);
-            totalFailed++;
-            diagnostics = DiagnosticEngine(); // reset
-            continue;
-        }
+    if (jsonOutput) {
+        printTestReport(runs, totalPassed, totalFailed, totalTests, shard, shardCount);
+    } else {
+        // Final summary
+        std::cout << "\n========================================" << std::endl;
+        std::cout << "Total: " << totalTests << " test(s), "
+                  << totalPassed << " passed, "
+                  << totalFailed << " failed." << std::endl;
+    }
 
-        Parser parser(tokens, diagnostics);
-        auto program = parser.parse();
-        if (diagnostics.hasErrors()) {
-            diagnostics.printAll(jsonOutput);
-            totalFailed++;
-            diagnostics = DiagnosticEngine();
-            continue;
-        }
+    return totalFailed > 0 ? 1 : 0;
+}
 
-        auto testNames = findTestFunctions(program);
-        if (testNames.empty()) {
-            std::cout << "  (no test functions in " << testFile << ")" << std::endl;
-            continue;
+// Benchmarks in a parsed program: @Benchmark functions and functions named
+// bench_*. Benchmarks take no parameters.
+bool findBenchmarks(Program& program, std::vector<std::string>& names) {
+    for (auto& decl : program.declarations) {
+        auto* func = dynamic_cast<FuncDecl*>(decl.get());
+        if (!func) continue;
+        bool annotated = false;
+        for (auto& ann : func->annotations) {
+            if (ann.name == "Benchmark") annotated = true;
         }
-
-        // Generate a test harness source that includes the test file content
-        // and a main() that calls each test function with reporting
-        std::string harness = source.content();
-        harness += "\n";
-        harness += "// --- Generated test harness ---\n";
-        harness += "extern func chris_test_start(name: String);\n";
-        harness += "extern func chris_test_pass(name: String);\n";
-        harness += "extern func chris_test_fail(name: String);\n";
-        harness += "extern func chris_test_summary() -> Int;\n";
-        harness += "func main() -> Int {\n";
-
-        for (auto& name : testNames) {
-            harness += "    chris_test_start(\"" + name + "\");\n";
-            harness += "    try {\n";
-            harness += "        " + name + "();\n";
-            harness += "        chris_test_pass(\"" + name + "\");\n";
-            harness += "    } catch (e: Error) {\n";
-            harness += "        chris_test_fail(\"" + name + "\");\n";
-            harness += "    }\n";
-        }
-
-        harness += "    return chris_test_summary();\n";
-        harness += "}\n";
-
-        // Now compile the harness
-        DiagnosticEngine harnDiag;
-        Lexer harnLexer(harness, testFile, harnDiag);
-        auto harnTokens = harnLexer.tokenize();
-        if (harnDiag.hasErrors()) {
-            harnDiag.printAll(jsonOutput);
-            totalFailed += (int)testNames.size();
-            continue;
+        if (!annotated && func->name.rfind("bench_", 0) != 0) continue;
+        if (!func->parameters.empty() || !func->typeParams.empty()) {
+            std::cerr << func->location.file << ":" << func->location.line
+                      << ": error: benchmark '" << func->name << "' must take no parameters"
+                      << std::endl;
+            return false;
         }
+        names.push_back(func->name);
+    }
+    return true;
+}
 
-        Parser harnParser(harnTokens, harnDiag);
-        auto harnProgram = harnParser.parse();
-        if (harnDiag.hasErrors()) {
-            harnDiag.printAll(jsonOutput);
-            totalFailed += (int)testNames.size();
-            continue;
-        }
+// Generate a harness around a benchmark file: a main() that runs each
+// benchmark in batches sized by the runtime (see chris_bench_batch_end)
+std::string benchHarness(const std::string& source, const std::vector<std::string>& benchNames) {
+    std::string harness = source;
+    harness += "\n";
+    harness += "// --- Generated benchmark harness ---\n";
+    harness += "extern func chris_bench_begin(name: String) -> Int;\n";
+    harness += "extern func chris_bench_batch_start();\n";
+    harness += "extern func chris_bench_batch_end(n: Int) -> Int;\n";
+    harness += "func main() -> Int {\n";
+    harness += "    var n = 0;\n";
+
+    for (auto& name : benchNames) {
+        harness += "    n = chris_bench_begin(\"" + name + "\");\n";
+        harness += "    while n > 0 {\n";
+        harness += "        chris_bench_batch_start();\n";
+        harness += "        for i in 0..n {\n";
+        harness += "            " + name + "();\n";
+        harness += "        }\n";
+        harness += "        n = chris_bench_batch_end(n);\n";
+        harness += "    }\n";
+    }
 
-        // Process imports
-        std::string baseDir = dirName(testFile);
-        std::set<std::string> imported;
-        if (!processImports(harnProgram, baseDir, harnDiag, imported)) {
-            harnDiag.printAll(jsonOutput);
-            totalFailed += (int)testNames.size();
-            continue;
+    harness += "    return 0;\n";
+    harness += "}\n";
+    return harness;
+}
+
+int runBenchFile(const std::string& benchFile, bool jsonOutput) {
+    std::string source;
+    Program program;
+    if (!loadTestProgram(benchFile, jsonOutput, source, program)) return 1;
+
+    std::vector<std::string> benchNames;
+    if (!findBenchmarks(program, benchNames)) return 1;
+    if (benchNames.empty()) return 0;
+    return runHarness(benchFile, benchHarness(source, benchNames), jsonOutput, [] {});
+}
+
+void printBenchReport(const std::vector<BenchResult>& results,
+                      const std::vector<std::pair<std::string, std::string>>& errors) {
+    auto number = [](double value) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.4f", value);
+        return std::string(text);
+    };
+    // One benchmark per line, so reports diff cleanly and serve as baselines
+    std::cout << "{\"version\":1,\"benchmarks\":[";
+    for (size_t i = 0; i < results.size(); i++) {
+        auto& result = results[i];
+        std::cout << (i > 0 ? ",\n" : "\n") << "{\"file\":\"" << escapeJson(result.file)
+                  << "\",\"name\":\"" << escapeJson(result.name)
+                  << "\",\"iterations\":" << result.iterations
+                  << ",\"ns_per_op\":" << number(result.nsPerOp)
+                  << ",\"allocs_per_op\":" << number(result.allocsPerOp)
+                  << ",\"bytes_per_op\":" << number(result.bytesPerOp)
+                  << ",\"gcs_per_op\":" << number(result.collectionsPerOp);
+        if (result.baselineNsPerOp >= 0) {
+            std::cout << ",\"baseline_ns_per_op\":" << number(result.baselineNsPerOp);
         }
+        std::cout << "}";
+    }
+    std::cout << "\n],\"errors\":[";
+    for (size_t i = 0; i < errors.size(); i++) {
+        if (i > 0) std::cout << ",";
+        std::cout << "{\"file\":\"" << escapeJson(errors[i].first) << "\",\"error\":\""
+                  << escapeJson(errors[i].second) << "\"}";
+    }
+    std::cout << "]}" << std::endl;
+}
 
-        TypeChecker checker(harnDiag);
-        checker.check(harnProgram);
-        if (harnDiag.hasErrors()) {
-            harnDiag.printAll(jsonOutput);
-            totalFailed += (int)testNames.size();
-            continue;
+// Run benchmark files one at a time, each compiled and run through the JIT
+// in a process of its own. With a baseline from an earlier
+// `--output json` run, benchmarks more than `maxRegression` percent slower
+// than their baseline fail the command.
+int benchCommand(const std::string& inputFileOrDir, bool jsonOutput,
+                 const std::string& baselinePath, double maxRegression,
+                 const std::string& benchTime) {
+    std::vector<std::string> benchFiles;
+    if (inputFileOrDir.size() >= 4 &&
+        inputFileOrDir.substr(inputFileOrDir.size() - 4) == ".chr") {
+        benchFiles.push_back(inputFileOrDir);
+    } else {
+        std::string benchDir = inputFileOrDir.empty() ? "bench" : inputFileOrDir;
+        benchFiles = findTestFiles(benchDir, "bench");
+        if (benchFiles.empty()) {
+            std::cerr << "error: no benchmark files found in '" << benchDir << "/'\n"
+                      << "hint: benchmark files must match bench_*.chr or *_bench.chr" << std::endl;
+            return 1;
         }
+    }
 
-        CodeGen codegen(testFile, harnDiag);
-        if (!codegen.generate(harnProgram, checker.genericInstantiations())) {
-            harnDiag.printAll(jsonOutput);
-            totalFailed += (int)testNames.size();
-            continue;
+    std::map<std::string, double> baseline;
+    if (!baselinePath.empty()) {
+        std::ifstream test(baselinePath);
+        if (!test.good()) {
+            std::cerr << "error: could not open baseline: " << baselinePath << std::endl;
+            return 1;
         }
+        baseline = parseBenchBaseline(readWholeFile(baselinePath));
+    }
 
-        // Emit object file
-        std::string baseName = testFile.substr(0, testFile.size() - 4);
-        std::string objectPath = baseName + "_test_harness.o";
-        std::string outputPath = baseName + "_test_harness";
+    // Read by the runtime in each benchmark process
+    if (!benchTime.empty()) setenv("CHRIS_BENCH_TIME_MS", benchTime.c_str(), 1);
 
-        if (!codegen.emitObjectFile(objectPath)) {
-            totalFailed += (int)testNames.size();
+    std::vector<BenchResult> results;
+    std::vector<std::pair<std::string, std::string>> errors;
+    for (auto& benchFile : benchFiles) {
+        std::string reportPath = makeTempFile("chris-bench-report");
+        if (reportPath.empty()) {
+            errors.emplace_back(benchFile, "could not create a report file");
             continue;
         }
-
-        // Find runtime
-        std::string runtimePath;
-        std::vector<std::string> runtimeSearchPaths = {
-            "libchris_runtime.a",
-            "build/libchris_runtime.a",
-            "../build/libchris_runtime.a",
-        };
-        for (const auto& path : runtimeSearchPaths) {
-            std::ifstream test(path);
-            if (test.good()) {
-                runtimePath = path;
-                break;
-            }
+        if (!jsonOutput) std::cout << "\n=== " << benchFile << " ===" << std::endl;
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Keep stdout for the JSON report
+            if (jsonOutput) dup2(STDERR_FILENO, STDOUT_FILENO);
+            setenv("CHRIS_BENCH_REPORT", reportPath.c_str(), 1);
+            int exitCode = runBenchFile(benchFile, jsonOutput);
+            std::cout.flush();
+            std::cerr.flush();
+            std::fflush(nullptr);
+            _exit(exitCode == 0 ? 0 : 1);
         }
-        if (runtimePath.empty()) {
-            std::cerr << "error: could not find chris runtime library" << std::endl;
-            totalFailed += (int)testNames.size();
-            continue;
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) < 0) {
+            errors.emplace_back(benchFile, "could not start a benchmark process");
+        } else if (WIFSIGNALED(status)) {
+            errors.emplace_back(benchFile, "crashed (signal " + std::to_string(WTERMSIG(status)) + ")");
+        } else if (WEXITSTATUS(status) != 0) {
+            errors.emplace_back(benchFile, "exited with code " + std::to_string(WEXITSTATUS(status)));
         }
 
-        // Link
-        if (!codegen.linkExecutable(objectPath, runtimePath, outputPath)) {
-            totalFailed += (int)testNames.size();
-            std::remove(objectPath.c_str());
-            continue;
+        std::istringstream report(readWholeFile(reportPath));
+        std::remove(reportPath.c_str());
+        std::string line;
+        while (std::getline(report, line)) {
+            std::vector<std::string> fields;
+            std::istringstream fieldStream(line);
+            for (std::string field; std::getline(fieldStream, field, '\t');) fields.push_back(field);
+            if (fields.size() != 6) continue;
+            BenchResult result;
+            result.file = benchFile;
+            result.name = fields[0];
+            result.iterations = std::strtoll(fields[1].c_str(), nullptr, 10);
+            if (result.iterations <= 0) continue;
+            double ops = static_cast<double>(result.iterations);
+            result.nsPerOp = std::strtod(fields[2].c_str(), nullptr) / ops;
+            result.allocsPerOp = std::strtod(fields[3].c_str(), nullptr) / ops;
+            result.bytesPerOp = std::strtod(fields[4].c_str(), nullptr) / ops;
+            result.collectionsPerOp = std::strtod(fields[5].c_str(), nullptr) / ops;
+            results.push_back(result);
         }
-        std::remove(objectPath.c_str());
+    }
 
-        // Run the test binary
-        std::string execPath = outputPath;
-        if (execPath.find('/') == std::string::npos) {
-            execPath = "./" + execPath;
+    int regressions = 0;
+    if (!baselinePath.empty()) {
+        for (auto* result : applyBenchBaseline(results, baseline)) {
+            std::cerr << "warning: " << result->file << ": no baseline for '" << result->name
+                      << "' in " << baselinePath << std::endl;
+        }
+        for (auto& result : results) {
+            if (isBenchRegression(result, maxRegression)) regressions++;
         }
-
-        std::cout << "\n=== " << testFile << " (" << testNames.size() << " test(s)) ===" << std::endl;
-        int exitCode = std::system(execPath.c_str());
-        exitCode = WEXITSTATUS(exitCode);
-
-        // The test binary returns the number of failures
-        int passed = (int)testNames.size() - exitCode;
-        if (passed < 0) passed = 0;
-        totalPassed += passed;
-        totalFailed += exitCode;
-        totalTests += (int)testNames.size();
-
-        // Clean up
-        std::remove(outputPath.c_str());
     }
 
-    // Final summary
-    std::cout << "\n========================================" << std::endl;
-    std::cout << "Total: " << totalTests << " test(s), "
-              << totalPassed << " passed, "
-              << totalFailed << " failed." << std::endl;
+    if (jsonOutput) {
+        printBenchReport(results, errors);
+    } else {
+        for (auto& [file, error] : errors) {
+            std::cout << "error: " << file << ": " << error << std::endl;
+        }
+        if (!baseline.empty()) {
+            std::cout << "\nCompared with " << baselinePath << ":" << std::endl;
+            for (auto& result : results) {
+                if (result.baselineNsPerOp <= 0) continue;
+                char line[160];
+                std::snprintf(line, sizeof(line), "  %-40s %12.2f -> %12.2f ns/op %+8.1f%%%s",
+                              result.name.c_str(), result.baselineNsPerOp, result.nsPerOp,
+                              benchChange(result),
+                              isBenchRegression(result, maxRegression) ? "  REGRESSION" : "");
+                std::cout << line << std::endl;
+            }
+        }
+        std::cout << "\n========================================" << std::endl;
+        std::cout << "Ran " << results.size() << " benchmark(s)";
+        if (!baseline.empty()) std::cout << ", " << regressions << " regression(s)";
+        std::cout << "." << std::endl;
+    }
 
-    return totalFailed > 0 ? 1 : 0;
+    return errors.empty() && regressions == 0 ? 0 : 1;
 }
 
 int fmtCommand(const std::string& inputFile, bool jsonOutput) {
@@ -635,11 +1367,20 @@ int main(int argc, char* argv[]) {
     }
 
     if (opts.command == "build") {
-        return chris::buildCommand(opts.inputFile, opts.jsonOutput, opts.linkerFlags);
+        return chris::buildCommand(opts.inputFile, opts.jsonOutput, opts.linkerFlags,
+                                   opts.debugInfo, opts.instrument, opts.profileGenerate,
+                                   opts.profileDir, opts.profileUse, opts.jobs);
     } else if (opts.command == "run") {
-        return chris::runCommand(opts.inputFile, opts.jsonOutput, opts.linkerFlags);
+        return chris::runCommand(opts.inputFile, opts.jsonOutput, opts.linkerFlags,
+                                 opts.debugInfo, opts.profile, opts.profilePath,
+                                 opts.instrument, opts.profileGenerate, opts.profileDir,
+                                 opts.profileUse, opts.aot, opts.jobs);
     } else if (opts.command == "test") {
-        return chris::testCommand(opts.inputFile, opts.jsonOutput);
+        return chris::testCommand(opts.inputFile, opts.jsonOutput, opts.jobs, opts.shard,
+                                  opts.shardCount);
+    } else if (opts.command == "bench") {
+        return chris::benchCommand(opts.inputFile, opts.jsonOutput, opts.baseline,
+                                   opts.maxRegression, opts.benchTime);
     } else if (opts.command == "fmt") {
         return chris::fmtCommand(opts.inputFile, opts.jsonOutput);
     } else if (opts.command == "lint") {
@@ -147,7 +147,7 @@ StmtPtr Parser::parseDeclaration() {
             }
             return cls;
         }
-        if (check(TokenType::KwClass)) {
+        if (check(TokenType::KwClass) || check(TokenType::KwStruct)) {
             auto cls = parseClassDecl(isPublic);
             if (cls) cls->annotations = std::move(annotations);
             return cls;
@@ -167,7 +167,7 @@ StmtPtr Parser::parseDeclaration() {
             if (func) func->annotations = std::move(annotations);
             return func;
         }
-        diagnostics_.error("E2001", "Expected 'class' or 'func' after access modifier", current().location);
+        diagnostics_.error("E2001", "Expected 'class', 'struct' or 'func' after access modifier", current().location);
         return nullptr;
     }
     if (check(TokenType::KwInterface)) {
@@ -202,7 +202,7 @@ StmtPtr Parser::parseDeclaration() {
         }
         return cls;
     }
-    if (check(TokenType::KwClass)) {
+    if (check(TokenType::KwClass) || check(TokenType::KwStruct)) {
         auto cls = parseClassDecl(false);
         if (cls) cls->annotations = std::move(annotations);
         return cls;
@@ -336,14 +336,17 @@ std::unique_ptr<EnumDecl> Parser::parseEnumDecl() {
 
 std::unique_ptr<ClassDecl> Parser::parseClassDecl(bool isPublic) {
     SourceLocation loc = current().location;
-    advance(); // consume 'class'
+    bool isStruct = check(TokenType::KwStruct);
+    advance(); // consume 'class' or 'struct'
 
-    Token name = expect(TokenType::Identifier, "Expected class name after 'class'");
+    Token name = expect(TokenType::Identifier,
+        isStruct ? "Expected struct name after 'struct'" : "Expected class name after 'class'");
 
     auto classDecl = std::make_unique<ClassDecl>();
     classDecl->location = loc;
     classDecl->name = name.value;
     classDecl->isPublic = isPublic;
+    classDecl->isStruct = isStruct;
 
     // Parse optional generic type parameters: class Box<T> or class Pair<K, V>
     if (check(TokenType::Less)) {
@@ -374,6 +377,9 @@ std::unique_ptr<ClassDecl> Parser::parseClassDecl(bool isPublic) {
     while (!check(TokenType::RightBrace) && !isAtEnd()) {
         skipComments();
 
+        // Annotations apply to the method that follows
+        auto memberAnnotations = parseAnnotations();
+
         // Parse optional access modifier for members
         AccessModifier memberAccess = AccessModifier::Private; // default
         if (check(TokenType::KwPublic)) {
@@ -391,6 +397,10 @@ std::unique_ptr<ClassDecl> Parser::parseClassDecl(bool isPublic) {
         }
 
         if (check(TokenType::KwVar) || check(TokenType::KwLet)) {
+            if (!memberAnnotations.empty()) {
+                diagnostics_.error("E2001", "Annotations are not supported on fields",
+                    memberAnnotations.front().location);
+            }
             auto field = parseVarDecl();
             if (field) {
                 field->access = memberAccess;
@@ -403,18 +413,21 @@ std::unique_ptr<ClassDecl> Parser::parseClassDecl(bool isPublic) {
             if (method) {
                 method->isAsync = true;
                 method->access = memberAccess;
+                method->annotations = std::move(memberAnnotations);
                 classDecl->methods.push_back(std::move(method));
             }
         } else if (check(TokenType::KwFunc)) {
             auto method = parseFuncDecl();
             if (method) {
                 method->access = memberAccess;
+                method->annotations = std::move(memberAnnotations);
                 classDecl->methods.push_back(std::move(method));
             }
         } else if (check(TokenType::KwOperator)) {
             auto opMethod = parseOperatorDecl();
             if (opMethod) {
                 opMethod->access = memberAccess;
+                opMethod->annotations = std::move(memberAnnotations);
                 classDecl->methods.push_back(std::move(opMethod));
             }
         } else {
@@ -550,6 +563,24 @@ std::unique_ptr<FuncDecl> Parser::parseFuncDecl() {
     Token name = (check(TokenType::KwNew))
         ? advance()
         : expect(TokenType::Identifier, "Expected function name after 'func'");
+
+    // Parse optional generic type parameters: func largest<T: Comparable>(...)
+    std::vector<std::string> typeParams;
+    std::vector<std::string> typeParamBounds;
+    if (check(TokenType::Less)) {
+        advance(); // consume '<'
+        do {
+            Token param = expect(TokenType::Identifier, "Expected type parameter name");
+            typeParams.push_back(param.value);
+            std::string bound;
+            if (match(TokenType::Colon)) {
+                bound = expect(TokenType::Identifier, "Expected bound after ':'").value;
+            }
+            typeParamBounds.push_back(bound);
+        } while (match(TokenType::Comma));
+        expect(TokenType::Greater, "Expected '>' after type parameters");
+    }
+
     expect(TokenType::LeftParen, "Expected '(' after function name");
 
     std::vector<Parameter> params;
@@ -599,6 +630,8 @@ std::unique_ptr<FuncDecl> Parser::parseFuncDecl() {
     func->location = loc;
     func->name = name.value;
     func->asyncKind = asyncKind;
+    func->typeParams = std::move(typeParams);
+    func->typeParamBounds = std::move(typeParamBounds);
     func->parameters = std::move(params);
     func->returnType = std::move(returnType);
     func->body = std::move(body);
@@ -1725,6 +1758,19 @@ TypeExprPtr Parser::parseTypeExpr() {
     type->name = name.value;
     type->nullable = false;
 
+    // Bytes shorthand: Bytes -> Array<UInt8>
+    if (type->name == "Bytes") {
+        auto byteType = std::make_unique<NamedType>();
+        byteType->location = name.location;
+        byteType->name = "UInt8";
+        type->name = "Array";
+        type->typeArgs.push_back(std::move(byteType));
+        if (match(TokenType::QuestionMark)) {
+            type->nullable = true;
+        }
+        return type;
+    }
+
     // Parse optional generic type arguments: Box<Int> or Pair<Int, String>
     if (check(TokenType::Less)) {
         advance(); // consume '<'
@@ -1766,6 +1812,7 @@ void Parser::synchronize() {
             case TokenType::KwReturn:
             case TokenType::KwImport:
             case TokenType::KwClass:
+            case TokenType::KwStruct:
                 return;
             default:
                 advance();
@@ -45,4 +45,11 @@ Symbol* SymbolTable::lookupLocal(const std::string& name) {
     return current_->lookupLocal(name);
 }
 
+Scope* SymbolTable::scopeOf(const std::string& name) {
+    for (Scope* scope = current_.get(); scope; scope = scope->parent().get()) {
+        if (scope->lookupLocal(name)) return scope;
+    }
+    return nullptr;
+}
+
 } // namespace chris
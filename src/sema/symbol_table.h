@@ -39,6 +39,7 @@ public:
     bool define(const std::string& name, TypePtr type, bool isMutable, const SourceLocation& loc);
     Symbol* lookup(const std::string& name);
     Symbol* lookupLocal(const std::string& name);
+    Scope* scopeOf(const std::string& name); // innermost scope defining name, or nullptr
     std::shared_ptr<Scope> currentScope() const { return current_; }
 
 private:
@@ -1,6 +1,8 @@
 #include "sema/type_checker.h"
+#include <algorithm>
 #include <sstream>
 #include <set>
+#include <unordered_set>
 
 namespace chris {
 
@@ -29,6 +31,7 @@ void TypeChecker::check(Program& program) {
             auto classType = std::make_shared<ClassType>();
             classType->name = cls->name;
             classType->isShared = cls->isShared;
+            classType->isStruct = cls->isStruct;
             classType->typeParams = cls->typeParams;
             classTypes_[cls->name] = classType;
             symbols_.define(cls->name, classType, false, cls->location);
@@ -53,6 +56,20 @@ void TypeChecker::check(Program& program) {
     // Pass 1: register all top-level function, class, and interface signatures
     for (auto& decl : program.declarations) {
         if (auto* func = dynamic_cast<FuncDecl*>(decl.get())) {
+            // Generic functions are checked once with their type parameters
+            // and instantiated per set of type arguments after Pass 2
+            funcDecls_[func->name] = func;
+            if (!func->typeParams.empty()) {
+                genericFuncDecls_[func->name] = func;
+                for (auto& bound : func->typeParamBounds) {
+                    if (!bound.empty() && bound != "Comparable" && bound != "Numeric" &&
+                        !interfaceTypes_.count(bound)) {
+                        diagnostics_.error("E3016", "Unknown type '" + bound + "'", func->location);
+                    }
+                }
+            }
+            currentTypeParams_ = func->typeParams;
+            currentTypeBounds_ = func->typeParamBounds;
             std::vector<TypePtr> paramTypes;
             for (auto& param : func->parameters) {
                 if (param.type) {
@@ -64,6 +81,8 @@ void TypeChecker::check(Program& program) {
             TypePtr retType = func->returnType
                 ? resolveTypeAnnotation(*func->returnType)
                 : voidType();
+            currentTypeParams_.clear();
+            currentTypeBounds_.clear();
             // Async functions return Future<T> instead of T
             if (func->isAsync) {
                 retType = makeFutureType(retType);
@@ -167,18 +186,30 @@ void TypeChecker::check(Program& program) {
     for (auto& decl : program.declarations) {
         checkStmt(*decl);
     }
+
+    // Pass 3: instantiate the generic functions reached from concrete code
+    instantiateGenericFunctions();
 }
 
 // --- Annotations ---
 
 void TypeChecker::validateAnnotations(const std::vector<Annotation>& annotations, const std::string& declKind, const SourceLocation& loc) {
     static const std::unordered_map<std::string, std::vector<std::string>> knownAnnotations = {
-        {"Deprecated", {"func", "class", "interface", "enum"}},
+        {"Deprecated", {"func", "class", "struct", "interface", "enum"}},
         {"Serializable", {"class"}},
-        {"CLayout", {"class"}},
+        {"CLayout", {"class", "struct"}},
         {"Test", {"func"}},
+        {"Benchmark", {"func"}},
         {"Inline", {"func"}},
+        {"NoInline", {"func"}},
+        {"Hot", {"func"}},
+        {"Cold", {"func"}},
+        {"Pure", {"func"}},
+        {"ReadOnly", {"func"}},
         {"NoReturn", {"func"}},
+        {"Instrument", {"func"}},
+        {"NoInstrument", {"func"}},
+        {"Unchecked", {"func"}},
     };
 
     for (auto& ann : annotations) {
@@ -201,6 +232,24 @@ void TypeChecker::validateAnnotations(const std::vector<Annotation>& annotations
                 ann.location);
         }
     }
+
+    // Optimisation hints that contradict each other
+    static const std::pair<const char*, const char*> conflicting[] = {
+        {"Inline", "NoInline"}, {"Hot", "Cold"}, {"Pure", "ReadOnly"},
+    };
+    for (auto& [first, second] : conflicting) {
+        const Annotation* a = nullptr;
+        const Annotation* b = nullptr;
+        for (auto& ann : annotations) {
+            if (ann.name == first) a = &ann;
+            if (ann.name == second) b = &ann;
+        }
+        if (a && b) {
+            diagnostics_.error("E3041",
+                std::string("Annotations '@") + first + "' and '@" + second + "' cannot be combined",
+                b->location);
+        }
+    }
 }
 
 // --- Declarations ---
@@ -217,6 +266,16 @@ void TypeChecker::checkFuncDecl(FuncDecl& func) {
         }
     }
 
+    // Generic functions: the body is checked once against the bounds
+    auto prevTypeParams = currentTypeParams_;
+    auto prevTypeBounds = currentTypeBounds_;
+    auto prevGenericFunc = currentGenericFunc_;
+    if (!func.typeParams.empty()) {
+        currentTypeParams_ = func.typeParams;
+        currentTypeBounds_ = func.typeParamBounds;
+        currentGenericFunc_ = func.name;
+    }
+
     symbols_.pushScope();
 
     // Register parameters
@@ -249,13 +308,86 @@ void TypeChecker::checkFuncDecl(FuncDecl& func) {
     }
 
     // Check body
+    Block* prevBody = currentFuncBody_;
+    currentFuncBody_ = func.body.get();
+    size_t firstClosure = localClosures_.size();
     for (auto& stmt : func.body->statements) {
         checkStmt(*stmt);
     }
+    resolveLocalClosures(*func.body, firstClosure);
+    currentFuncBody_ = prevBody;
 
     inAsyncFunction_ = prevAsync;
     currentReturnType_ = prevReturnType;
     symbols_.popScope();
+    currentTypeParams_ = prevTypeParams;
+    currentTypeBounds_ = prevTypeBounds;
+    currentGenericFunc_ = prevGenericFunc;
+}
+
+// The element type an array literal takes where a value of `type` is
+// expected, e.g. UInt8 for `var bytes: [UInt8] = [1, 2]`
+static TypePtr expectedElementsOf(const TypePtr& type) {
+    if (!type || type->kind() != TypeKind::Array) return nullptr;
+    auto elemType = static_cast<const ArrayType&>(*type).elementType;
+    if (!elemType || elemType->kind() == TypeKind::Unknown ||
+        elemType->kind() == TypeKind::TypeParameter) {
+        return nullptr;
+    }
+    return elemType;
+}
+
+// Map values are stored in runtime memory the collector doesn't scan, so
+// they may be numbers, Bool, Char and structs of those, but no references
+static bool isUntracedValue(const TypePtr& type) {
+    if (!type) return false;
+    switch (type->kind()) {
+        case TypeKind::Int: case TypeKind::UInt:
+        case TypeKind::Int8: case TypeKind::UInt8:
+        case TypeKind::Int16: case TypeKind::UInt16:
+        case TypeKind::Int32: case TypeKind::UInt32:
+        case TypeKind::Float: case TypeKind::Float32:
+        case TypeKind::Bool: case TypeKind::Char:
+            return true;
+        case TypeKind::Class: {
+            auto& cls = static_cast<const ClassType&>(*type);
+            if (!cls.isStruct) return false;
+            for (auto& field : cls.fields) {
+                if (!isUntracedValue(field.type)) return false;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// The map type a `Map()` call takes where a value of `type` is expected,
+// e.g. Map<String, Float32> for `var m: Map<String, Float32> = Map()`
+static TypePtr expectedMapOf(const TypePtr& type) {
+    if (!type || type->kind() != TypeKind::Map) return nullptr;
+    auto& map = static_cast<const MapType&>(*type);
+    if (!map.keyType || map.keyType->kind() != TypeKind::String) return nullptr;
+    return isUntracedValue(map.valueType) ? type : nullptr;
+}
+
+// The sized pointer built-ins (ptrLoadInt32, ptrStoreU16BE, ...) take an
+// optional trailing alignment the address is known to have
+static bool takesAlignment(const std::string& name) {
+    static const char* const sized[] = {"Int32", "Int16", "Float64", "Float32",
+                                        "U16LE", "U16BE", "U32LE", "U32BE", "U64LE", "U64BE"};
+    for (const char* suffix : sized) {
+        if (name == std::string("ptrLoad") + suffix || name == std::string("ptrStore") + suffix) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool isMapConstructor(const Expr& expr) {
+    auto* call = dynamic_cast<const CallExpr*>(&expr);
+    auto* callee = call ? dynamic_cast<const IdentifierExpr*>(call->callee.get()) : nullptr;
+    return callee && callee->name == "Map" && call->arguments.empty();
 }
 
 void TypeChecker::checkVarDecl(VarDecl& decl) {
@@ -266,6 +398,11 @@ void TypeChecker::checkVarDecl(VarDecl& decl) {
 
     TypePtr initType = nullptr;
     if (decl.initializer) {
+        if (dynamic_cast<ArrayLiteralExpr*>(decl.initializer.get())) {
+            expectedElementType_ = expectedElementsOf(declaredType);
+        } else if (isMapConstructor(*decl.initializer)) {
+            expectedMapType_ = expectedMapOf(declaredType);
+        }
         initType = checkExpr(*decl.initializer);
     }
 
@@ -303,6 +440,11 @@ void TypeChecker::checkVarDecl(VarDecl& decl) {
             "Variable '" + decl.name + "' is already defined in this scope",
             decl.location);
     }
+
+    // A local closure stays on the stack if the rest of the body only calls it
+    if (auto* lambda = dynamic_cast<LambdaExpr*>(decl.initializer.get())) {
+        if (currentFuncBody_) localClosures_.push_back({&decl, lambda});
+    }
 }
 
 void TypeChecker::checkImportDecl(ImportDecl& /*decl*/) {
@@ -320,11 +462,15 @@ void TypeChecker::checkEnumDecl(EnumDecl& decl) {
 }
 
 void TypeChecker::checkClassDecl(ClassDecl& decl) {
-    validateAnnotations(decl.annotations, "class", decl.location);
+    validateAnnotations(decl.annotations, decl.isStruct ? "struct" : "class", decl.location);
 
     auto it = classTypes_.find(decl.name);
     if (it == classTypes_.end()) return;
 
+    if (decl.isStruct) {
+        checkStructLayout(decl, *it->second);
+    }
+
     auto savedClass = currentClass_;
     currentClass_ = it->second;
 
@@ -383,6 +529,55 @@ void TypeChecker::checkClassDecl(ClassDecl& decl) {
     currentClass_ = savedClass;
 }
 
+// Structs are copied by value and stored inline without a GC header, so the
+// collector never sees inside them: they can't hold references, inherit, or
+// be generic.
+void TypeChecker::checkStructLayout(ClassDecl& decl, const ClassType& structType) {
+    if (!decl.baseClass.empty() || !decl.interfaces.empty()) {
+        diagnostics_.error("E3050",
+            "Struct '" + decl.name + "' cannot inherit or implement interfaces",
+            decl.location);
+    }
+    if (!decl.typeParams.empty()) {
+        diagnostics_.error("E3050",
+            "Struct '" + decl.name + "' cannot be generic",
+            decl.location);
+    }
+    for (size_t i = 0; i < structType.fields.size() && i < decl.fields.size(); i++) {
+        auto& field = structType.fields[i];
+        auto* fieldClass = dynamic_cast<ClassType*>(field.type.get());
+        if (fieldClass && fieldClass->name == decl.name) {
+            diagnostics_.error("E3051",
+                "Struct '" + decl.name + "' cannot contain itself",
+                decl.fields[i]->location);
+        } else if (!isValueType(field.type)) {
+            diagnostics_.error("E3051",
+                "Field '" + field.name + "' of struct '" + decl.name + "' has type '" +
+                field.type->toString() + "'; struct fields must be numbers, Bool, Char, "
+                "simple enums or other structs",
+                decl.fields[i]->location);
+        }
+    }
+}
+
+bool TypeChecker::isValueType(const TypePtr& type) const {
+    switch (type->kind()) {
+        case TypeKind::Int: case TypeKind::Int8: case TypeKind::Int16: case TypeKind::Int32:
+        case TypeKind::UInt: case TypeKind::UInt8: case TypeKind::UInt16: case TypeKind::UInt32:
+        case TypeKind::Float: case TypeKind::Float32:
+        case TypeKind::Bool: case TypeKind::Char: case TypeKind::Vector:
+            return true;
+        case TypeKind::Enum:
+            return static_cast<const EnumType*>(type.get())->associatedTypes.empty();
+        case TypeKind::Class:
+            // Interfaces share TypeKind::Class
+            if (auto* classType = dynamic_cast<const ClassType*>(type.get())) return classType->isStruct;
+            return false;
+        default:
+            return false;
+    }
+}
+
 // --- Statements ---
 
 void TypeChecker::checkStmt(Stmt& stmt) {
@@ -473,6 +668,13 @@ void TypeChecker::checkForStmt(ForStmt& stmt) {
         // Range of Int -> loop variable is Int
         (void)rangeExpr;
         elemType = intType();
+    } else if (auto* call = dynamic_cast<CallExpr*>(stmt.iterable.get());
+               call && dynamic_cast<IdentifierExpr*>(call->callee.get()) &&
+               (static_cast<IdentifierExpr*>(call->callee.get())->name == "fileLines" ||
+                static_cast<IdentifierExpr*>(call->callee.get())->name == "walk" ||
+                static_cast<IdentifierExpr*>(call->callee.get())->name == "walkMatching")) {
+        // for line in fileLines(reader), for path in walk(root) -> loop variable is String
+        elemType = stringType();
     } else if (iterableType && iterableType->kind() == TypeKind::Array) {
         // Array iteration -> loop variable is the element type
         auto* arrType = static_cast<const ArrayType*>(iterableType.get());
@@ -495,6 +697,11 @@ void TypeChecker::checkReturnStmt(ReturnStmt& stmt) {
                 expectedLambdaParamTypes_ = &expectedFunc.paramTypes;
             }
         }
+        if (dynamic_cast<ArrayLiteralExpr*>(stmt.value.get())) {
+            expectedElementType_ = expectedElementsOf(currentReturnType_);
+        } else if (isMapConstructor(*stmt.value)) {
+            expectedMapType_ = expectedMapOf(currentReturnType_);
+        }
         auto valueType = checkExpr(*stmt.value);
         expectedLambdaParamTypes_ = nullptr;
         // If current return type is unknown (lambda inference), infer it from the return value
@@ -524,6 +731,13 @@ void TypeChecker::checkExprStmt(ExprStmt& stmt) {
 // --- Expressions ---
 
 TypePtr TypeChecker::checkExpr(Expr& expr) {
+    // Code generation reads the type back, e.g. for the element storage of
+    // an array that didn't come from a literal
+    expr.type = checkExprNode(expr);
+    return expr.type;
+}
+
+TypePtr TypeChecker::checkExprNode(Expr& expr) {
     if (auto* e = dynamic_cast<IntLiteralExpr*>(&expr))              return checkIntLiteral(*e);
     if (auto* e = dynamic_cast<FloatLiteralExpr*>(&expr))            return checkFloatLiteral(*e);
     if (auto* e = dynamic_cast<StringLiteralExpr*>(&expr))           return checkStringLiteral(*e);
@@ -574,9 +788,12 @@ TypePtr TypeChecker::checkNilLiteral(NilLiteralExpr& /*expr*/) {
 }
 
 TypePtr TypeChecker::checkIdentifier(IdentifierExpr& expr) {
-    // Built-in Map constructor: Map() creates a Map<String, Int> by default
+    // Built-in Map constructor: Map() creates the map it initialises, or a
+    // Map<String, Int> by default
     if (expr.name == "Map") {
-        return makeFunctionType({}, makeMapType(stringType(), intType()));
+        TypePtr expected = expectedMapType_;
+        expectedMapType_ = nullptr;
+        return makeFunctionType({}, expected ? expected : makeMapType(stringType(), intType()));
     }
 
     // Built-in Set constructor: Set() creates a Set<String> by default
@@ -613,6 +830,50 @@ TypePtr TypeChecker::checkIdentifier(IdentifierExpr& expr) {
         return makeFunctionType({stringType()}, boolType());
     }
 
+    // Built-in memory-mapped file functions (handle is an opaque GC-managed Ptr)
+    if (expr.name == "mmapOpen") return makeFunctionType({stringType()}, ptrType());
+    if (expr.name == "mmapOpenWritable") return makeFunctionType({stringType()}, ptrType());
+    if (expr.name == "mmapData") return makeFunctionType({ptrType()}, ptrType());
+    if (expr.name == "mmapSize") return makeFunctionType({ptrType()}, intType());
+    if (expr.name == "mmapAdvise") return makeFunctionType({ptrType(), intType()}, boolType());
+    if (expr.name == "mmapSync") return makeFunctionType({ptrType()}, boolType());
+    if (expr.name == "mmapSlice") return makeFunctionType({ptrType(), intType(), intType()}, stringType());
+    if (expr.name == "mmapIndexOf") return makeFunctionType({ptrType(), stringType(), intType()}, intType());
+    if (expr.name == "mmapClose") return makeFunctionType({ptrType()}, voidType());
+
+    // Buffered file streams (handles are GC-managed; finalizers flush and close)
+    if (expr.name == "fileReaderOpen") return makeFunctionType({stringType()}, ptrType());
+    if (expr.name == "fileReaderOpenWith") {
+        return makeFunctionType({stringType(), intType(), intType()}, ptrType());
+    }
+    if (expr.name == "fileReadLine") return makeFunctionType({ptrType()}, makeNullable(stringType()));
+    if (expr.name == "fileLines") return makeFunctionType({ptrType()}, ptrType());
+    if (expr.name == "fileReadInto") return makeFunctionType({ptrType(), ptrType(), intType()}, intType());
+    if (expr.name == "fileReaderClose") return makeFunctionType({ptrType()}, voidType());
+    if (expr.name == "fileWriterOpen") return makeFunctionType({stringType(), boolType()}, ptrType());
+    if (expr.name == "fileWriterOpenWith") {
+        return makeFunctionType({stringType(), boolType(), intType(), intType()}, ptrType());
+    }
+    if (expr.name == "fileWrite") return makeFunctionType({ptrType(), stringType()}, boolType());
+    if (expr.name == "fileWriteLine") return makeFunctionType({ptrType(), stringType()}, boolType());
+    if (expr.name == "fileWriteAll") return makeFunctionType({ptrType(), ptrType(), intType()}, boolType());
+    if (expr.name == "fileFlush") return makeFunctionType({ptrType()}, boolType());
+    if (expr.name == "fileWriterClose") return makeFunctionType({ptrType()}, boolType());
+
+    // Filesystem metadata and traversal
+    if (expr.name == "fileSize") return makeFunctionType({stringType()}, intType());
+    if (expr.name == "fileModifiedTime") return makeFunctionType({stringType()}, intType());
+    if (expr.name == "isDirectory") return makeFunctionType({stringType()}, boolType());
+    if (expr.name == "listDir") return makeFunctionType({stringType()}, makeArrayType(stringType()));
+    if (expr.name == "walk") return makeFunctionType({stringType()}, ptrType());
+    if (expr.name == "walkMatching") return makeFunctionType({stringType(), stringType()}, ptrType());
+    if (expr.name == "walkNext") return makeFunctionType({ptrType()}, makeNullable(stringType()));
+    if (expr.name == "walkClose") return makeFunctionType({ptrType()}, voidType());
+    if (expr.name == "parallelForEachFile") {
+        return makeFunctionType({stringType(), stringType(),
+                                 makeFunctionType({stringType()}, voidType())}, intType());
+    }
+
     // Built-in math functions (Int)
     if (expr.name == "abs") return makeFunctionType({intType()}, intType());
     if (expr.name == "min") return makeFunctionType({intType(), intType()}, intType());
@@ -727,6 +988,22 @@ TypePtr TypeChecker::checkIdentifier(IdentifierExpr& expr) {
     if (expr.name == "ptrStoreInt32") return makeFunctionType({ptrType(), intType()}, voidType());
     if (expr.name == "ptrLoadInt16") return makeFunctionType({ptrType()}, intType());
     if (expr.name == "ptrStoreInt16") return makeFunctionType({ptrType(), intType()}, voidType());
+    if (expr.name == "ptrLoadFloat64") return makeFunctionType({ptrType()}, floatType());
+    if (expr.name == "ptrStoreFloat64") return makeFunctionType({ptrType(), floatType()}, voidType());
+    if (expr.name == "ptrLoadFloat32") return makeFunctionType({ptrType()}, float32Type());
+    if (expr.name == "ptrStoreFloat32") return makeFunctionType({ptrType(), float32Type()}, voidType());
+
+    // Unaligned fixed-byte-order integer access (zero-extended to Int)
+    if (expr.name == "ptrLoadU16LE" || expr.name == "ptrLoadU16BE" ||
+        expr.name == "ptrLoadU32LE" || expr.name == "ptrLoadU32BE" ||
+        expr.name == "ptrLoadU64LE" || expr.name == "ptrLoadU64BE") {
+        return makeFunctionType({ptrType()}, intType());
+    }
+    if (expr.name == "ptrStoreU16LE" || expr.name == "ptrStoreU16BE" ||
+        expr.name == "ptrStoreU32LE" || expr.name == "ptrStoreU32BE" ||
+        expr.name == "ptrStoreU64LE" || expr.name == "ptrStoreU64BE") {
+        return makeFunctionType({ptrType(), intType()}, voidType());
+    }
 
     // Built-in memory functions
     if (expr.name == "memcpy") return makeFunctionType({ptrType(), ptrType(), intType()}, voidType());
@@ -735,6 +1012,9 @@ TypePtr TypeChecker::checkIdentifier(IdentifierExpr& expr) {
     // Built-in sizeof
     if (expr.name == "sizeofType") return makeFunctionType({stringType()}, intType());
 
+    // Built-in blackBox(x) -> x, opaque to the optimiser (see checkCallExpr)
+    if (expr.name == "blackBox") return makeFunctionType({unknownType()}, unknownType());
+
     // Built-in test assertions
     if (expr.name == "assert") return makeFunctionType({boolType(), stringType()}, voidType());
     if (expr.name == "assertEqual") return makeFunctionType({unknownType(), unknownType(), stringType()}, voidType());
@@ -748,6 +1028,7 @@ TypePtr TypeChecker::checkIdentifier(IdentifierExpr& expr) {
             expr.location);
         return unknownType();
     }
+    noteCapture(expr.name);
     return sym->type;
 }
 
@@ -760,6 +1041,34 @@ TypePtr TypeChecker::checkBinaryExpr(BinaryExpr& expr) {
         return unknownType();
     }
 
+    if (leftType->kind() == TypeKind::Vector || rightType->kind() == TypeKind::Vector) {
+        return checkVectorOperator(expr, leftType, rightType);
+    }
+
+    // Operators on type parameters are allowed by their bound
+    if (leftType->kind() == TypeKind::TypeParameter || rightType->kind() == TypeKind::TypeParameter) {
+        auto paramType = leftType->kind() == TypeKind::TypeParameter ? leftType : rightType;
+        auto& bound = static_cast<TypeParameterType&>(*paramType).bound;
+        std::string required;
+        if (expr.op == "+" || expr.op == "-" || expr.op == "*" || expr.op == "/" || expr.op == "%") {
+            if (bound != "Numeric") required = "Numeric";
+        } else if (expr.op == "<" || expr.op == ">" || expr.op == "<=" || expr.op == ">=") {
+            if (bound != "Numeric" && bound != "Comparable") required = "Comparable";
+        } else if (expr.op != "==" && expr.op != "!=") {
+            required = "a concrete type";
+        }
+        if (!required.empty()) {
+            diagnostics_.error("E3010",
+                "Operator '" + expr.op + "' on type parameter '" + paramType->toString() +
+                "' requires " + (required == "a concrete type" ? required : "the bound '" + required + "'"),
+                expr.location);
+            return unknownType();
+        }
+        bool arithmetic = expr.op == "+" || expr.op == "-" || expr.op == "*" ||
+                          expr.op == "/" || expr.op == "%";
+        return arithmetic ? paramType : boolType();
+    }
+
     // Check for operator overloading on class types
     if (leftType->kind() == TypeKind::Class) {
         auto* classType = dynamic_cast<const ClassType*>(leftType.get());
@@ -839,6 +1148,14 @@ TypePtr TypeChecker::checkBinaryExpr(BinaryExpr& expr) {
 
     // Equality: ==, !=
     if (expr.op == "==" || expr.op == "!=") {
+        auto* leftClass = dynamic_cast<ClassType*>(leftType.get());
+        if (leftClass && leftClass->isStruct) {
+            diagnostics_.error("E3010",
+                "Operator '" + expr.op + "' is not defined for struct '" + leftType->toString() +
+                "'; compare its fields",
+                expr.location);
+            return boolType();
+        }
         if (!leftType->equals(*rightType) &&
             !(leftType->isNumeric() && rightType->isNumeric())) {
             diagnostics_.error("E3010",
@@ -886,10 +1203,52 @@ TypePtr TypeChecker::checkBinaryExpr(BinaryExpr& expr) {
     return unknownType();
 }
 
+// Operators on SIMD vectors apply lane by lane to two vectors of the same
+// type; comparisons produce a mask with one lane per element
+TypePtr TypeChecker::checkVectorOperator(BinaryExpr& expr, const TypePtr& leftType,
+                                         const TypePtr& rightType) {
+    if (!leftType->equals(*rightType)) {
+        diagnostics_.error("E3010",
+            "Operator '" + expr.op + "' requires matching vector types, got '" +
+            leftType->toString() + "' and '" + rightType->toString() + "'",
+            expr.location);
+        return unknownType();
+    }
+    auto& vec = static_cast<VectorType&>(*leftType);
+    const std::string& op = expr.op;
+    bool integer = !vec.isFloat() && !vec.isMask();
+    if (op == "==" || op == "!=") return makeVectorType(boolType(), vec.lanes);
+    if (!vec.isMask()) {
+        if (op == "+" || op == "-" || op == "*" || op == "/") return leftType;
+        if (op == "<" || op == ">" || op == "<=" || op == ">=") {
+            return makeVectorType(boolType(), vec.lanes);
+        }
+        if (integer && (op == "%" || op == "<<" || op == ">>")) return leftType;
+    }
+    if ((integer || vec.isMask()) && (op == "&" || op == "|" || op == "^")) return leftType;
+    diagnostics_.error("E3010",
+        "Operator '" + op + "' is not defined for '" + leftType->toString() + "'",
+        expr.location);
+    return unknownType();
+}
+
 TypePtr TypeChecker::checkUnaryExpr(UnaryExpr& expr) {
     auto operandType = checkExpr(*expr.operand);
     if (!operandType || operandType->kind() == TypeKind::Unknown) return unknownType();
 
+    if (operandType->kind() == TypeKind::Vector) {
+        auto& vec = static_cast<VectorType&>(*operandType);
+        bool integer = !vec.isFloat() && !vec.isMask();
+        if ((expr.op == "-" && !vec.isMask()) || (expr.op == "!" && vec.isMask()) ||
+            (expr.op == "~" && integer)) {
+            return operandType;
+        }
+        diagnostics_.error("E3011",
+            "Unary '" + expr.op + "' is not defined for '" + operandType->toString() + "'",
+            expr.location);
+        return unknownType();
+    }
+
     if (expr.op == "-") {
         if (!operandType->isNumeric()) {
             diagnostics_.error("E3011",
@@ -935,9 +1294,13 @@ TypePtr TypeChecker::checkCallExpr(CallExpr& expr) {
             }
             diagnostics_.warning("W3041", msg, expr.location);
         }
+        auto git = genericFuncDecls_.find(ident->name);
+        if (git != genericFuncDecls_.end()) return checkGenericCall(expr, *git->second);
     }
 
     auto calleeType = checkExpr(*expr.callee);
+    bool arrayCallback = arrayCallbackCallee_ && arrayCallbackCallee_ == expr.callee.get();
+    arrayCallbackCallee_ = nullptr;
 
     if (!calleeType || calleeType->kind() == TypeKind::Unknown) {
         // Still check arguments
@@ -958,9 +1321,29 @@ TypePtr TypeChecker::checkCallExpr(CallExpr& expr) {
     }
 
     auto& funcType = static_cast<FunctionType&>(*calleeType);
+    expr.calleeType = calleeType;
+    auto* calleeIdent = dynamic_cast<IdentifierExpr*>(expr.callee.get());
+
+    // An alignment after a sized pointer access's own arguments must be a
+    // power-of-two literal; codegen emits it as the access's alignment
+    size_t argCount = expr.arguments.size();
+    if (calleeIdent && takesAlignment(calleeIdent->name) &&
+        argCount == funcType.paramTypes.size() + 1) {
+        auto& alignArg = *expr.arguments.back();
+        checkExpr(alignArg);
+        auto* align = dynamic_cast<IntLiteralExpr*>(&alignArg);
+        if (!align || align->value <= 0 || align->value > (int64_t(1) << 32) ||
+            (align->value & (align->value - 1)) != 0) {
+            diagnostics_.error("E3057",
+                "Alignment of '" + calleeIdent->name +
+                "' must be a power-of-two integer literal of at most 2^32",
+                alignArg.location);
+        }
+        argCount--;
+    }
 
     // Check arity
-    if (expr.arguments.size() != funcType.paramTypes.size()) {
+    if (argCount != funcType.paramTypes.size()) {
         diagnostics_.error("E3013",
             "Expected " + std::to_string(funcType.paramTypes.size()) +
             " argument(s), got " + std::to_string(expr.arguments.size()),
@@ -968,8 +1351,15 @@ TypePtr TypeChecker::checkCallExpr(CallExpr& expr) {
     }
 
     // Check argument types — propagate expected types to lambda args for inference
-    size_t count = std::min(expr.arguments.size(), funcType.paramTypes.size());
+    size_t count = std::min(argCount, funcType.paramTypes.size());
+    TypePtr firstArgType;
     for (size_t i = 0; i < count; i++) {
+        // The callback of Array map/filter/forEach/reduce is its last argument
+        bool callbackArg = arrayCallback && i + 1 == expr.arguments.size() &&
+                           expr.arguments.size() == funcType.paramTypes.size();
+        if (callbackArg || (calleeIdent && argumentStaysLocal(calleeIdent->name, i))) {
+            localCallbackArgs_.insert(expr.arguments[i].get());
+        }
         // If the argument is a lambda and the expected type is a function, propagate param types
         if (auto* lambda = dynamic_cast<LambdaExpr*>(expr.arguments[i].get())) {
             auto expectedType = funcType.paramTypes[i];
@@ -977,9 +1367,19 @@ TypePtr TypeChecker::checkCallExpr(CallExpr& expr) {
                 auto& expectedFunc = static_cast<FunctionType&>(*expectedType);
                 expectedLambdaParamTypes_ = &expectedFunc.paramTypes;
             }
+            // Lambda literal callbacks are expanded into the array loop
+            inlineLambdaArg_ = callbackArg;
+            lambda->escapes = !localCallbackArgs_.count(lambda);
+        }
+        if (dynamic_cast<ArrayLiteralExpr*>(expr.arguments[i].get())) {
+            expectedElementType_ = expectedElementsOf(funcType.paramTypes[i]);
+        } else if (isMapConstructor(*expr.arguments[i])) {
+            expectedMapType_ = expectedMapOf(funcType.paramTypes[i]);
         }
         auto argType = checkExpr(*expr.arguments[i]);
+        if (i == 0) firstArgType = argType;
         expectedLambdaParamTypes_ = nullptr;
+        inlineLambdaArg_ = false;
         if (argType && !isAssignable(funcType.paramTypes[i], argType)) {
             diagnostics_.error("E3014",
                 "Argument " + std::to_string(i + 1) + ": expected '" +
@@ -994,13 +1394,73 @@ TypePtr TypeChecker::checkCallExpr(CallExpr& expr) {
         checkExpr(*expr.arguments[i]);
     }
 
+    // blackBox returns its argument
+    if (calleeIdent && calleeIdent->name == "blackBox" && firstArgType) return firstArgType;
+
+    auto* calleeMember = dynamic_cast<MemberExpr*>(expr.callee.get());
+    auto vectorType = calleeMember ? resolveTypeName(calleeMember->receiverType) : nullptr;
+    if (vectorType && vectorType->kind() == TypeKind::Vector) {
+        auto& vec = static_cast<VectorType&>(*vectorType);
+        const std::string& member = calleeMember->member;
+        // Arrays feeding integer lanes hold integers, float lanes floats
+        bool arrayArg = member == "loadArray" || member == "storeArray" || member == "gather";
+        if (arrayArg && firstArgType) {
+            auto* arrayType = dynamic_cast<ArrayType*>(firstArgType.get());
+            auto elemType = arrayType ? arrayType->elementType : nullptr;
+            bool floatElems = elemType && (elemType->kind() == TypeKind::Float ||
+                                           elemType->kind() == TypeKind::Float32);
+            if (!elemType || !elemType->isNumeric() || floatElems != vec.isFloat()) {
+                diagnostics_.error("E3014",
+                    "Argument 1: expected an array of " +
+                    std::string(vec.isFloat() ? "Float or Float32" : "integers") +
+                    " for '" + vectorType->toString() + "'",
+                    expr.arguments[0]->location);
+            }
+        }
+        // Shuffles pick lanes by constant index
+        if (member == "shuffle") {
+            auto lanes = vec.lanes;
+            for (auto& arg : expr.arguments) {
+                auto* index = dynamic_cast<IntLiteralExpr*>(arg.get());
+                if (!index || index->value < 0 || index->value >= static_cast<int64_t>(lanes)) {
+                    diagnostics_.error("E3055",
+                        "Shuffle lane indexes must be integer literals from 0 to " +
+                        std::to_string(lanes - 1),
+                        arg->location);
+                }
+            }
+        }
+    }
+
     return funcType.returnType;
 }
 
 TypePtr TypeChecker::checkMemberExpr(MemberExpr& expr) {
+    // Static members of the SIMD types: Float32x8.splat(1.0), Int32x4.load(p)
+    if (auto* typeIdent = dynamic_cast<IdentifierExpr*>(expr.object.get())) {
+        auto vectorType = resolveTypeName(typeIdent->name);
+        if (vectorType && vectorType->kind() == TypeKind::Vector && !symbols_.lookup(typeIdent->name)) {
+            expr.receiverType = typeIdent->name;
+            return checkVectorMember(expr, vectorType, true);
+        }
+    }
+
     auto objType = checkExpr(*expr.object);
     if (!objType || objType->kind() == TypeKind::Unknown) return unknownType();
 
+    if (objType->kind() == TypeKind::Vector) {
+        expr.receiverType = objType->toString();
+        return checkVectorMember(expr, objType, false);
+    }
+
+    // Caught exceptions expose their formatted stack trace
+    if (expr.member == "stackTrace") {
+        auto* ident = dynamic_cast<IdentifierExpr*>(expr.object.get());
+        if (ident && std::find(catchVars_.begin(), catchVars_.end(), ident->name) != catchVars_.end()) {
+            return stringType();
+        }
+    }
+
     // Enum variant access: EnumName.CaseName or EnumName.CaseName(val)
     if (objType->kind() == TypeKind::Enum) {
         auto* enumType = static_cast<EnumType*>(objType.get());
@@ -1024,6 +1484,20 @@ TypePtr TypeChecker::checkMemberExpr(MemberExpr& expr) {
         if (expr.member == "pop") return makeFunctionType({}, elemType);
         if (expr.member == "reverse") return makeFunctionType({}, objType);
         if (expr.member == "join") return makeFunctionType({stringType()}, stringType());
+        // The callbacks take and return a single machine word
+        auto* elemClass = dynamic_cast<ClassType*>(elemType.get());
+        bool structElems = elemClass && elemClass->isStruct;
+        if (structElems && (expr.member == "map" || expr.member == "filter" ||
+                            expr.member == "forEach")) {
+            diagnostics_.error("E3051",
+                "Array." + expr.member + " is not supported on arrays of structs; use a for loop",
+                expr.location);
+            return unknownType();
+        }
+        if (expr.member == "map" || expr.member == "filter" || expr.member == "forEach" ||
+            expr.member == "reduce") {
+            arrayCallbackCallee_ = &expr;
+        }
         if (expr.member == "map") {
             auto callbackType = makeFunctionType({elemType}, elemType);
             return makeFunctionType({callbackType}, objType);
@@ -1036,6 +1510,10 @@ TypePtr TypeChecker::checkMemberExpr(MemberExpr& expr) {
             auto callbackType = makeFunctionType({elemType}, voidType());
             return makeFunctionType({callbackType}, voidType());
         }
+        if (expr.member == "reduce") {
+            auto callbackType = makeFunctionType({elemType, elemType}, elemType);
+            return makeFunctionType({elemType, callbackType}, elemType);
+        }
     }
 
     // TypeInfo properties (reflection)
@@ -1125,8 +1603,27 @@ TypePtr TypeChecker::checkMemberExpr(MemberExpr& expr) {
         if (expr.member == "keys") return makeFunctionType({}, makeArrayType(mapType->keyType));
     }
 
+    // A type parameter exposes the methods of its interface bound
+    if (auto* param = dynamic_cast<TypeParameterType*>(objType.get())) {
+        auto bit = interfaceTypes_.find(param->bound);
+        if (bit != interfaceTypes_.end()) objType = bit->second;
+    }
+
+    // Interface receivers only expose the interface's methods
+    if (auto* ifaceType = dynamic_cast<InterfaceType*>(objType.get())) {
+        expr.receiverType = ifaceType->name;
+        for (auto& method : ifaceType->methods) {
+            if (method.name == expr.member) return method.type;
+        }
+        diagnostics_.error("E3018",
+            "Interface '" + ifaceType->name + "' has no member '" + expr.member + "'",
+            expr.location);
+        return unknownType();
+    }
+
     if (objType->kind() == TypeKind::Class) {
         auto* classType = static_cast<ClassType*>(objType.get());
+        expr.receiverType = classType->name;
 
         // Check field access
         for (auto& field : classType->fields) {
@@ -1204,7 +1701,73 @@ TypePtr TypeChecker::checkMemberExpr(MemberExpr& expr) {
     return unknownType();
 }
 
+// Members of the SIMD types. Array loads and stores are bounds-checked for
+// every lane they touch and convert from the array's element type, which
+// checkCallExpr matches to the lanes; gathers take one index per lane, as
+// wide as the data lanes.
+TypePtr TypeChecker::checkVectorMember(MemberExpr& expr, const TypePtr& type, bool isStatic) {
+    auto& vec = static_cast<VectorType&>(*type);
+    auto lane = vec.laneType;
+    auto mask = makeVectorType(boolType(), vec.lanes);
+    auto array = makeArrayType(unknownType());
+    const std::string& member = expr.member;
+    auto laneKind = lane->kind();
+
+    if (isStatic) {
+        if (member == "splat") return makeFunctionType({lane}, type);
+        if (!vec.isMask()) {
+            if (member == "load") return makeFunctionType({ptrType()}, type);
+            if (member == "loadArray") return makeFunctionType({array, intType()}, type);
+            if (member == "select") return makeFunctionType({mask, type, type}, type);
+            if (member == "gather" && laneKind != TypeKind::Int8) {
+                bool wide = laneKind == TypeKind::Int || laneKind == TypeKind::Float;
+                auto indexes = makeVectorType(wide ? intType() : int32Type(), vec.lanes);
+                return makeFunctionType({array, indexes}, type);
+            }
+        }
+    } else {
+        if (member == "get") return makeFunctionType({intType()}, lane);
+        if (member == "with") return makeFunctionType({intType(), lane}, type);
+        if (vec.isMask()) {
+            if (member == "any" || member == "all") return makeFunctionType({}, boolType());
+        } else {
+            if (member == "sum" || member == "min" || member == "max") {
+                return makeFunctionType({}, lane);
+            }
+            if (member == "abs") return makeFunctionType({}, type);
+            if (member == "store") return makeFunctionType({ptrType()}, voidType());
+            if (member == "storeArray") return makeFunctionType({array, intType()}, voidType());
+            if (member == "shuffle") {
+                return makeFunctionType(std::vector<TypePtr>(vec.lanes, intType()), type);
+            }
+            if (vec.isFloat()) {
+                if (member == "fma") return makeFunctionType({type, type}, type);
+                if (member == "sqrt") return makeFunctionType({}, type);
+                if (member == "toInt") {
+                    auto intLane = laneKind == TypeKind::Float ? intType() : int32Type();
+                    return makeFunctionType({}, makeVectorType(intLane, vec.lanes));
+                }
+            } else if (member == "toFloat" && laneKind != TypeKind::Int8) {
+                auto floatLane = laneKind == TypeKind::Int ? floatType() : float32Type();
+                return makeFunctionType({}, makeVectorType(floatLane, vec.lanes));
+            }
+        }
+    }
+    diagnostics_.error("E3018",
+        "Type '" + type->toString() + "' has no member '" + member + "'",
+        expr.location);
+    return unknownType();
+}
+
 TypePtr TypeChecker::checkAssignExpr(AssignExpr& expr) {
+    auto* targetIdent = dynamic_cast<IdentifierExpr*>(expr.target.get());
+    if (targetIdent && dynamic_cast<ArrayLiteralExpr*>(expr.value.get())) {
+        Symbol* sym = symbols_.lookup(targetIdent->name);
+        if (sym) expectedElementType_ = expectedElementsOf(sym->type);
+    } else if (targetIdent && isMapConstructor(*expr.value)) {
+        Symbol* sym = symbols_.lookup(targetIdent->name);
+        if (sym) expectedMapType_ = expectedMapOf(sym->type);
+    }
     auto valueType = checkExpr(*expr.value);
 
     if (auto* ident = dynamic_cast<IdentifierExpr*>(expr.target.get())) {
@@ -1219,6 +1782,10 @@ TypePtr TypeChecker::checkAssignExpr(AssignExpr& expr) {
             diagnostics_.error("E3015",
                 "Cannot assign to immutable variable '" + ident->name + "' (declared with 'let')",
                 expr.location);
+        } else if (noteCapture(ident->name)) {
+            diagnostics_.error("E3054",
+                "Cannot assign to '" + ident->name + "' inside a closure; captured variables are copied",
+                expr.location);
         }
         if (valueType && !isAssignable(sym->type, valueType)) {
             diagnostics_.error("E3003",
@@ -1259,6 +1826,7 @@ TypePtr TypeChecker::checkThisExpr(ThisExpr& expr) {
             expr.location);
         return unknownType();
     }
+    noteCapture("this");
     return currentClass_;
 }
 
@@ -1320,9 +1888,10 @@ TypePtr TypeChecker::resolveTypeAnnotation(TypeExpr& typeExpr) {
         }
 
         // Check if it's a type parameter in scope (e.g. T inside class Box<T>)
-        for (auto& tp : currentTypeParams_) {
-            if (tp == named->name) {
-                auto result = makeTypeParameter(named->name);
+        for (size_t i = 0; i < currentTypeParams_.size(); i++) {
+            if (currentTypeParams_[i] == named->name) {
+                auto result = makeTypeParameter(named->name,
+                    i < currentTypeBounds_.size() ? currentTypeBounds_[i] : "");
                 if (named->nullable) return makeNullable(result);
                 return result;
             }
@@ -1355,6 +1924,12 @@ TypePtr TypeChecker::resolveTypeAnnotation(TypeExpr& typeExpr) {
         if (named->name == "Map" && named->typeArgs.size() >= 2) {
             auto keyType = resolveTypeAnnotation(*named->typeArgs[0]);
             auto valType = resolveTypeAnnotation(*named->typeArgs[1]);
+            if (valType && valType->kind() != TypeKind::Unknown && !isUntracedValue(valType)) {
+                diagnostics_.error("E3056",
+                    "Map values must be numbers, Bool, Char or structs of those, not '" +
+                    valType->toString() + "'",
+                    named->typeArgs[1]->location);
+            }
             return makeMapType(keyType, valType);
         }
 
@@ -1366,6 +1941,8 @@ TypePtr TypeChecker::resolveTypeAnnotation(TypeExpr& typeExpr) {
                 type = it->second;
             } else if (auto eit = enumTypes_.find(named->name); eit != enumTypes_.end()) {
                 type = eit->second;
+            } else if (auto iit = interfaceTypes_.find(named->name); iit != interfaceTypes_.end()) {
+                type = iit->second;
             } else {
                 diagnostics_.error("E3016",
                     "Unknown type '" + named->name + "'",
@@ -1398,6 +1975,12 @@ TypePtr TypeChecker::resolveTypeAnnotation(TypeExpr& typeExpr) {
         }
 
         if (named->nullable) {
+            auto* structType = dynamic_cast<ClassType*>(type.get());
+            if (structType && structType->isStruct) {
+                diagnostics_.error("E3051",
+                    "Struct type '" + named->name + "' cannot be nullable",
+                    typeExpr.location);
+            }
             return makeNullable(type);
         }
         return type;
@@ -1547,9 +2130,13 @@ TypePtr TypeChecker::checkMatchExpr(MatchExpr& expr) {
 
 TypePtr TypeChecker::checkLambdaExpr(LambdaExpr& expr) {
     auto funcType = std::make_shared<FunctionType>();
+    bool inlined = inlineLambdaArg_;
+    inlineLambdaArg_ = false;
 
     // Push scope for lambda parameters
     symbols_.pushScope();
+    expr.captures.clear();
+    lambdaStack_.push_back({&expr, symbols_.currentScope().get(), inlined});
 
     for (size_t i = 0; i < expr.params.size(); i++) {
         auto& param = expr.params[i];
@@ -1571,7 +2158,12 @@ TypePtr TypeChecker::checkLambdaExpr(LambdaExpr& expr) {
     } else if (expr.bodyBlock) {
         auto savedReturn = currentReturnType_;
         currentReturnType_ = unknownType();
+        Block* prevBody = currentFuncBody_;
+        currentFuncBody_ = expr.bodyBlock.get();
+        size_t firstClosure = localClosures_.size();
         checkBlock(*expr.bodyBlock);
+        resolveLocalClosures(*expr.bodyBlock, firstClosure);
+        currentFuncBody_ = prevBody;
         funcType->returnType = currentReturnType_;
         currentReturnType_ = savedReturn;
         if (!funcType->returnType || funcType->returnType->kind() == TypeKind::Unknown) {
@@ -1581,7 +2173,9 @@ TypePtr TypeChecker::checkLambdaExpr(LambdaExpr& expr) {
         funcType->returnType = voidType();
     }
 
+    lambdaStack_.pop_back();
     symbols_.popScope();
+    expr.functionType = funcType;
     return funcType;
 }
 
@@ -1619,19 +2213,33 @@ TypePtr TypeChecker::checkAwaitExpr(AwaitExpr& expr) {
 }
 
 TypePtr TypeChecker::checkArrayLiteralExpr(ArrayLiteralExpr& expr) {
+    // A literal initialising a typed array takes its element type, so
+    // Int and Float literals are narrowed to the declared width
+    TypePtr expected = expectedElementType_;
+    expectedElementType_ = nullptr;
     if (expr.elements.empty()) {
-        return makeArrayType(unknownType());
+        expr.elementType = expected;
+        return makeArrayType(expected ? expected : unknownType());
     }
-    TypePtr elemType = checkExpr(*expr.elements[0]);
-    for (size_t i = 1; i < expr.elements.size(); i++) {
+    TypePtr elemType = expected;
+    for (size_t i = 0; i < expr.elements.size(); i++) {
+        if (expected && dynamic_cast<ArrayLiteralExpr*>(expr.elements[i].get())) {
+            expectedElementType_ = expectedElementsOf(expected);
+        }
         auto t = checkExpr(*expr.elements[i]);
-        if (elemType && t && !elemType->equals(*t) && elemType->kind() != TypeKind::Unknown) {
+        if (!elemType) {
+            elemType = t;
+            continue;
+        }
+        bool matches = expected ? isAssignable(expected, t) : elemType->equals(*t);
+        if (t && !matches && elemType->kind() != TypeKind::Unknown) {
             diagnostics_.error("E3025",
                 "Array element type mismatch: expected '" + elemType->toString() +
                 "', got '" + t->toString() + "'",
                 expr.elements[i]->location);
         }
     }
+    expr.elementType = elemType;
     return makeArrayType(elemType);
 }
 
@@ -1681,7 +2289,9 @@ void TypeChecker::checkTryCatchStmt(TryCatchStmt& stmt) {
         symbols_.pushScope();
         // Define the caught exception variable as String (message) for now
         symbols_.define(clause.varName, stringType(), false, stmt.location);
+        catchVars_.push_back(clause.varName);
         checkBlock(*clause.body);
+        catchVars_.pop_back();
         symbols_.popScope();
     }
 
@@ -1764,4 +2374,412 @@ std::shared_ptr<ClassType> TypeChecker::instantiateGenericClass(
     return instance;
 }
 
+// Bind type parameters appearing in `param` from the matching parts of `arg`.
+// The first binding wins; conflicting arguments fail the assignability check.
+static void inferTypeArgs(const TypePtr& param, const TypePtr& arg,
+                          const std::vector<std::string>& typeParams,
+                          std::vector<TypePtr>& typeArgs) {
+    if (!param || !arg || arg->kind() == TypeKind::Unknown || arg->kind() == TypeKind::Nil) return;
+    switch (param->kind()) {
+        case TypeKind::TypeParameter: {
+            auto& name = static_cast<const TypeParameterType&>(*param).name;
+            for (size_t i = 0; i < typeParams.size(); i++) {
+                if (typeParams[i] == name && !typeArgs[i]) typeArgs[i] = arg;
+            }
+            break;
+        }
+        case TypeKind::Nullable: {
+            auto& inner = static_cast<const NullableType&>(*param).inner;
+            if (arg->kind() == TypeKind::Nullable) {
+                inferTypeArgs(inner, static_cast<const NullableType&>(*arg).inner, typeParams, typeArgs);
+            } else {
+                inferTypeArgs(inner, arg, typeParams, typeArgs);
+            }
+            break;
+        }
+        case TypeKind::Array:
+            if (arg->kind() == TypeKind::Array) {
+                inferTypeArgs(static_cast<const ArrayType&>(*param).elementType,
+                              static_cast<const ArrayType&>(*arg).elementType, typeParams, typeArgs);
+            }
+            break;
+        case TypeKind::Set:
+            if (arg->kind() == TypeKind::Set) {
+                inferTypeArgs(static_cast<const SetType&>(*param).elementType,
+                              static_cast<const SetType&>(*arg).elementType, typeParams, typeArgs);
+            }
+            break;
+        case TypeKind::Map:
+            if (arg->kind() == TypeKind::Map) {
+                auto& p = static_cast<const MapType&>(*param);
+                auto& a = static_cast<const MapType&>(*arg);
+                inferTypeArgs(p.keyType, a.keyType, typeParams, typeArgs);
+                inferTypeArgs(p.valueType, a.valueType, typeParams, typeArgs);
+            }
+            break;
+        case TypeKind::Function:
+            if (arg->kind() == TypeKind::Function) {
+                auto& p = static_cast<const FunctionType&>(*param);
+                auto& a = static_cast<const FunctionType&>(*arg);
+                if (p.paramTypes.size() != a.paramTypes.size()) break;
+                for (size_t i = 0; i < p.paramTypes.size(); i++) {
+                    inferTypeArgs(p.paramTypes[i], a.paramTypes[i], typeParams, typeArgs);
+                }
+                inferTypeArgs(p.returnType, a.returnType, typeParams, typeArgs);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static bool containsTypeParameter(const TypePtr& type) {
+    if (!type) return false;
+    switch (type->kind()) {
+        case TypeKind::TypeParameter: return true;
+        case TypeKind::Nullable: return containsTypeParameter(static_cast<const NullableType&>(*type).inner);
+        case TypeKind::Array: return containsTypeParameter(static_cast<const ArrayType&>(*type).elementType);
+        case TypeKind::Set: return containsTypeParameter(static_cast<const SetType&>(*type).elementType);
+        case TypeKind::Map: {
+            auto& map = static_cast<const MapType&>(*type);
+            return containsTypeParameter(map.keyType) || containsTypeParameter(map.valueType);
+        }
+        case TypeKind::Function: {
+            auto& func = static_cast<const FunctionType&>(*type);
+            for (auto& p : func.paramTypes) {
+                if (containsTypeParameter(p)) return true;
+            }
+            return containsTypeParameter(func.returnType);
+        }
+        default:
+            return false;
+    }
+}
+
+bool TypeChecker::satisfiesBound(const TypePtr& type, const std::string& bound) {
+    if (bound.empty() || type->kind() == TypeKind::TypeParameter) return true;
+    if (bound == "Numeric") return type->isNumeric();
+    if (bound == "Comparable") return type->isNumeric() || type->kind() == TypeKind::Char;
+    auto it = interfaceTypes_.find(bound);
+    return it != interfaceTypes_.end() && isAssignable(it->second, type);
+}
+
+TypePtr TypeChecker::checkGenericCall(CallExpr& expr, FuncDecl& decl) {
+    auto calleeType = checkExpr(*expr.callee);
+    auto* funcType = dynamic_cast<FunctionType*>(calleeType.get());
+    if (!funcType) {
+        for (auto& arg : expr.arguments) checkExpr(*arg);
+        return unknownType();
+    }
+
+    if (expr.arguments.size() != funcType->paramTypes.size()) {
+        diagnostics_.error("E3013",
+            "Expected " + std::to_string(funcType->paramTypes.size()) +
+            " argument(s), got " + std::to_string(expr.arguments.size()),
+            expr.location);
+    }
+
+    // Infer type arguments from the other arguments first, so lambda
+    // arguments see concrete parameter types
+    size_t count = std::min(expr.arguments.size(), funcType->paramTypes.size());
+    std::vector<TypePtr> argTypes(count);
+    std::vector<TypePtr> typeArgs(decl.typeParams.size());
+    for (int lambdas = 0; lambdas < 2; lambdas++) {
+        for (size_t i = 0; i < count; i++) {
+            bool isLambda = dynamic_cast<LambdaExpr*>(expr.arguments[i].get()) != nullptr;
+            if (isLambda != (lambdas == 1)) continue;
+            TypePtr expected = funcType->paramTypes[i];
+            if (isLambda) {
+                std::vector<std::string> known;
+                std::vector<TypePtr> knownArgs;
+                for (size_t j = 0; j < typeArgs.size(); j++) {
+                    if (typeArgs[j]) {
+                        known.push_back(decl.typeParams[j]);
+                        knownArgs.push_back(typeArgs[j]);
+                    }
+                }
+                expected = substituteTypeParams(expected, known, knownArgs);
+                if (expected->kind() == TypeKind::Function) {
+                    expectedLambdaParamTypes_ = &static_cast<FunctionType&>(*expected).paramTypes;
+                }
+            }
+            if (argumentStaysLocal(decl.name, i)) {
+                localCallbackArgs_.insert(expr.arguments[i].get());
+                if (isLambda) static_cast<LambdaExpr*>(expr.arguments[i].get())->escapes = false;
+            }
+            argTypes[i] = checkExpr(*expr.arguments[i]);
+            expectedLambdaParamTypes_ = nullptr;
+            inferTypeArgs(funcType->paramTypes[i], argTypes[i], decl.typeParams, typeArgs);
+        }
+    }
+    for (size_t i = count; i < expr.arguments.size(); i++) {
+        checkExpr(*expr.arguments[i]);
+    }
+
+    for (size_t j = 0; j < typeArgs.size(); j++) {
+        if (!typeArgs[j]) {
+            diagnostics_.error("E3052",
+                "Cannot infer type parameter '" + decl.typeParams[j] + "' of '" + decl.name + "'",
+                expr.location);
+            return unknownType();
+        }
+        auto& bound = decl.typeParamBounds[j];
+        if (!satisfiesBound(typeArgs[j], bound)) {
+            diagnostics_.error("E3053",
+                "Type '" + typeArgs[j]->toString() + "' does not satisfy bound '" + bound +
+                "' of type parameter '" + decl.typeParams[j] + "'",
+                expr.location);
+            return unknownType();
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        auto paramType = substituteTypeParams(funcType->paramTypes[i], decl.typeParams, typeArgs);
+        if (argTypes[i] && !isAssignable(paramType, argTypes[i])) {
+            diagnostics_.error("E3014",
+                "Argument " + std::to_string(i + 1) + ": expected '" +
+                paramType->toString() + "', got '" + argTypes[i]->toString() + "'",
+                expr.arguments[i]->location);
+        }
+    }
+
+    // Calls that depend on the enclosing generic function's type parameters
+    // are instantiated along with it
+    expr.typeArgs = typeArgs;
+    bool dependent = std::any_of(typeArgs.begin(), typeArgs.end(), containsTypeParameter);
+    if (!dependent) {
+        genericCallRequests_.push_back({decl.name, typeArgs});
+    } else if (!currentGenericFunc_.empty()) {
+        genericCallsIn_[currentGenericFunc_].push_back({decl.name, typeArgs});
+    }
+    return substituteTypeParams(funcType->returnType, decl.typeParams, typeArgs);
+}
+
+void TypeChecker::instantiateGenericFunctions() {
+    // Polymorphic recursion (f<T> calling f<[T]>) would never terminate
+    const size_t maxInstantiations = 1000;
+    std::unordered_set<std::string> instantiated;
+    for (size_t i = 0; i < genericCallRequests_.size(); i++) {
+        auto [name, typeArgs] = genericCallRequests_[i];
+        auto mangled = mangledGenericName(name, typeArgs);
+        if (!instantiated.insert(mangled).second) continue;
+        auto& decl = *genericFuncDecls_[name];
+        if (instantiated.size() > maxInstantiations) {
+            diagnostics_.error("E3052",
+                "Too many instantiations of generic function '" + name + "'",
+                decl.location);
+            return;
+        }
+        genericInstantiations_.push_back({name, mangled, decl.typeParams, typeArgs, true});
+        for (auto& [callee, calleeArgs] : genericCallsIn_[name]) {
+            std::vector<TypePtr> concrete;
+            for (auto& arg : calleeArgs) {
+                concrete.push_back(substituteTypeParams(arg, decl.typeParams, typeArgs));
+            }
+            genericCallRequests_.push_back({callee, concrete});
+        }
+    }
+}
+
+// --- Closures ---
+//
+// Lambdas capture the enclosing locals they read by value when they are
+// created. A closure whose creating frame outlives every call to it keeps
+// its environment on the stack; the rest get a GC-allocated one. That holds
+// when the closure is only ever called directly, or handed to a callee that
+// only calls it before returning. The scan below is syntactic and gives up
+// on anything it does not recognise.
+
+namespace {
+
+class CallOnlyScan {
+public:
+    CallOnlyScan(const std::string& name, const VarDecl* decl,
+                 const std::unordered_set<const Expr*>* localArgs)
+        : name_(name), decl_(decl), localArgs_(localArgs) {}
+
+    bool block(const Block& block) {
+        for (auto& s : block.statements) {
+            if (!stmt(*s)) return false;
+        }
+        return true;
+    }
+
+    bool stmt(const Stmt& s) {
+        if (auto* b = dynamic_cast<const Block*>(&s)) return block(*b);
+        if (auto* e = dynamic_cast<const ExprStmt*>(&s)) return expr(e->expression.get());
+        if (auto* v = dynamic_cast<const VarDecl*>(&s)) {
+            return (v == decl_ || v->name != name_) && expr(v->initializer.get());
+        }
+        if (auto* r = dynamic_cast<const ReturnStmt*>(&s)) return expr(r->value.get());
+        if (auto* i = dynamic_cast<const IfStmt*>(&s)) {
+            return expr(i->condition.get()) && block(*i->thenBlock) &&
+                   (!i->elseBlock || stmt(*i->elseBlock));
+        }
+        if (auto* w = dynamic_cast<const WhileStmt*>(&s)) {
+            return expr(w->condition.get()) && block(*w->body);
+        }
+        if (auto* f = dynamic_cast<const ForStmt*>(&s)) {
+            return f->variable != name_ && expr(f->iterable.get()) && block(*f->body);
+        }
+        if (dynamic_cast<const BreakStmt*>(&s) || dynamic_cast<const ContinueStmt*>(&s)) return true;
+        if (auto* t = dynamic_cast<const ThrowStmt*>(&s)) return expr(t->expression.get());
+        if (auto* t = dynamic_cast<const TryCatchStmt*>(&s)) {
+            if (!block(*t->tryBlock)) return false;
+            for (auto& clause : t->catchClauses) {
+                if (clause.varName == name_ || !block(*clause.body)) return false;
+            }
+            return !t->finallyBlock || block(*t->finallyBlock);
+        }
+        if (auto* u = dynamic_cast<const UnsafeBlock*>(&s)) return block(*u->body);
+        return false;
+    }
+
+    bool expr(const Expr* e) {
+        if (!e) return true;
+        if (dynamic_cast<const IntLiteralExpr*>(e) || dynamic_cast<const FloatLiteralExpr*>(e) ||
+            dynamic_cast<const StringLiteralExpr*>(e) || dynamic_cast<const CharLiteralExpr*>(e) ||
+            dynamic_cast<const BoolLiteralExpr*>(e) || dynamic_cast<const NilLiteralExpr*>(e) ||
+            dynamic_cast<const ThisExpr*>(e)) {
+            return true;
+        }
+        // Any other use passes the closure on
+        if (auto* id = dynamic_cast<const IdentifierExpr*>(e)) {
+            return id->name != name_ || (lambdaDepth_ == 0 && localArgs_ && localArgs_->count(id));
+        }
+        if (auto* x = dynamic_cast<const CallExpr*>(e)) {
+            auto* callee = dynamic_cast<const IdentifierExpr*>(x->callee.get());
+            if (callee && callee->name == name_) {
+                // Calling it from another closure would capture it
+                if (lambdaDepth_ > 0) return false;
+            } else if (!expr(x->callee.get())) {
+                return false;
+            }
+            for (auto& arg : x->arguments) {
+                if (!expr(arg.get())) return false;
+            }
+            return true;
+        }
+        if (auto* x = dynamic_cast<const LambdaExpr*>(e)) {
+            for (auto& param : x->params) {
+                if (param.name == name_) return false;
+            }
+            // Callbacks that only run during their call may call it freely
+            int depth = localArgs_ && localArgs_->count(x) ? 0 : 1;
+            lambdaDepth_ += depth;
+            bool ok = x->bodyExpr ? expr(x->bodyExpr.get()) : !x->bodyBlock || block(*x->bodyBlock);
+            lambdaDepth_ -= depth;
+            return ok;
+        }
+        if (auto* x = dynamic_cast<const IfExpr*>(e)) {
+            return expr(x->condition.get()) && expr(x->thenExpr.get()) && expr(x->elseExpr.get());
+        }
+        if (auto* x = dynamic_cast<const BinaryExpr*>(e)) return expr(x->left.get()) && expr(x->right.get());
+        if (auto* x = dynamic_cast<const UnaryExpr*>(e)) return expr(x->operand.get());
+        if (auto* x = dynamic_cast<const MemberExpr*>(e)) return expr(x->object.get());
+        if (auto* x = dynamic_cast<const ConstructExpr*>(e)) {
+            for (auto& [field, value] : x->fieldInits) {
+                if (!expr(value.get())) return false;
+            }
+            return true;
+        }
+        if (auto* x = dynamic_cast<const AssignExpr*>(e)) {
+            auto* id = dynamic_cast<const IdentifierExpr*>(x->target.get());
+            if (id ? id->name == name_ : !expr(x->target.get())) return false;
+            return expr(x->value.get());
+        }
+        if (auto* x = dynamic_cast<const IndexExpr*>(e)) return expr(x->object.get()) && expr(x->index.get());
+        if (auto* x = dynamic_cast<const RangeExpr*>(e)) return expr(x->start.get()) && expr(x->end.get());
+        if (auto* x = dynamic_cast<const NilCoalesceExpr*>(e)) {
+            return expr(x->value.get()) && expr(x->defaultValue.get());
+        }
+        if (auto* x = dynamic_cast<const ForceUnwrapExpr*>(e)) return expr(x->operand.get());
+        if (auto* x = dynamic_cast<const OptionalChainExpr*>(e)) return expr(x->object.get());
+        if (auto* x = dynamic_cast<const StringInterpolationExpr*>(e)) {
+            for (auto& part : x->expressions) {
+                if (!expr(part.get())) return false;
+            }
+            return true;
+        }
+        if (auto* x = dynamic_cast<const ArrayLiteralExpr*>(e)) {
+            for (auto& element : x->elements) {
+                if (!expr(element.get())) return false;
+            }
+            return true;
+        }
+        if (auto* x = dynamic_cast<const AwaitExpr*>(e)) return expr(x->operand.get());
+        if (auto* x = dynamic_cast<const MatchExpr*>(e)) {
+            if (!expr(x->subject.get())) return false;
+            for (auto& arm : x->arms) {
+                if (arm.bindingName == name_ || (arm.body && !stmt(*arm.body))) return false;
+            }
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const std::string& name_;
+    const VarDecl* decl_;                              // the declaration being analysed, if local
+    const std::unordered_set<const Expr*>* localArgs_; // argument positions that only call
+    int lambdaDepth_ = 0;
+};
+
+// Whether `scope` is `inner` or one of its ancestors
+bool encloses(const Scope* scope, const Scope* inner) {
+    for (const Scope* s = inner; s; s = s->parent().get()) {
+        if (s == scope) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+// Record `name` as a capture of every closure between this use and its
+// declaration. Returns true if a closure (not an inlined callback) copies it.
+bool TypeChecker::noteCapture(const std::string& name) {
+    if (lambdaStack_.empty()) return false;
+    // `this` belongs to the enclosing method, outside every lambda
+    Scope* defining = nullptr;
+    if (name != "this") {
+        defining = symbols_.scopeOf(name);
+        if (!defining || !defining->parent()) return false; // globals and functions
+    }
+    bool captured = false;
+    for (auto it = lambdaStack_.rbegin(); it != lambdaStack_.rend(); ++it) {
+        if (defining && encloses(it->scope, defining)) break;
+        if (it->inlined) continue;
+        auto& captures = it->lambda->captures;
+        if (std::find(captures.begin(), captures.end(), name) == captures.end()) {
+            captures.push_back(name);
+        }
+        captured = true;
+    }
+    return captured;
+}
+
+// Whether argument `index` of a call to `callee` is only called while the
+// call runs: parallelForEachFile joins its workers, and a top-level function
+// may call the matching parameter but not store or return it.
+bool TypeChecker::argumentStaysLocal(const std::string& callee, size_t index) {
+    Scope* defining = symbols_.scopeOf(callee);
+    if (defining && defining->parent()) return false; // a local shadows it
+    if (callee == "parallelForEachFile") return index == 2;
+    auto it = funcDecls_.find(callee);
+    if (it == funcDecls_.end() || it->second->isAsync) return false;
+    auto& decl = *it->second;
+    if (index >= decl.parameters.size()) return false;
+    return CallOnlyScan(decl.parameters[index].name, nullptr, nullptr).block(*decl.body);
+}
+
+// Decide where the `var f = lambda` closures declared in `body` live, now
+// that all of its uses have been seen
+void TypeChecker::resolveLocalClosures(Block& body, size_t first) {
+    for (size_t i = first; i < localClosures_.size(); i++) {
+        auto [decl, lambda] = localClosures_[i];
+        lambda->escapes = !CallOnlyScan(decl->name, decl, &localCallbackArgs_).block(body);
+    }
+    localClosures_.resize(first);
+}
+
 } // namespace chris
@@ -4,6 +4,7 @@
 #include "sema/types.h"
 #include "sema/symbol_table.h"
 #include "common/diagnostic.h"
+#include <unordered_set>
 
 namespace chris {
 
@@ -23,6 +24,8 @@ private:
     void checkVarDecl(VarDecl& decl);
     void checkImportDecl(ImportDecl& decl);
     void checkClassDecl(ClassDecl& decl);
+    void checkStructLayout(ClassDecl& decl, const ClassType& structType);
+    bool isValueType(const TypePtr& type) const;
     void checkInterfaceDecl(InterfaceDecl& decl);
     void checkEnumDecl(EnumDecl& decl);
 
@@ -37,6 +40,7 @@ private:
 
     // Expressions — returns the inferred type
     TypePtr checkExpr(Expr& expr);
+    TypePtr checkExprNode(Expr& expr);
     TypePtr checkIntLiteral(IntLiteralExpr& expr);
     TypePtr checkFloatLiteral(FloatLiteralExpr& expr);
     TypePtr checkStringLiteral(StringLiteralExpr& expr);
@@ -47,6 +51,8 @@ private:
     TypePtr checkUnaryExpr(UnaryExpr& expr);
     TypePtr checkCallExpr(CallExpr& expr);
     TypePtr checkMemberExpr(MemberExpr& expr);
+    TypePtr checkVectorMember(MemberExpr& expr, const TypePtr& type, bool isStatic);
+    TypePtr checkVectorOperator(BinaryExpr& expr, const TypePtr& leftType, const TypePtr& rightType);
     TypePtr checkAssignExpr(AssignExpr& expr);
     TypePtr checkRangeExpr(RangeExpr& expr);
     TypePtr checkThisExpr(ThisExpr& expr);
@@ -77,6 +83,14 @@ private:
         const std::string& name,
         const std::vector<TypePtr>& typeArgs);
     std::string mangledGenericName(const std::string& name, const std::vector<TypePtr>& typeArgs);
+    TypePtr checkGenericCall(CallExpr& expr, FuncDecl& decl);
+    bool satisfiesBound(const TypePtr& type, const std::string& bound);
+    void instantiateGenericFunctions();
+
+    // Closures
+    bool noteCapture(const std::string& name);
+    bool argumentStaysLocal(const std::string& callee, size_t index);
+    void resolveLocalClosures(Block& body, size_t first);
 
     DiagnosticEngine& diagnostics_;
     SymbolTable symbols_;
@@ -86,11 +100,32 @@ private:
     std::unordered_map<std::string, std::shared_ptr<InterfaceType>> interfaceTypes_; // registered interfaces
     std::unordered_map<std::string, std::shared_ptr<EnumType>> enumTypes_; // registered enums
     std::unordered_map<std::string, ClassDecl*> genericClassDecls_; // generic class AST nodes for instantiation
+    std::unordered_map<std::string, FuncDecl*> genericFuncDecls_; // generic function AST nodes
     std::vector<std::string> currentTypeParams_; // type params in scope during generic class checking
+    std::vector<std::string> currentTypeBounds_; // bounds of currentTypeParams_ in a generic function
+    std::string currentGenericFunc_; // generic function whose body is being checked
+    using GenericCall = std::pair<std::string, std::vector<TypePtr>>; // function name, type args
+    std::vector<GenericCall> genericCallRequests_; // generic function calls with concrete type args
+    std::unordered_map<std::string, std::vector<GenericCall>> genericCallsIn_; // calls depending on a generic function's own type params
     std::vector<GenericInstantiation> genericInstantiations_; // collected instantiations for codegen
     std::vector<TypePtr>* expectedLambdaParamTypes_ = nullptr; // propagated from call site for lambda inference
+    TypePtr expectedElementType_ = nullptr; // element type of the array an array literal initialises
+    TypePtr expectedMapType_ = nullptr; // map type a Map() call initialises
+    struct LambdaFrame {
+        LambdaExpr* lambda;
+        Scope* scope;  // scope holding the lambda's parameters
+        bool inlined;  // array callback expanded in place, not a closure
+    };
+    std::vector<LambdaFrame> lambdaStack_; // lambdas whose bodies are being checked, innermost last
+    bool inlineLambdaArg_ = false; // next lambda checked is an inlined array callback
+    MemberExpr* arrayCallbackCallee_ = nullptr; // last Array map/filter/forEach/reduce member checked
+    std::unordered_map<std::string, FuncDecl*> funcDecls_; // top-level functions, for escape analysis
+    std::unordered_set<const Expr*> localCallbackArgs_; // arguments only called during the call they are passed to
+    std::vector<std::pair<VarDecl*, LambdaExpr*>> localClosures_; // `var f = lambda` awaiting escape analysis
+    Block* currentFuncBody_ = nullptr; // body of the function or lambda being checked
     bool inAsyncFunction_ = false; // true when checking inside an async function body
     bool inUnsafeBlock_ = false; // true when checking inside an unsafe block
+    std::vector<std::string> catchVars_; // caught exception variables in scope (for e.stackTrace)
     std::unordered_map<std::string, std::string> deprecatedFunctions_; // name -> message
 };
 
@@ -36,6 +36,19 @@ std::string FunctionType::toString() const {
     return oss.str();
 }
 
+std::string VectorType::toString() const {
+    std::string lanesSuffix = std::to_string(lanes);
+    switch (laneType->kind()) {
+        case TypeKind::Float32: return "Float32x" + lanesSuffix;
+        case TypeKind::Float:   return "Float64x" + lanesSuffix;
+        case TypeKind::Int32:   return "Int32x" + lanesSuffix;
+        case TypeKind::Int:     return "Int64x" + lanesSuffix;
+        case TypeKind::Int8:    return "Int8x" + lanesSuffix;
+        case TypeKind::Bool:    return "Mask" + lanesSuffix;
+        default:                return "<vector>";
+    }
+}
+
 bool FunctionType::equals(const Type& other) const {
     if (other.kind() != TypeKind::Function) return false;
     auto& otherFunc = static_cast<const FunctionType&>(other);
@@ -98,9 +111,10 @@ TypePtr makeClassType(const std::string& name) {
     return ct;
 }
 
-TypePtr makeTypeParameter(const std::string& name) {
+TypePtr makeTypeParameter(const std::string& name, const std::string& bound) {
     auto tp = std::make_shared<TypeParameterType>();
     tp->name = name;
+    tp->bound = bound;
     return tp;
 }
 
@@ -128,6 +142,30 @@ TypePtr ptrType(TypePtr pointee) {
     return std::make_shared<PtrType>(std::move(pointee));
 }
 
+TypePtr makeVectorType(TypePtr laneType, unsigned lanes) {
+    return std::make_shared<VectorType>(std::move(laneType), lanes);
+}
+
+// The built-in SIMD types: 128- and 256-bit vectors of each lane type, and
+// masks for every lane count they use
+static TypePtr resolveVectorTypeName(const std::string& name) {
+    struct Shape {
+        TypePtr (*laneType)();
+        unsigned lanes;
+    };
+    static const Shape shapes[] = {
+        {float32Type, 4}, {float32Type, 8}, {floatType, 2}, {floatType, 4},
+        {int32Type, 4},   {int32Type, 8},   {intType, 2},   {intType, 4},
+        {int8Type, 16},   {int8Type, 32},
+        {boolType, 2},    {boolType, 4},    {boolType, 8},  {boolType, 16}, {boolType, 32},
+    };
+    for (auto& shape : shapes) {
+        auto type = makeVectorType(shape.laneType(), shape.lanes);
+        if (type->toString() == name) return type;
+    }
+    return nullptr;
+}
+
 TypePtr substituteTypeParams(
     const TypePtr& type,
     const std::vector<std::string>& paramNames,
@@ -170,9 +208,30 @@ TypePtr substituteTypeParams(
         return type;
     }
 
-    // Recurse into class types (for nested generics)
-    if (type->kind() == TypeKind::Class) {
-        auto& cls = static_cast<const ClassType&>(*type);
+    // Recurse into containers
+    if (type->kind() == TypeKind::Array) {
+        auto& arr = static_cast<const ArrayType&>(*type);
+        auto elem = substituteTypeParams(arr.elementType, paramNames, args);
+        if (elem != arr.elementType) return makeArrayType(elem);
+        return type;
+    }
+    if (type->kind() == TypeKind::Map) {
+        auto& map = static_cast<const MapType&>(*type);
+        auto key = substituteTypeParams(map.keyType, paramNames, args);
+        auto val = substituteTypeParams(map.valueType, paramNames, args);
+        if (key != map.keyType || val != map.valueType) return makeMapType(key, val);
+        return type;
+    }
+    if (type->kind() == TypeKind::Set) {
+        auto& set = static_cast<const SetType&>(*type);
+        auto elem = substituteTypeParams(set.elementType, paramNames, args);
+        if (elem != set.elementType) return makeSetType(elem);
+        return type;
+    }
+
+    // Recurse into class types (for nested generics); interfaces share the kind
+    if (auto* clsPtr = dynamic_cast<const ClassType*>(type.get())) {
+        auto& cls = *clsPtr;
         if (!cls.typeArgs.empty()) {
             std::vector<TypePtr> newArgs;
             bool changed = false;
@@ -238,7 +297,7 @@ TypePtr resolveTypeName(const std::string& name) {
     if (name == "String") return stringType();
     if (name == "Char")   return charType();
     if (name == "Void")   return voidType();
-    return nullptr;
+    return resolveVectorTypeName(name);
 }
 
 bool isAssignable(const TypePtr& target, const TypePtr& value) {
@@ -253,6 +312,12 @@ bool isAssignable(const TypePtr& target, const TypePtr& value) {
     // Same type
     if (target->equals(*value)) return true;
 
+    // An array of unknown elements accepts any array (checked by the caller)
+    if (target->kind() == TypeKind::Array && value->kind() == TypeKind::Array &&
+        static_cast<const ArrayType&>(*target).elementType->kind() == TypeKind::Unknown) {
+        return true;
+    }
+
     // nil is assignable to nullable types and Ptr types
     if (value->kind() == TypeKind::Nil && target->isNullable()) return true;
     if (value->kind() == TypeKind::Nil && target->kind() == TypeKind::Ptr) return true;
@@ -34,6 +34,7 @@ enum class TypeKind {
     Set,
     TypeInfo,
     Ptr,
+    Vector,     // fixed-width SIMD vector (Float32x8, Int32x4, Mask8, ...)
     Unknown
 };
 
@@ -103,6 +104,7 @@ struct ClassMethod {
 struct ClassType : Type {
     std::string name;
     bool isShared = false; // true for shared classes (thread-safe synchronized access)
+    bool isStruct = false; // true for structs (value types stored inline)
     std::shared_ptr<ClassType> parent; // base class (nullptr if none)
     std::vector<std::string> interfaceNames; // implemented interfaces
     std::vector<ClassField> fields;
@@ -210,8 +212,26 @@ struct PtrType : Type {
     }
 };
 
+struct VectorType : Type {
+    TypePtr laneType; // Float32, Float, Int32, Int, Int8, or Bool for masks
+    unsigned lanes;
+    VectorType(TypePtr lane, unsigned n) : laneType(std::move(lane)), lanes(n) {}
+    TypeKind kind() const override { return TypeKind::Vector; }
+    std::string toString() const override;
+    bool equals(const Type& other) const override {
+        if (other.kind() != TypeKind::Vector) return false;
+        auto& otherVector = static_cast<const VectorType&>(other);
+        return lanes == otherVector.lanes && laneType->equals(*otherVector.laneType);
+    }
+    bool isMask() const { return laneType->kind() == TypeKind::Bool; }
+    bool isFloat() const {
+        return laneType->kind() == TypeKind::Float || laneType->kind() == TypeKind::Float32;
+    }
+};
+
 struct TypeParameterType : Type {
     std::string name; // e.g. "T"
+    std::string bound; // interface, Comparable or Numeric ("" if unbounded)
     TypeKind kind() const override { return TypeKind::TypeParameter; }
     std::string toString() const override { return name; }
     bool equals(const Type& other) const override {
@@ -274,13 +294,14 @@ TypePtr unknownType();
 TypePtr makeNullable(TypePtr inner);
 TypePtr makeFunctionType(std::vector<TypePtr> params, TypePtr ret);
 TypePtr makeClassType(const std::string& name);
-TypePtr makeTypeParameter(const std::string& name);
+TypePtr makeTypeParameter(const std::string& name, const std::string& bound = "");
 TypePtr makeArrayType(TypePtr elementType);
 TypePtr makeFutureType(TypePtr innerType);
 TypePtr makeMapType(TypePtr keyType, TypePtr valueType);
 TypePtr makeSetType(TypePtr elementType);
 TypePtr typeInfoType();
 TypePtr ptrType(TypePtr pointee = nullptr);
+TypePtr makeVectorType(TypePtr laneType, unsigned lanes);
 
 // Substitute type parameters with concrete types in a given type
 TypePtr substituteTypeParams(
@@ -299,6 +320,7 @@ struct GenericInstantiation {
     std::string mangledName;
     std::vector<std::string> typeParams;
     std::vector<TypePtr> typeArgs;
+    bool isFunction = false; // generic function rather than class
 };
 
 } // namespace chris
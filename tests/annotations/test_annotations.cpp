@@ -141,6 +141,35 @@ TEST_F(AnnotationParserTest, AnnotationOnPublicSharedClass) {
     EXPECT_EQ(cls->annotations[0].name, "Serializable");
 }
 
+TEST_F(AnnotationParserTest, AnnotationOnMethod) {
+    auto program = parse(
+        "class Counter {\n"
+        "    public var n: Int;\n"
+        "    @Instrument\n"
+        "    public func get() -> Int {\n"
+        "        return this.n;\n"
+        "    }\n"
+        "}\n"
+    );
+    ASSERT_FALSE(diag.hasErrors());
+
+    auto* cls = dynamic_cast<ClassDecl*>(program.declarations[0].get());
+    ASSERT_NE(cls, nullptr);
+    ASSERT_EQ(cls->methods.size(), 1u);
+    ASSERT_EQ(cls->methods[0]->annotations.size(), 1u);
+    EXPECT_EQ(cls->methods[0]->annotations[0].name, "Instrument");
+}
+
+TEST_F(AnnotationParserTest, AnnotationOnFieldIsError) {
+    parse(
+        "class Counter {\n"
+        "    @Instrument\n"
+        "    public var n: Int;\n"
+        "}\n"
+    );
+    EXPECT_TRUE(diag.hasErrors());
+}
+
 TEST_F(AnnotationParserTest, AnnotationOnInterface) {
     auto program = parse(
         "@Deprecated(\"use NewInterface\")\n"
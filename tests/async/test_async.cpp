@@ -281,10 +281,26 @@ TEST_F(AsyncCodeGenTest, AsyncFuncWithParams) {
     EXPECT_NE(ir.find("chris_async_spawn"), std::string::npos);
 }
 
+TEST_F(AsyncCodeGenTest, ArgsAndResultKeepTheirTypes) {
+    auto ir = generateIR(
+        "async func scale(x: Float32, n: Int32) -> Float {\n"
+        "    return x * 2.0;\n"
+        "}\n"
+        "async func main() {\n"
+        "    let result = await scale(1.5, 2);\n"
+        "}\n"
+    );
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("define internal void @__async_scale(ptr %0, ptr %1)"), std::string::npos);
+    EXPECT_NE(ir.find("getelementptr inbounds { float, i32 }"), std::string::npos);
+    EXPECT_NE(ir.find("@__async_scale, ptr %args.mem, i32 0, i64 8)"), std::string::npos);
+    EXPECT_NE(ir.find("load double, ptr %await.slot"), std::string::npos);
+}
+
 TEST_F(AsyncCodeGenTest, RuntimeFunctionsDeclared) {
     auto ir = generateIR("func main() { }");
     ASSERT_FALSE(diag.hasErrors());
     EXPECT_NE(ir.find("declare ptr @chris_async_spawn"), std::string::npos);
-    EXPECT_NE(ir.find("declare i64 @chris_async_await"), std::string::npos);
+    EXPECT_NE(ir.find("declare void @chris_async_await"), std::string::npos);
     EXPECT_NE(ir.find("declare void @chris_async_run_loop"), std::string::npos);
 }
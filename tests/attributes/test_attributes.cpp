@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+
+using namespace chris;
+
+class AttributeTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source, bool emitObject = false) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        if (diag.hasErrors()) return "";
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        if (emitObject) {
+            std::string objectPath = "/tmp/chris_attr_test_" + std::to_string(getpid()) + ".o";
+            EXPECT_TRUE(codegen.emitObjectFile(objectPath));
+            std::remove(objectPath.c_str());
+        }
+        return codegen.getIR();
+    }
+
+    // The attribute group attached to @name's definition
+    static std::string attributesOf(const std::string& ir, const std::string& name) {
+        auto def = ir.find("@" + name + "(");
+        def = ir.rfind("define", def);
+        if (def == std::string::npos) return "";
+        auto lineEnd = ir.find('\n', def);
+        auto hash = ir.rfind(" #", lineEnd);
+        if (hash == std::string::npos || hash < def) return "";
+        auto group = ir.substr(hash + 1, ir.find(' ', hash + 1) - hash - 1);
+        auto attrs = ir.find("attributes " + group + " = {");
+        if (attrs == std::string::npos) return "";
+        return ir.substr(attrs, ir.find('\n', attrs) - attrs);
+    }
+
+    static bool isReadNone(const std::string& attrs) {
+        return attrs.find("memory(none)") != std::string::npos ||
+               attrs.find("readnone") != std::string::npos;
+    }
+};
+
+TEST_F(AttributeTest, InliningAndTemperatureHints) {
+    auto ir = getIR(R"(
+        @Inline
+        func twice(x: Int) -> Int {
+            return x * 2;
+        }
+        @NoInline
+        @Cold
+        func report(x: Int) {
+            print(x);
+        }
+        @Hot
+        func step(x: Int) -> Int {
+            return twice(x) + 1;
+        }
+        func main() {
+            report(step(3));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(attributesOf(ir, "twice").find("alwaysinline"), std::string::npos) << ir;
+    auto report = attributesOf(ir, "report");
+    EXPECT_NE(report.find("noinline"), std::string::npos) << report;
+    EXPECT_NE(report.find("cold"), std::string::npos) << report;
+    EXPECT_NE(attributesOf(ir, "step").find("hot"), std::string::npos) << ir;
+}
+
+TEST_F(AttributeTest, MethodAnnotations) {
+    auto ir = getIR(R"(
+        class Counter {
+            public var count: Int;
+            @Cold
+            public func reset() {
+                this.count = 0;
+            }
+        }
+        func main() {
+            var c = Counter { count: 1 };
+            c.reset();
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(attributesOf(ir, "Counter_reset").find("cold"), std::string::npos) << ir;
+}
+
+TEST_F(AttributeTest, ContradictoryAnnotationsAreAnError) {
+    getIR(R"(
+        @Hot
+        @Cold
+        func f() {
+        }
+        func main() {
+            f();
+        }
+    )");
+    ASSERT_TRUE(diag.hasErrors());
+    bool found = false;
+    for (auto& d : diag.diagnostics()) {
+        if (d.code == "E3041") found = true;
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST_F(AttributeTest, PureFunctionDoesNotAccessMemory) {
+    auto ir = getIR(R"(
+        @Pure
+        func square(x: Int) -> Int {
+            var result = x * x;
+            return result;
+        }
+        @Pure
+        func sumSquares(a: Int, b: Int) -> Int {
+            return square(a) + square(b);
+        }
+        func main() {
+            print(sumSquares(3, 4));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(diag.warningCount(), 0u);
+    EXPECT_TRUE(isReadNone(attributesOf(ir, "square"))) << ir;
+    EXPECT_TRUE(isReadNone(attributesOf(ir, "sumSquares"))) << ir;
+}
+
+TEST_F(AttributeTest, BrokenPurityIsDroppedWithAWarning) {
+    auto ir = getIR(R"(
+        class Box {
+            public var value: Int;
+        }
+        @Pure
+        func fill(b: Box) -> Int {
+            b.value = 1;
+            return 1;
+        }
+        func main() {
+            var b = Box { value: 0 };
+            print(fill(b));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    bool found = false;
+    for (auto& d : diag.diagnostics()) {
+        if (d.code == "W4007") found = true;
+    }
+    EXPECT_TRUE(found);
+    EXPECT_FALSE(isReadNone(attributesOf(ir, "fill"))) << ir;
+}
+
+TEST_F(AttributeTest, NounwindIsInferredForPlainBuilds) {
+    auto ir = getIR(R"(
+        func add(a: Int, b: Int) -> Int {
+            return a + b;
+        }
+        func main() {
+            print(add(1, 2));
+        }
+    )", true);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(attributesOf(ir, "add").find("nounwind"), std::string::npos) << ir;
+}
+
+TEST_F(AttributeTest, AllocatingRuntimeCallsBreakPurity) {
+    auto ir = getIR(R"(
+        @Pure
+        func label(n: Int) -> String {
+            return "n=" + n.toString();
+        }
+        @Pure
+        func width(s: String) -> Int {
+            return s.length;
+        }
+        func main() {
+            print(label(width("abc")));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    bool found = false;
+    for (auto& d : diag.diagnostics()) {
+        if (d.code == "W4007") found = true;
+    }
+    EXPECT_TRUE(found);
+    EXPECT_FALSE(isReadNone(attributesOf(ir, "label"))) << ir;
+    EXPECT_TRUE(isReadNone(attributesOf(ir, "width"))) << ir;
+}
@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "bench/bench_report.h"
+#include "common/diagnostic.h"
+
+using namespace chris;
+
+class BenchTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    bool check(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        return !diag.hasErrors();
+    }
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+
+    bool run(const std::string& source, int& exitCode) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.runJIT(exitCode);
+    }
+
+    bool hasCode(const std::string& code) const {
+        for (auto& d : diag.diagnostics()) {
+            if (d.code == code) return true;
+        }
+        return false;
+    }
+};
+
+TEST_F(BenchTest, BlackBoxReturnsItsArgumentsType) {
+    EXPECT_TRUE(check(R"(
+        func f() -> String {
+            var n: Int = blackBox(41) + 1;
+            var x: Float = blackBox(1.5);
+            return blackBox("s${n}${x}");
+        }
+    )"));
+    EXPECT_FALSE(check(R"(
+        func g() -> Int {
+            return blackBox("not an int");
+        }
+    )"));
+    EXPECT_TRUE(hasCode("E3008"));
+}
+
+TEST_F(BenchTest, BlackBoxIsAVolatileRoundTrip) {
+    auto ir = getIR(R"(
+        func main() {
+            var total = 0;
+            for i in 0..10 {
+                total = total + i;
+            }
+            print(blackBox(total));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("%blackbox = alloca i64"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("store volatile i64"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("%blackbox.value = load volatile i64"), std::string::npos) << ir;
+}
+
+TEST_F(BenchTest, BlackBoxedArraysStillIndex) {
+    int exitCode = -1;
+    testing::internal::CaptureStdout();
+    bool ok = run(R"(
+        func main() -> Int {
+            var xs: [Int32] = [4, 5, 6];
+            var ys = blackBox(xs);
+            print(blackBox(xs)[2]);
+            return ys[1];
+        }
+    )", exitCode);
+    auto output = testing::internal::GetCapturedStdout();
+    ASSERT_TRUE(ok);
+    EXPECT_FALSE(diag.hasErrors());
+    EXPECT_EQ(output, "6\n");
+    EXPECT_EQ(exitCode, 5);
+}
+
+TEST_F(BenchTest, BenchmarkAnnotationIsKnown) {
+    EXPECT_TRUE(check(R"(
+        @Benchmark
+        func sum() {
+            blackBox(1 + 2);
+        }
+    )"));
+    EXPECT_FALSE(hasCode("W3040"));
+}
+
+TEST_F(BenchTest, BatchesGrowUntilTheyAreMeasured) {
+    std::string reportPath = "/tmp/chris_bench_report_" + std::to_string(getpid());
+    std::remove(reportPath.c_str());
+    setenv("CHRIS_BENCH_REPORT", reportPath.c_str(), 1);
+    setenv("CHRIS_BENCH_WARMUP_MS", "1", 1);
+    setenv("CHRIS_BENCH_TIME_MS", "5", 1);
+    int exitCode = -1;
+    testing::internal::CaptureStdout();
+    bool ok = run(R"(
+        extern func chris_bench_begin(name: String) -> Int;
+        extern func chris_bench_batch_start();
+        extern func chris_bench_batch_end(n: Int) -> Int;
+        func work() {
+            blackBox("x" + "y");
+        }
+        func main() -> Int {
+            var batches = 0;
+            var n = chris_bench_begin("bench_work");
+            while n > 0 {
+                chris_bench_batch_start();
+                for i in 0..n {
+                    work();
+                }
+                n = chris_bench_batch_end(n);
+                batches = batches + 1;
+            }
+            return batches;
+        }
+    )", exitCode);
+    auto output = testing::internal::GetCapturedStdout();
+    unsetenv("CHRIS_BENCH_REPORT");
+    unsetenv("CHRIS_BENCH_WARMUP_MS");
+    unsetenv("CHRIS_BENCH_TIME_MS");
+    ASSERT_TRUE(ok);
+    EXPECT_GT(exitCode, 2);
+    EXPECT_NE(output.find("bench_work"), std::string::npos) << output;
+    EXPECT_NE(output.find(" ns/op "), std::string::npos) << output;
+
+    std::ifstream in(reportPath);
+    std::string name;
+    long long iterations = 0, ns = 0, allocs = 0;
+    in >> name >> iterations >> ns >> allocs;
+    std::remove(reportPath.c_str());
+    EXPECT_EQ(name, "bench_work");
+    EXPECT_GT(iterations, 1);
+    EXPECT_GE(ns, 5000000);
+    EXPECT_GE(allocs, iterations); // each concatenation allocates
+}
+
+// ==================== Baseline Tests ====================
+
+static BenchResult benchResult(const std::string& file, const std::string& name, double nsPerOp) {
+    BenchResult result;
+    result.file = file;
+    result.name = name;
+    result.iterations = 1000;
+    result.nsPerOp = nsPerOp;
+    return result;
+}
+
+TEST(BenchBaselineTest, MatchesFilesSpelledDifferently) {
+    auto baseline = parseBenchBaseline(
+        "{\"version\":1,\"benchmarks\":[\n"
+        "{\"file\":\"./bench/bench_sort.chr\",\"name\":\"bench_sort\",\"iterations\":10,"
+        "\"ns_per_op\":120.5000,\"allocs_per_op\":0.0000}\n"
+        "{\"file\":\"bench//bench_map.chr\",\"name\":\"bench_map\",\"iterations\":10,"
+        "\"ns_per_op\":80.0000,\"allocs_per_op\":0.0000}\n"
+        "],\"errors\":[]}\n");
+    std::vector<BenchResult> results = {
+        benchResult("bench/bench_sort.chr", "bench_sort", 100),
+        benchResult("./bench/bench_map.chr", "bench_map", 100),
+        benchResult("bench/bench_sort.chr", "bench_new", 100),
+    };
+    auto missing = applyBenchBaseline(results, baseline);
+    EXPECT_DOUBLE_EQ(results[0].baselineNsPerOp, 120.5);
+    EXPECT_DOUBLE_EQ(results[1].baselineNsPerOp, 80.0);
+    EXPECT_LT(results[2].baselineNsPerOp, 0);
+    ASSERT_EQ(missing.size(), 1u);
+    EXPECT_EQ(missing[0]->name, "bench_new");
+}
+
+TEST(BenchBaselineTest, MaxRegressionIsThePercentSlowdownAllowed) {
+    auto result = benchResult("bench/bench_sort.chr", "bench_sort", 112);
+    EXPECT_FALSE(isBenchRegression(result, 10)); // no baseline
+    result.baselineNsPerOp = 100;
+    EXPECT_NEAR(benchChange(result), 12.0, 1e-9);
+    EXPECT_TRUE(isBenchRegression(result, 10));
+    EXPECT_FALSE(isBenchRegression(result, 12.5));
+    result.nsPerOp = 60;
+    EXPECT_FALSE(isBenchRegression(result, 0));
+}
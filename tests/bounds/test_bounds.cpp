@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+#include "ir_helpers.h"
+
+extern "C" {
+void chris_array_bounds_fail(long long index, long long length);
+}
+
+using namespace chris;
+
+class BoundsCheckTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+
+    static bool hasCheck(const std::string& body) {
+        return body.find("call void @chris_array_bounds_fail") != std::string::npos;
+    }
+};
+
+TEST_F(BoundsCheckTest, CheckIsInlineCompareWithColdFailure) {
+    auto ir = getIR(R"(
+        func at(i: Int) -> Int {
+            var arr = [1, 2, 3];
+            return arr[i];
+        }
+        func main() {
+            print(at(1));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "at");
+    EXPECT_NE(body.find("icmp ult i64"), std::string::npos) << body;
+    EXPECT_NE(body.find("!prof"), std::string::npos) << body;
+    EXPECT_TRUE(hasCheck(body));
+    EXPECT_NE(body.find("unreachable"), std::string::npos);
+    EXPECT_NE(ir.find("declare void @chris_array_bounds_fail(i64, i64) #"), std::string::npos);
+}
+
+TEST_F(BoundsCheckTest, RangeLoopOverLengthDropsChecks) {
+    auto ir = getIR(R"(
+        func sum() -> Int {
+            var arr = [1, 2, 3];
+            var total = 0;
+            for i in 0..arr.length {
+                arr[i] = arr[i] * 2;
+                total = total + arr[i];
+            }
+            return total;
+        }
+        func main() {
+            print(sum());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_FALSE(hasCheck(functionBody(ir, "sum")));
+}
+
+TEST_F(BoundsCheckTest, NestedRangeLoopsDropChecks) {
+    auto ir = getIR(R"(
+        func pairs() -> Int {
+            var arr = [1, 2, 3];
+            var total = 0;
+            for i in 0..arr.length {
+                for j in 1..arr.length {
+                    total = total + arr[i] * arr[j];
+                }
+            }
+            return total;
+        }
+        func main() {
+            print(pairs());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_FALSE(hasCheck(functionBody(ir, "pairs")));
+}
+
+TEST_F(BoundsCheckTest, LoopThatResizesArrayKeepsChecks) {
+    auto ir = getIR(R"(
+        func shrink() -> Int {
+            var arr = [1, 2, 3];
+            var total = 0;
+            for i in 0..arr.length {
+                arr.pop();
+                total = total + arr[i];
+            }
+            return total;
+        }
+        func main() {
+            print(shrink());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_TRUE(hasCheck(functionBody(ir, "shrink")));
+}
+
+TEST_F(BoundsCheckTest, UnprovenIndexesKeepChecks) {
+    auto ir = getIR(R"(
+        func skew(n: Int) -> Int {
+            var arr = [1, 2, 3];
+            var other = [4, 5];
+            var total = 0;
+            for i in 0..arr.length {
+                total = total + arr[i + 1] + other[i];
+            }
+            for j in n..arr.length {
+                total = total + arr[j];
+            }
+            return total;
+        }
+        func main() {
+            print(skew(0));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "skew");
+    size_t checks = 0;
+    for (size_t pos = body.find("call void @chris_array_bounds_fail"); pos != std::string::npos;
+         pos = body.find("call void @chris_array_bounds_fail", pos + 1)) {
+        checks++;
+    }
+    EXPECT_EQ(checks, 3u);
+}
+
+TEST_F(BoundsCheckTest, UncheckedFunctionAndUnsafeBlockDropChecks) {
+    auto ir = getIR(R"(
+        @Unchecked
+        func fast(i: Int) -> Int {
+            var arr = [1, 2, 3];
+            return arr[i];
+        }
+        func scoped(i: Int) -> Int {
+            var arr = [1, 2, 3];
+            var x = 0;
+            unsafe {
+                x = arr[i];
+            }
+            return x + arr[i];
+        }
+        func main() {
+            print(fast(1) + scoped(2));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(diag.warningCount(), 0u);
+    EXPECT_FALSE(hasCheck(functionBody(ir, "fast")));
+    // Only the access after the unsafe block is checked
+    auto scoped = functionBody(ir, "scoped");
+    auto first = scoped.find("call void @chris_array_bounds_fail");
+    ASSERT_NE(first, std::string::npos);
+    EXPECT_EQ(scoped.find("call void @chris_array_bounds_fail", first + 1), std::string::npos);
+}
+
+TEST(BoundsFailTest, ReportsIndexAndLength) {
+    EXPECT_EXIT(chris_array_bounds_fail(5, 3), ::testing::ExitedWithCode(1),
+                "index 5, length 3");
+}
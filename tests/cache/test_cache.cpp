@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "cache/module_cache.h"
+#include "common/diagnostic.h"
+
+using namespace chris;
+
+static const char* kLib = R"(
+var hits = 0;
+func helper(x: Int) -> Int {
+    return x + 1;
+}
+@Inline
+func twice(x: Int) -> Int {
+    return x * 2;
+}
+)";
+
+static const char* kMain = R"(
+import "lib.chr";
+func main() {
+    hits = helper(1);
+    print(twice(hits));
+}
+)";
+
+class ModuleCacheTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+    std::string dir;
+
+    void SetUp() override {
+        dir = "/tmp/chris_cache_test_" + std::to_string(getpid());
+        std::system(("mkdir -p " + dir).c_str());
+    }
+    void TearDown() override { std::system(("rm -rf " + dir).c_str()); }
+
+    std::string write(const std::string& name, const std::string& content) {
+        std::string path = dir + "/" + name;
+        std::ofstream(path) << content;
+        return path;
+    }
+
+    // lib.chr's declarations merged ahead of main.chr's, as the driver does
+    Program load(const std::string& lib, const std::string& main,
+                 std::unique_ptr<TypeChecker>& checker) {
+        Program program;
+        for (auto* file : {"lib.chr", "main.chr"}) {
+            std::string source = std::string(file) == "lib.chr" ? lib : main;
+            Lexer lexer(source, write(file, source), diag);
+            auto tokens = lexer.tokenize();
+            Parser parser(tokens, diag);
+            auto parsed = parser.parse();
+            for (auto& decl : parsed.declarations) program.declarations.push_back(std::move(decl));
+        }
+        checker = std::make_unique<TypeChecker>(diag);
+        checker->check(program);
+        return program;
+    }
+
+    std::vector<ModuleUnit> build(const std::string& lib, const std::string& main) {
+        std::unique_ptr<TypeChecker> checker;
+        auto program = load(lib, main, checker);
+        EXPECT_FALSE(diag.hasErrors());
+        ModuleCache cache(dir + "/.chris-cache");
+        std::vector<ModuleUnit> units;
+        EXPECT_TRUE(cache.plan(program, dir + "/main.chr", {}, "test", units));
+        for (auto& unit : units) {
+            if (unit.cached) continue;
+            std::string built = write("built.o", unit.key);
+            EXPECT_TRUE(cache.commit(unit, built));
+        }
+        return units;
+    }
+
+    std::string unitIR(const std::string& file, bool isEntry) {
+        std::unique_ptr<TypeChecker> checker;
+        auto program = load(kLib, kMain, checker);
+        return unitIR(program, *checker, file, isEntry, diag);
+    }
+
+    std::string unitIR(Program& program, TypeChecker& checker, const std::string& file,
+                       bool isEntry, DiagnosticEngine& diagnostics) {
+        CodeGen codegen("test_module", diagnostics);
+        codegen.setCompilationUnit(dir + "/" + file, isEntry);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+};
+
+TEST_F(ModuleCacheTest, UnchangedFilesAreCached) {
+    auto first = build(kLib, kMain);
+    ASSERT_EQ(first.size(), 2u);
+    EXPECT_FALSE(first[0].cached);
+    EXPECT_FALSE(first[1].cached);
+    auto second = build(kLib, kMain);
+    EXPECT_TRUE(second[0].cached);
+    EXPECT_TRUE(second[1].cached);
+}
+
+TEST_F(ModuleCacheTest, BodyEditsRebuildOnlyTheirFile) {
+    std::string main = kMain;
+    auto first = build(kLib, main);
+    main.replace(main.find("helper(1)"), 9, "helper(2)");
+    auto second = build(kLib, main);
+    ASSERT_EQ(second.size(), 2u);
+    EXPECT_TRUE(second[0].isEntry);
+    EXPECT_FALSE(second[0].cached);
+    EXPECT_TRUE(second[1].cached);
+    // The replaced object is removed
+    EXPECT_EQ(access(first[0].objectPath.c_str(), F_OK), -1);
+    EXPECT_EQ(access(second[0].objectPath.c_str(), F_OK), 0);
+}
+
+TEST_F(ModuleCacheTest, InterfaceChangesRebuildDependents) {
+    build(kLib, kMain);
+    std::string lib = kLib;
+    lib += "func unused() {\n}\n";
+    auto units = build(lib, kMain);
+    EXPECT_FALSE(units[0].cached);
+    EXPECT_FALSE(units[1].cached);
+}
+
+TEST_F(ModuleCacheTest, InterfaceLeavesOutBodies) {
+    std::unique_ptr<TypeChecker> checker;
+    auto program = load(kLib, kMain, checker);
+    auto* helper = program.declarations[1].get();
+    EXPECT_EQ(declarationInterface(*helper), "func helper(x: Int) -> Int\n");
+    EXPECT_FALSE(exposesBody(*helper));
+    EXPECT_TRUE(exposesBody(*program.declarations[0])); // global initializer
+    EXPECT_TRUE(exposesBody(*program.declarations[2])); // @Inline
+}
+
+TEST_F(ModuleCacheTest, UnitsOnlyDefineTheirOwnBodies) {
+    auto lib = unitIR("lib.chr", false);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(lib.find("define i64 @helper("), std::string::npos) << lib;
+    EXPECT_NE(lib.find("declare i32 @main("), std::string::npos) << lib;
+    EXPECT_NE(lib.find("@global.hits = external global i64"), std::string::npos) << lib;
+    EXPECT_NE(lib.find("@llvm.global_ctors"), std::string::npos) << lib;
+
+    auto main = unitIR("main.chr", true);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(main.find("define i32 @main("), std::string::npos) << main;
+    EXPECT_NE(main.find("declare i64 @helper("), std::string::npos) << main;
+    EXPECT_NE(main.find("define available_externally i64 @twice("), std::string::npos) << main;
+    EXPECT_NE(main.find("@global.hits = global i64 0"), std::string::npos) << main;
+}
+
+TEST_F(ModuleCacheTest, UnitsCompileConcurrently) {
+    std::unique_ptr<TypeChecker> checker;
+    auto program = load(kLib, kMain, checker);
+    ASSERT_FALSE(diag.hasErrors());
+    DiagnosticEngine libDiag, mainDiag;
+    std::string lib, main;
+    std::thread libThread([&] { lib = unitIR(program, *checker, "lib.chr", false, libDiag); });
+    std::thread mainThread([&] { main = unitIR(program, *checker, "main.chr", true, mainDiag); });
+    libThread.join();
+    mainThread.join();
+    EXPECT_EQ(lib, unitIR("lib.chr", false));
+    EXPECT_EQ(main, unitIR("main.chr", true));
+}
+
+TEST_F(ModuleCacheTest, CachedUnitsReplayTheirWarnings) {
+    std::string lib = std::string(kLib) + "@Pure\nfunc bump() -> Int {\n    hits = hits + 1;\n"
+                                          "    return hits;\n}\n";
+    std::unique_ptr<TypeChecker> checker;
+    auto program = load(lib, kMain, checker);
+    ASSERT_FALSE(diag.hasErrors());
+    ModuleCache cache(dir + "/.chris-cache");
+    std::vector<ModuleUnit> units;
+    ASSERT_TRUE(cache.plan(program, dir + "/main.chr", {}, "test", units));
+    ASSERT_EQ(units.size(), 2u);
+    ASSERT_FALSE(units[1].isEntry);
+    DiagnosticEngine libDiag;
+    unitIR(program, *checker, "lib.chr", false, libDiag);
+    ASSERT_EQ(libDiag.warningCount(), 1u);
+    EXPECT_TRUE(cache.commit(units[1], write("built.o", units[1].key), libDiag.diagnostics()));
+
+    std::vector<ModuleUnit> again;
+    ASSERT_TRUE(cache.plan(program, dir + "/main.chr", {}, "test", again));
+    ASSERT_TRUE(again[1].cached);
+    ASSERT_EQ(again[1].warnings.size(), 1u);
+    const Diagnostic& original = libDiag.diagnostics()[0];
+    const Diagnostic& replayed = again[1].warnings[0];
+    EXPECT_EQ(replayed.code, "W4007");
+    EXPECT_EQ(replayed.message, original.message);
+    EXPECT_EQ(replayed.location.toString(), original.location.toString());
+}
+
+TEST_F(ModuleCacheTest, CompilerIdFollowsTheRuntimeLibrary) {
+    std::string runtime = write("libchris_runtime.a", "first");
+    std::string id = CodeGen::compilerId(runtime);
+    EXPECT_EQ(CodeGen::compilerId(runtime), id);
+    write("libchris_runtime.a", "second");
+    EXPECT_NE(CodeGen::compilerId(runtime), id);
+}
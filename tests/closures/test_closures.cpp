@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+#include "ir_helpers.h"
+
+using namespace chris;
+
+class ClosureTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+};
+
+TEST_F(ClosureTest, EscapingClosureIsHeapAllocated) {
+    auto ir = getIR(R"(
+        func makeAdder(n: Int) -> (Int) -> Int {
+            return (x: Int) => x + n;
+        }
+        func main() {
+            var add5 = makeAdder(5);
+            print(add5(10));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "makeAdder");
+    // Code pointer and the captured Int; the code slot is skipped when scanned
+    EXPECT_NE(body.find("call ptr @chris_gc_alloc(i64 16, i8 4)"), std::string::npos) << body;
+    EXPECT_NE(ir.find("@__lambda_0(i64 %x, ptr %env)"), std::string::npos);
+    // add5's target is unknown to main: called through the record
+    auto main = functionBody(ir, "main");
+    EXPECT_NE(main.find("%closure.code = load ptr"), std::string::npos) << main;
+}
+
+TEST_F(ClosureTest, LocalClosureLivesOnTheStack) {
+    auto ir = getIR(R"(
+        func main() {
+            var k = 3;
+            var times = (x: Int) => x * k;
+            print(times(7));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "main");
+    EXPECT_EQ(body.find("@chris_gc_alloc"), std::string::npos) << body;
+    EXPECT_NE(body.find("%__lambda_0.frame = alloca"), std::string::npos);
+    // The target is known, so the call is direct
+    EXPECT_NE(body.find("call i64 @__lambda_0(i64 7"), std::string::npos) << body;
+}
+
+TEST_F(ClosureTest, ArgumentThatIsOnlyCalledStaysOnTheStack) {
+    auto ir = getIR(R"(
+        func apply(f: (Int) -> Int, x: Int) -> Int {
+            return f(x);
+        }
+        func main() {
+            var k = 3;
+            print(apply((x: Int) => x + k, 4));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(functionBody(ir, "main").find("@chris_gc_alloc"), std::string::npos);
+}
+
+TEST_F(ClosureTest, CaptureFreeLambdaIsConstant) {
+    auto ir = getIR(R"(
+        func pick() -> (Int) -> Int {
+            return (x: Int) => x * 2;
+        }
+        func main() {
+            print(pick()(4));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("@__lambda_0.closure = private constant"), std::string::npos) << ir;
+    EXPECT_EQ(functionBody(ir, "pick").find("@chris_gc_alloc"), std::string::npos);
+}
+
+TEST_F(ClosureTest, NamedFunctionAsValue) {
+    auto ir = getIR(R"(
+        func square(x: Int) -> Int {
+            return x * x;
+        }
+        func apply(f: (Int) -> Int, x: Int) -> Int {
+            return f(x);
+        }
+        func main() {
+            print(apply(square, 6));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("define internal i64 @square.thunk(i64 %0, ptr %1)"), std::string::npos) << ir;
+    EXPECT_NE(functionBody(ir, "main").find("@square.thunk.closure"), std::string::npos);
+}
+
+TEST_F(ClosureTest, MethodLambdaCapturesThis) {
+    auto ir = getIR(R"(
+        class Counter {
+            public var base: Int;
+            public func scaled(k: Int) -> Int {
+                var f = (x: Int) => x * k + this.base;
+                return f(2);
+            }
+        }
+        func main() {
+            var c = Counter { base: 1 };
+            print(c.scaled(10));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto lambda = functionBody(ir, "__lambda_0");
+    EXPECT_NE(lambda.find("%this.addr = alloca ptr"), std::string::npos) << lambda;
+}
+
+TEST_F(ClosureTest, AssigningCapturedVariableIsAnError) {
+    Lexer lexer(R"(
+        func main() {
+            var count = 0;
+            var bump = () => {
+                count = count + 1;
+            };
+            bump();
+        }
+    )", "test.chr", diag);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens, diag);
+    auto program = parser.parse();
+    TypeChecker checker(diag);
+    checker.check(program);
+    EXPECT_TRUE(diag.hasErrors());
+}
@@ -35,6 +35,18 @@ TEST_F(CodeGenTest, EmptyMain) {
     EXPECT_NE(ir.find("ret i32 0"), std::string::npos);
 }
 
+TEST_F(CodeGenTest, MainStartsTheProfilerBeforeTheGc) {
+    auto ir = generateIR("func helper() { }\nfunc main() { helper(); }");
+    ASSERT_FALSE(diag.hasErrors());
+    auto mainAt = ir.find("define i32 @main()");
+    ASSERT_NE(mainAt, std::string::npos);
+    auto start = ir.find("call void @chris_profile_autostart()", mainAt);
+    ASSERT_NE(start, std::string::npos) << ir;
+    EXPECT_LT(start, ir.find("call void @chris_gc_init()", mainAt));
+    // Only main() starts it, so nothing else linking the runtime is sampled
+    EXPECT_EQ(ir.find("call void @chris_profile_autostart()"), start);
+}
+
 TEST_F(CodeGenTest, IntVariable) {
     auto ir = generateIR("func main() { var x = 42; }");
     ASSERT_FALSE(diag.hasErrors());
@@ -604,8 +616,10 @@ TEST_F(CodeGenTest, TryCatchCodegen) {
         "}\n"
     );
     ASSERT_FALSE(diag.hasErrors());
-    EXPECT_NE(ir.find("chris_try_begin"), std::string::npos);
-    EXPECT_NE(ir.find("setjmp"), std::string::npos);
+    EXPECT_NE(ir.find("invoke void @chris_throw"), std::string::npos);
+    EXPECT_NE(ir.find("landingpad"), std::string::npos);
+    EXPECT_NE(ir.find("personality ptr @chris_personality"), std::string::npos);
+    EXPECT_EQ(ir.find("setjmp"), std::string::npos);
     EXPECT_NE(ir.find("try.body"), std::string::npos);
     EXPECT_NE(ir.find("catch.body"), std::string::npos);
 }
@@ -627,7 +641,7 @@ TEST_F(CodeGenTest, ErrorHandlingDoneCriterion) {
     );
     ASSERT_FALSE(diag.hasErrors()) << "Codegen failed for Phase 11 done criterion";
     EXPECT_NE(ir.find("chris_throw"), std::string::npos);
-    EXPECT_NE(ir.find("setjmp"), std::string::npos);
+    EXPECT_NE(ir.find("invoke void @risky"), std::string::npos);
 }
 
 // --- Phase 12: Access Modifiers ---
@@ -722,7 +736,7 @@ TEST_F(CodeGenTest, ArrayDoneCriterion) {
     );
     ASSERT_FALSE(diag.hasErrors()) << "Codegen failed for Phase 15 done criterion";
     EXPECT_NE(ir.find("chris_array_alloc"), std::string::npos);
-    EXPECT_NE(ir.find("chris_array_bounds_check"), std::string::npos);
+    EXPECT_NE(ir.find("chris_array_bounds_fail"), std::string::npos);
 }
 
 // --- Phase 16: For-in over arrays ---
@@ -767,7 +781,7 @@ TEST_F(CodeGenTest, ArrayIndexAssignDoneCriterion) {
         "}\n"
     );
     ASSERT_FALSE(diag.hasErrors()) << "Codegen failed for Phase 18 done criterion";
-    EXPECT_NE(ir.find("chris_array_bounds_check"), std::string::npos);
+    EXPECT_NE(ir.find("chris_array_bounds_fail"), std::string::npos);
 }
 
 // --- Phase 19: Multi-file Imports ---
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+
+using namespace chris;
+
+class DebugInfoCodegenTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source, DebugInfoLevel level) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test.chr", diag);
+        codegen.setDebugInfoLevel(level);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+};
+
+static const char* kProgram =
+    "func square(x: Int) -> Int {\n"
+    "    var result = x * x;\n"
+    "    return result;\n"
+    "}\n"
+    "func main() {\n"
+    "    var name: String = \"chris\";\n"
+    "    print(square(4));\n"
+    "    print(name);\n"
+    "}\n";
+
+TEST_F(DebugInfoCodegenTest, OnlyLineTablesByDefault) {
+    // Stack traces read the line tables, so they are always there
+    auto ir = getIR(kProgram, DebugInfoLevel::None);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("emissionKind: LineTablesOnly"), std::string::npos);
+    EXPECT_NE(ir.find("!DILocation(line: 7,"), std::string::npos);
+    EXPECT_EQ(ir.find("DILocalVariable"), std::string::npos);
+    EXPECT_EQ(ir.find("frame-pointer"), std::string::npos);
+}
+
+TEST_F(DebugInfoCodegenTest, FullEmitsSubprogramsLinesAndLocals) {
+    auto ir = getIR(kProgram, DebugInfoLevel::Full);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("distinct !DICompileUnit(language: DW_LANG_C"), std::string::npos);
+    EXPECT_NE(ir.find("emissionKind: FullDebug"), std::string::npos);
+    EXPECT_NE(ir.find("!DIFile(filename: \"test.chr\""), std::string::npos);
+    EXPECT_NE(ir.find("!\"Debug Info Version\""), std::string::npos);
+    EXPECT_NE(ir.find("DISubprogram(name: \"square\""), std::string::npos);
+    EXPECT_NE(ir.find("DISubprogram(name: \"main\""), std::string::npos);
+    // The multiply on line 2 and the call on line 7 carry their source lines
+    EXPECT_NE(ir.find("!DILocation(line: 2,"), std::string::npos);
+    EXPECT_NE(ir.find("!DILocation(line: 7,"), std::string::npos);
+    EXPECT_NE(ir.find("!DILocalVariable(name: \"x\", arg: 1"), std::string::npos);
+    EXPECT_NE(ir.find("!DILocalVariable(name: \"result\""), std::string::npos);
+    EXPECT_NE(ir.find("!DILocalVariable(name: \"name\""), std::string::npos);
+    EXPECT_NE(ir.find("!DIBasicType(name: \"Int\", size: 64, encoding: DW_ATE_signed)"),
+              std::string::npos);
+    EXPECT_NE(ir.find("!DIBasicType(name: \"char\", size: 8, encoding: DW_ATE_signed_char)"),
+              std::string::npos);
+    EXPECT_NE(ir.find("\"frame-pointer\"=\"all\""), std::string::npos);
+}
+
+TEST_F(DebugInfoCodegenTest, LineTablesOnlyOmitsVariables) {
+    auto ir = getIR(kProgram, DebugInfoLevel::LineTablesOnly);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("emissionKind: LineTablesOnly"), std::string::npos);
+    EXPECT_NE(ir.find("DISubprogram(name: \"square\""), std::string::npos);
+    EXPECT_NE(ir.find("!DILocation(line: 2,"), std::string::npos);
+    EXPECT_EQ(ir.find("DILocalVariable"), std::string::npos);
+    EXPECT_NE(ir.find("\"frame-pointer\"=\"all\""), std::string::npos);
+}
+
+TEST_F(DebugInfoCodegenTest, MethodsAndLambdasGetSubprograms) {
+    auto ir = getIR(R"(
+        class Counter {
+            public var count: Int;
+            public func bump(by: Int) -> Int {
+                return this.count + by;
+            }
+        }
+        func main() {
+            var c = Counter { count: 1 };
+            var nums = [1, 2, 3];
+            var double = (n: Int) => n * 2;
+            var doubled = nums.map(double);
+            print(c.bump(2));
+            print(doubled.length);
+        }
+    )", DebugInfoLevel::Full);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("DISubprogram(name: \"Counter.bump\", linkageName: \"Counter_bump\""),
+              std::string::npos);
+    EXPECT_NE(ir.find("!DILocalVariable(name: \"this\", arg: 1"), std::string::npos);
+    EXPECT_NE(ir.find("!DILocalVariable(name: \"by\", arg: 2"), std::string::npos);
+    EXPECT_NE(ir.find("DISubprogram(name: \"<lambda>\""), std::string::npos);
+    EXPECT_NE(ir.find("!DICompositeType(tag: DW_TAG_structure_type, name: \"Array\""),
+              std::string::npos);
+}
+
+TEST_F(DebugInfoCodegenTest, TryCatchWithDebugInfoVerifies) {
+    auto ir = getIR(R"(
+        func risky(x: Int) {
+            if x == 0 {
+                throw "zero";
+            }
+        }
+        func main() {
+            try {
+                risky(0);
+            } catch (e: Error) {
+                print(e.stackTrace);
+            }
+        }
+    )", DebugInfoLevel::Full);
+    ASSERT_FALSE(diag.hasErrors());
+    // The invoke produced from the call keeps the call's location
+    auto pos = ir.find("invoke void @risky");
+    ASSERT_NE(pos, std::string::npos);
+    auto lineEnd = ir.find('\n', pos);
+    EXPECT_NE(ir.find("!dbg", pos), std::string::npos);
+    EXPECT_LT(ir.find("!dbg", pos), ir.find('\n', lineEnd + 1));
+}
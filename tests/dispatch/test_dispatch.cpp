@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+#include "ir_helpers.h"
+
+using namespace chris;
+
+class DispatchTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+
+    static bool isIndirect(const std::string& body) {
+        return body.find("%vfn = load ptr") != std::string::npos;
+    }
+};
+
+static const char* kShapes = R"(
+    interface Shape {
+        func area() -> Int;
+    }
+    class Square : Shape {
+        public var s: Int;
+        public func area() -> Int { return this.s * this.s; }
+    }
+    class Rect : Shape {
+        public var w: Int;
+        public var h: Int;
+        public func area() -> Int { return this.w * this.h; }
+    }
+    class Animal {
+        public var legs: Int;
+        public func speak() -> String { return "..."; }
+        public func sleep() -> String { return "zzz"; }
+    }
+    class Dog : Animal {
+        public func speak() -> String { return "woof"; }
+    }
+    func measure(s: Shape) -> Int {
+        return s.area();
+    }
+    func talk(a: Animal) -> String {
+        return a.speak();
+    }
+    func rest(a: Animal) -> String {
+        return a.sleep();
+    }
+    func bark(d: Dog) -> String {
+        return d.speak();
+    }
+    func fresh() -> String {
+        return Animal { legs: 2 }.speak();
+    }
+    func main() {
+        print(measure(Square { s: 2 }) + measure(Rect { w: 1, h: 3 }));
+        print(talk(Dog { legs: 4 }) + rest(Dog { legs: 4 }) + bark(Dog { legs: 4 }) + fresh());
+    }
+)";
+
+TEST_F(DispatchTest, PolymorphicClassesGetConstantVtables) {
+    auto ir = getIR(kShapes);
+    ASSERT_FALSE(diag.hasErrors());
+    // One itable slot for Shape, then the class's own methods
+    EXPECT_NE(ir.find("@vtable.Square = private unnamed_addr constant [2 x ptr] [ptr @itable.Square.Shape, ptr @Square_area]"),
+              std::string::npos) << ir;
+    EXPECT_NE(ir.find("@itable.Square.Shape = private unnamed_addr constant [1 x ptr] [ptr @Square_area]"),
+              std::string::npos);
+    // Dog keeps Animal's slot order; the override replaces speak, sleep is inherited
+    EXPECT_NE(ir.find("@vtable.Dog = private unnamed_addr constant [3 x ptr] [ptr null, ptr @Dog_speak, ptr @Animal_sleep]"),
+              std::string::npos);
+    EXPECT_NE(ir.find("%Dog = type { ptr, i64 }"), std::string::npos);
+}
+
+TEST_F(DispatchTest, ClassesOutsideHierarchiesKeepPlainLayout) {
+    auto ir = getIR(R"(
+        class Point {
+            public var x: Int;
+            public func get() -> Int { return this.x; }
+        }
+        func main() {
+            var p = Point { x: 1 };
+            print(p.get());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(ir.find("@vtable."), std::string::npos);
+    EXPECT_NE(ir.find("%Point = type { i64 }"), std::string::npos);
+}
+
+TEST_F(DispatchTest, InterfaceReceiverCallsThroughItable) {
+    auto ir = getIR(kShapes);
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "measure");
+    EXPECT_NE(body.find("%itable = load ptr"), std::string::npos) << body;
+    EXPECT_TRUE(isIndirect(body));
+}
+
+TEST_F(DispatchTest, OverriddenMethodCallsThroughVtable) {
+    auto ir = getIR(kShapes);
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "talk");
+    EXPECT_TRUE(isIndirect(body)) << body;
+    EXPECT_EQ(body.find("call ptr @Animal_speak"), std::string::npos);
+}
+
+TEST_F(DispatchTest, ProvableTargetsAreDirectCalls) {
+    auto ir = getIR(kShapes);
+    ASSERT_FALSE(diag.hasErrors());
+    // No subclass overrides sleep
+    auto rest = functionBody(ir, "rest");
+    EXPECT_FALSE(isIndirect(rest));
+    EXPECT_NE(rest.find("call ptr @Animal_sleep"), std::string::npos) << rest;
+    // Dog has no subclasses
+    auto bark = functionBody(ir, "bark");
+    EXPECT_FALSE(isIndirect(bark));
+    EXPECT_NE(bark.find("call ptr @Dog_speak"), std::string::npos) << bark;
+    // A freshly constructed receiver has a known class
+    auto fresh = functionBody(ir, "fresh");
+    EXPECT_FALSE(isIndirect(fresh));
+    EXPECT_NE(fresh.find("call ptr @Animal_speak"), std::string::npos) << fresh;
+}
+
+TEST_F(DispatchTest, SingleImplementationInterfaceIsDirect) {
+    auto ir = getIR(R"(
+        interface Named {
+            func name() -> String;
+        }
+        class User : Named {
+            public var id: Int;
+            public func name() -> String { return "user"; }
+        }
+        func greet(n: Named) -> String {
+            return n.name();
+        }
+        func main() {
+            print(greet(User { id: 1 }));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "greet");
+    EXPECT_FALSE(isIndirect(body));
+    EXPECT_NE(body.find("call ptr @User_name"), std::string::npos) << body;
+}
+
+TEST_F(DispatchTest, ConstructionStoresVtablePointer) {
+    auto ir = getIR(kShapes);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(functionBody(ir, "main").find("store ptr @vtable.Square"), std::string::npos);
+}
+
+TEST_F(DispatchTest, InterfaceMembersAreChecked) {
+    Lexer lexer(R"(
+        interface Shape {
+            func area() -> Int;
+        }
+        class Square : Shape {
+            public var s: Int;
+            public func area() -> Int { return this.s; }
+        }
+        func measure(s: Shape) -> Int {
+            return s.s;
+        }
+        func main() {
+            print(measure(Square { s: 2 }));
+        }
+    )", "test.chr", diag);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens, diag);
+    auto program = parser.parse();
+    TypeChecker checker(diag);
+    checker.check(program);
+    // Only the interface's methods are visible through it
+    EXPECT_TRUE(diag.hasErrors());
+}
+
+TEST_F(DispatchTest, PolymorphicObjectsSkipVtableWhenScanned) {
+    auto ir = getIR(R"(
+        class Animal {
+            public var name: String;
+            public func speak() -> String { return "..."; }
+        }
+        class Dog : Animal {
+            public func speak() -> String { return "woof"; }
+        }
+        func main() {
+            var d = Dog { name: "rex" };
+            print(d.speak());
+            print(d.name);
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "main");
+    // GC_POLY_OBJECT; the scan covers the vptr slot and the name field
+    EXPECT_NE(body.find("call ptr @chris_gc_alloc(i64 16, i8 4)"), std::string::npos) << body;
+    EXPECT_NE(body.find("call void @chris_gc_set_num_pointers(ptr %obj, i16 2)"), std::string::npos);
+    // A field called name is the field, not reflection's TypeInfo.name
+    EXPECT_EQ(body.find("@chris_typeinfo_name"), std::string::npos);
+}
@@ -0,0 +1,389 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+#include "ir_helpers.h"
+
+extern "C" {
+#include "gc.h"
+// Mirrors of the runtime's stack-trace records
+typedef struct {
+    const char* message;
+    const char* file;
+    long long line;
+    long long column;
+    int frame_count;
+    void* frames[32];
+} chris_stack_trace;
+typedef struct {
+    void* fn;
+    const char* signature;
+    const char* file;
+    long long line;
+    long long column;
+} chris_trace_entry;
+typedef struct {
+    void* address;
+    long long line;
+    long long column;
+} chris_line_entry;
+void chris_register_trace_table(const chris_trace_entry* table, long long count);
+void chris_add_line_table(const chris_line_entry* rows, long long count);
+const char* chris_format_stack_trace(const chris_stack_trace* trace);
+}
+
+using namespace chris;
+
+static size_t countOccurrences(const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos;
+         pos = haystack.find(needle, pos + needle.size())) {
+        count++;
+    }
+    return count;
+}
+
+// ==================== Type Checker Tests ====================
+
+class ExceptionTypeCheckerTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    void check(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+    }
+};
+
+TEST_F(ExceptionTypeCheckerTest, StackTraceIsStringOnCatchVariable) {
+    check(R"(
+        func main() {
+            try {
+                throw "boom";
+            } catch (e: Error) {
+                var trace: String = e.stackTrace;
+                print(trace);
+            }
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+// ==================== Codegen Tests ====================
+
+class ExceptionCodegenTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        codegen.generate(program);
+        return codegen.getIR();
+    }
+};
+
+TEST_F(ExceptionCodegenTest, TryEntryHasNoSetjmp) {
+    auto ir = getIR(R"(
+        func risky(x: Int) {
+            if x == 0 {
+                throw "zero";
+            }
+        }
+        func main() {
+            try {
+                risky(0);
+            } catch (e: Error) {
+                print(e);
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(ir.find("setjmp"), std::string::npos);
+    EXPECT_EQ(ir.find("chris_try_begin"), std::string::npos);
+    EXPECT_NE(ir.find("%try.roots = call i64 @chris_gc_root_depth()"), std::string::npos);
+    EXPECT_NE(ir.find("invoke void @risky"), std::string::npos);
+    EXPECT_NE(ir.find("landingpad { ptr, i32 }"), std::string::npos);
+    EXPECT_NE(ir.find("catch ptr null"), std::string::npos);
+    EXPECT_NE(ir.find("call void @chris_gc_restore_roots(i64 %try.roots)"), std::string::npos);
+    EXPECT_NE(ir.find("call ptr @chris_begin_catch"), std::string::npos);
+}
+
+TEST_F(ExceptionCodegenTest, FunctionsWithoutTryStayPlain) {
+    auto ir = getIR(R"(
+        func risky(x: Int) {
+            if x == 0 {
+                throw "zero";
+            }
+        }
+        func main() {
+            try {
+                risky(1);
+            } catch (e: Error) {
+                print(e);
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto risky = functionBody(ir, "risky");
+    ASSERT_FALSE(risky.empty());
+    EXPECT_EQ(risky.find("personality"), std::string::npos);
+    EXPECT_EQ(risky.find("invoke"), std::string::npos);
+    EXPECT_NE(risky.find("call void @chris_throw"), std::string::npos);
+
+    auto mainBody = functionBody(ir, "main");
+    EXPECT_NE(mainBody.find("personality ptr @chris_personality"), std::string::npos);
+}
+
+TEST_F(ExceptionCodegenTest, CatchBodyCallsAreNotCoveredByOwnHandler) {
+    auto ir = getIR(R"(
+        func main() {
+            try {
+                throw "first";
+            } catch (e: Error) {
+                print(e);
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    // Only the throw in the try body unwinds to the landing pad
+    EXPECT_EQ(countOccurrences(ir, "unwind label %catch.lpad"), 1u);
+    EXPECT_EQ(countOccurrences(ir, "landingpad"), 1u);
+}
+
+TEST_F(ExceptionCodegenTest, NestedTryRethrowReachesOuterHandler) {
+    auto ir = getIR(R"(
+        func main() {
+            try {
+                try {
+                    throw "inner";
+                } catch (e: Error) {
+                    throw "rethrown";
+                }
+            } catch (e: Error) {
+                print(e);
+            } finally {
+                print("done");
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(countOccurrences(ir, "landingpad"), 2u);
+    // The inner throw unwinds to the inner pad, the rethrow to the outer one
+    EXPECT_EQ(countOccurrences(ir, "unwind label %catch.lpad"), 2u);
+    EXPECT_EQ(countOccurrences(ir, "unwind label %catch.lpad, !dbg"), 1u);
+}
+
+TEST_F(ExceptionCodegenTest, ReturnRestoresEntryRootDepth) {
+    auto ir = getIR(R"(
+        func build(n: Int) -> String {
+            var s = "item ${n}";
+            try {
+                if n == 0 {
+                    throw "empty";
+                }
+            } catch (e: Error) {
+                return e;
+            }
+            return s;
+        }
+        func main() {
+            print(build(0));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto build = functionBody(ir, "build");
+    ASSERT_FALSE(build.empty());
+    EXPECT_NE(build.find("%fn.roots = call i64 @chris_gc_root_depth()"), std::string::npos);
+    EXPECT_NE(build.find("call void @chris_gc_restore_roots(i64 %fn.roots)"), std::string::npos);
+    EXPECT_EQ(build.find("chris_gc_pop_roots"), std::string::npos);
+}
+
+TEST_F(ExceptionCodegenTest, ThrowPassesSourceLocation) {
+    auto ir = getIR("func main() {\n    throw \"boom\";\n}\n");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("@srcfile = private unnamed_addr constant [9 x i8] c\"test.chr\\00\""),
+              std::string::npos);
+    EXPECT_NE(ir.find("call void @chris_throw_at(ptr @str, ptr @srcfile, i64 2, i64 5)"),
+              std::string::npos);
+}
+
+TEST_F(ExceptionCodegenTest, CallsCarryTheirLineForTraces) {
+    auto ir = getIR(
+        "func risky(x: Int) -> Int {\n"
+        "    if x == 0 {\n"
+        "        throw \"zero\";\n"
+        "    }\n"
+        "    return x;\n"
+        "}\n"
+        "func main() {\n"
+        "    var b = risky(1);\n"
+        "}\n");
+    ASSERT_FALSE(diag.hasErrors());
+    // Outer frames are found in the line table; nothing runs to record them
+    EXPECT_NE(ir.find("emissionKind: LineTablesOnly"), std::string::npos);
+    EXPECT_NE(ir.find("!DILocation(line: 8, column: 13"), std::string::npos);
+    EXPECT_NE(functionBody(ir, "main").find("call i64 @risky(i64 1), !dbg"), std::string::npos);
+    EXPECT_EQ(ir.find("chris_call_site"), std::string::npos);
+}
+
+TEST_F(ExceptionCodegenTest, TraceCopiedOnlyWhenRead) {
+    auto ir = getIR(R"(
+        func main() {
+            try {
+                throw "quiet";
+            } catch (e: Error) {
+                print(e);
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("call ptr @chris_begin_catch(ptr %exc.ptr, ptr null)"), std::string::npos);
+    EXPECT_EQ(ir.find("call ptr @chris_format_stack_trace"), std::string::npos);
+}
+
+TEST_F(ExceptionCodegenTest, StackTraceReadFormatsLazily) {
+    auto ir = getIR(R"(
+        func main() {
+            try {
+                throw "loud";
+            } catch (e: Error) {
+                print(e.stackTrace);
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("call ptr @chris_begin_catch(ptr %exc.ptr, ptr %e.trace)"), std::string::npos);
+    EXPECT_NE(ir.find("call void @chris_gc_push_root(ptr %e.trace)"), std::string::npos);
+    EXPECT_NE(ir.find("call ptr @chris_format_stack_trace(ptr %trace)"), std::string::npos);
+}
+
+TEST_F(ExceptionCodegenTest, MainRegistersTraceTable) {
+    auto ir = getIR(R"(
+        func helper(x: Int, name: String) -> Int {
+            return x;
+        }
+        func main() {
+            print(helper(1, "a"));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("@__chris_trace_table = private constant [2 x { ptr, ptr, ptr, i64, i64 }]"),
+              std::string::npos);
+    EXPECT_NE(ir.find("c\"helper(x: Int, name: String) -> Int\\00\""), std::string::npos);
+    EXPECT_NE(ir.find("call void @chris_register_trace_table(ptr @__chris_trace_table, i64 2)"),
+              std::string::npos);
+}
+
+// ==================== Runtime Tests ====================
+
+class ExceptionRuntimeTest : public ::testing::Test {
+protected:
+    void SetUp() override { chris_gc_init(); }
+    void TearDown() override { chris_gc_shutdown(); }
+};
+
+TEST_F(ExceptionRuntimeTest, RestoreRootsDropsSkippedFrames) {
+    void* a = chris_gc_alloc(16, GC_STRING);
+    void* b = chris_gc_alloc(16, GC_STRING);
+    void* c = chris_gc_alloc(16, GC_STRING);
+
+    chris_gc_push_root(&a);
+    size_t depth = chris_gc_root_depth();
+    // Roots pushed by frames that an exception unwinds past
+    chris_gc_push_root(&b);
+    chris_gc_push_root(&c);
+    EXPECT_EQ(chris_gc_root_depth(), depth + 2);
+
+    chris_gc_restore_roots(depth);
+    EXPECT_EQ(chris_gc_root_depth(), depth);
+
+    // The dropped slots no longer keep their objects alive
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), 1u);
+    chris_gc_pop_root();
+}
+
+TEST_F(ExceptionRuntimeTest, RestoreRootsNeverGrowsStack) {
+    size_t depth = chris_gc_root_depth();
+    chris_gc_restore_roots(depth + 5);
+    EXPECT_EQ(chris_gc_root_depth(), depth);
+}
+
+static int traceTarget(int x) {
+    return x * 3 + 1;
+}
+
+TEST_F(ExceptionRuntimeTest, FormatSymbolisesRegisteredFrames) {
+    chris_trace_entry table[] = {
+        {(void*)&traceTarget, "traceTarget(x: Int) -> Int", "math.chr", 12, 1},
+    };
+    chris_register_trace_table(table, 1);
+
+    chris_stack_trace trace = {};
+    trace.message = "Cannot divide by zero";
+    trace.file = "math.chr";
+    trace.line = 14;
+    trace.column = 9;
+    // An address inside traceTarget, then one the table does not know
+    trace.frames[0] = (char*)&traceTarget + 2;
+    trace.frames[1] = (void*)0x10;
+    trace.frame_count = 2;
+
+    std::string text = chris_format_stack_trace(&trace);
+    EXPECT_EQ(text.find("Error: Cannot divide by zero\n"), 0u);
+    EXPECT_NE(text.find("  at traceTarget(x: Int) -> Int\n     math.chr:14:9\n"), std::string::npos);
+    EXPECT_EQ(text.find("  at ", text.find("  at ") + 1), std::string::npos);
+    chris_register_trace_table(nullptr, 0);
+    EXPECT_EQ(traceTarget(1), 4);
+}
+
+static int traceCaller(int x) {
+    return traceTarget(x) - 1;
+}
+
+TEST_F(ExceptionRuntimeTest, OuterFramesShowTheirCallSite) {
+    chris_trace_entry table[] = {
+        {(void*)&traceTarget, "traceTarget(x: Int) -> Int", "math.chr", 12, 1},
+        {(void*)&traceCaller, "traceCaller(x: Int) -> Int", "math.chr", 20, 1},
+    };
+    chris_register_trace_table(table, 2);
+    // Rows for the first two bytes of traceCaller; the next ones have no line
+    chris_line_entry rows[] = {
+        {(char*)&traceCaller + 0, 23, 16},
+        {(char*)&traceCaller + 2, 0, 0},
+        {(char*)&traceCaller + 4, -1, 0},
+    };
+    chris_add_line_table(rows, 3);
+
+    chris_stack_trace trace = {};
+    trace.message = "Cannot divide by zero";
+    trace.file = "math.chr";
+    trace.line = 14;
+    trace.column = 9;
+    trace.frames[0] = (char*)&traceTarget + 2;
+    trace.frames[1] = (char*)&traceCaller + 2;
+    trace.frames[2] = (char*)&traceCaller + 4;
+    trace.frame_count = 3;
+
+    // The line of the call before the return address, or the declaration
+    // when the line table has none
+    std::string text = chris_format_stack_trace(&trace);
+    EXPECT_NE(text.find("  at traceTarget(x: Int) -> Int\n     math.chr:14:9\n"), std::string::npos);
+    EXPECT_NE(text.find("  at traceCaller(x: Int) -> Int\n     math.chr:23:16\n"), std::string::npos);
+    EXPECT_NE(text.find("  at traceCaller(x: Int) -> Int\n     math.chr:20:1\n"), std::string::npos);
+    chris_register_trace_table(nullptr, 0);
+    EXPECT_EQ(traceCaller(1), 3);
+}
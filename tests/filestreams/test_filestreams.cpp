@@ -0,0 +1,253 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+
+extern "C" {
+#include "gc.h"
+void* chris_file_reader_open(const char* path, long long bufferSize, long long flags);
+const char* chris_file_read_line(void* handle);
+long long chris_file_read_into(void* handle, void* dst, long long count);
+void chris_file_reader_close(void* handle);
+void* chris_file_writer_open(const char* path, int append, long long bufferSize, long long flags);
+int chris_file_write(void* handle, const char* s);
+int chris_file_write_line(void* handle, const char* s);
+int chris_file_write_all(void* handle, const void* src, long long count);
+int chris_file_flush(void* handle);
+int chris_file_writer_close(void* handle);
+}
+
+using namespace chris;
+
+// ==================== Type Checker Tests ====================
+
+class FileStreamsTypeCheckerTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    void check(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+    }
+};
+
+TEST_F(FileStreamsTypeCheckerTest, WriterCalls) {
+    check(R"(
+        func main() {
+            var w = fileWriterOpen("out.log", true);
+            var ok: Bool = fileWriteLine(w, "hello");
+            fileWrite(w, "partial");
+            fileFlush(w);
+            var closed: Bool = fileWriterClose(w);
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(FileStreamsTypeCheckerTest, ReaderCalls) {
+    check(R"(
+        func main() {
+            var r = fileReaderOpenWith("in.bin", 1048576, 1);
+            var buf = alloc(4096);
+            var n: Int = fileReadInto(r, buf, 4096);
+            var line: String? = fileReadLine(r);
+            fileReaderClose(r);
+            dealloc(buf);
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(FileStreamsTypeCheckerTest, LinesLoopVariableIsString) {
+    check(R"(
+        func main() {
+            var r = fileReaderOpen("in.log");
+            var total = 0;
+            for line in fileLines(r) {
+                total = total + line.length;
+            }
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+// ==================== Codegen Tests ====================
+
+class FileStreamsCodegenTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        codegen.generate(program);
+        return codegen.getIR();
+    }
+};
+
+TEST_F(FileStreamsCodegenTest, WriterOpenPassesDefaults) {
+    auto ir = getIR(R"(func main() { var w = fileWriterOpen("a.log", true); fileWriterClose(w); })");
+    auto call = ir.find("@chris_file_writer_open(");
+    ASSERT_NE(call, std::string::npos);
+    EXPECT_NE(ir.find("i64 0, i64 0)", call), std::string::npos);
+    EXPECT_NE(ir.find("chris_file_writer_close"), std::string::npos);
+}
+
+TEST_F(FileStreamsCodegenTest, LinesLoopCallsReadLine) {
+    auto ir = getIR(R"(
+        func main() {
+            var r = fileReaderOpen("a.log");
+            for line in fileLines(r) {
+                print(line);
+            }
+        }
+    )");
+    EXPECT_NE(ir.find("streamcond"), std::string::npos);
+    EXPECT_NE(ir.find("call ptr @chris_file_read_line"), std::string::npos);
+    EXPECT_NE(ir.find("icmp ne ptr"), std::string::npos);
+}
+
+TEST_F(FileStreamsCodegenTest, WriteAllReturnsBool) {
+    auto ir = getIR(R"(
+        func main() {
+            var w = fileWriterOpenWith("a.bin", false, 1048576, 4);
+            var buf = alloc(16);
+            var ok = fileWriteAll(w, buf, 16);
+        }
+    )");
+    EXPECT_NE(ir.find("chris_file_write_all"), std::string::npos);
+    EXPECT_NE(ir.find("file.writeAll.bool"), std::string::npos);
+}
+
+// ==================== Runtime Tests ====================
+
+class FileStreamsRuntimeTest : public ::testing::Test {
+protected:
+    std::string path = "/tmp/chris_filestreams_test.txt";
+
+    void SetUp() override { chris_gc_init(); }
+    void TearDown() override {
+        chris_gc_shutdown();
+        std::remove(path.c_str());
+    }
+
+    std::string slurp() {
+        std::string out;
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) return out;
+        char buf[256];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+        std::fclose(f);
+        return out;
+    }
+};
+
+TEST_F(FileStreamsRuntimeTest, WriterBuffersUntilFlush) {
+    void* w = chris_file_writer_open(path.c_str(), 0, 0, 0);
+    ASSERT_NE(w, nullptr);
+    EXPECT_EQ(chris_file_write_line(w, "one"), 1);
+    EXPECT_EQ(slurp(), "");
+    EXPECT_EQ(chris_file_flush(w), 1);
+    EXPECT_EQ(slurp(), "one\n");
+    EXPECT_EQ(chris_file_write(w, "two"), 1);
+    EXPECT_EQ(chris_file_writer_close(w), 1);
+    EXPECT_EQ(slurp(), "one\ntwo");
+    EXPECT_EQ(chris_file_writer_close(w), 0); // already closed
+}
+
+TEST_F(FileStreamsRuntimeTest, AppendKeepsExistingContent) {
+    void* w = chris_file_writer_open(path.c_str(), 0, 0, 0);
+    chris_file_write(w, "a");
+    chris_file_writer_close(w);
+    w = chris_file_writer_open(path.c_str(), 1, 0, 0);
+    chris_file_write(w, "b");
+    chris_file_writer_close(w);
+    EXPECT_EQ(slurp(), "ab");
+}
+
+TEST_F(FileStreamsRuntimeTest, SmallBufferSpillsAndLargeWritesBypass) {
+    void* w = chris_file_writer_open(path.c_str(), 0, 4, 0);
+    chris_file_write(w, "abc");
+    chris_file_write(w, "defgh");      // crosses the 4-byte buffer
+    chris_file_write(w, "0123456789"); // larger than the buffer
+    chris_file_writer_close(w);
+    EXPECT_EQ(slurp(), "abcdefgh0123456789");
+}
+
+TEST_F(FileStreamsRuntimeTest, ReadLinesAcrossRefills) {
+    void* w = chris_file_writer_open(path.c_str(), 0, 0, 0);
+    chris_file_write(w, "short\r\na much longer line than the buffer\n\nlast");
+    chris_file_writer_close(w);
+
+    void* r = chris_file_reader_open(path.c_str(), 8, 1);
+    ASSERT_NE(r, nullptr);
+    EXPECT_STREQ(chris_file_read_line(r), "short");
+    EXPECT_STREQ(chris_file_read_line(r), "a much longer line than the buffer");
+    EXPECT_STREQ(chris_file_read_line(r), "");
+    EXPECT_STREQ(chris_file_read_line(r), "last");
+    EXPECT_EQ(chris_file_read_line(r), nullptr);
+    chris_file_reader_close(r);
+    chris_file_reader_close(r); // idempotent
+}
+
+TEST_F(FileStreamsRuntimeTest, ReadIntoMixesBufferedAndDirectReads) {
+    std::string data;
+    for (int i = 0; i < 100; i++) data += static_cast<char>('a' + i % 26);
+    void* w = chris_file_writer_open(path.c_str(), 0, 0, 0);
+    chris_file_write_all(w, data.data(), static_cast<long long>(data.size()));
+    chris_file_writer_close(w);
+
+    void* r = chris_file_reader_open(path.c_str(), 16, 0);
+    char buf[128] = {0};
+    EXPECT_EQ(chris_file_read_into(r, buf, 10), 10);
+    EXPECT_EQ(chris_file_read_into(r, buf + 10, 80), 80);
+    EXPECT_EQ(chris_file_read_into(r, buf + 90, 50), 10);
+    EXPECT_EQ(chris_file_read_into(r, buf + 100, 10), 0);
+    EXPECT_EQ(std::string(buf, 100), data);
+}
+
+TEST_F(FileStreamsRuntimeTest, DirectAndNoCacheFlagsRoundTrip) {
+    std::string data(10000, 'x');
+    void* w = chris_file_writer_open(path.c_str(), 0, 4096, 4 | 2);
+    ASSERT_NE(w, nullptr);
+    EXPECT_EQ(chris_file_write_all(w, data.data(), static_cast<long long>(data.size())), 1);
+    EXPECT_EQ(chris_file_writer_close(w), 1);
+
+    void* r = chris_file_reader_open(path.c_str(), 4096, 4 | 2 | 1);
+    ASSERT_NE(r, nullptr);
+    std::string back(data.size() + 10, '\0');
+    EXPECT_EQ(chris_file_read_into(r, &back[0], static_cast<long long>(back.size())), 10000);
+    back.resize(10000);
+    EXPECT_EQ(back, data);
+}
+
+TEST_F(FileStreamsRuntimeTest, MissingFileReturnsNull) {
+    EXPECT_EQ(chris_file_reader_open("/tmp/chris_filestreams_missing", 0, 0), nullptr);
+    EXPECT_EQ(chris_file_read_line(nullptr), nullptr);
+}
+
+TEST_F(FileStreamsRuntimeTest, FinalizerFlushesUnreachableWriter) {
+    size_t before = chris_gc_object_count();
+    void* w = chris_file_writer_open(path.c_str(), 0, 0, 0);
+    chris_file_write(w, "flushed by finalizer");
+    w = nullptr;
+    EXPECT_EQ(chris_gc_object_count(), before + 1);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), before);
+    EXPECT_EQ(slurp(), "flushed by finalizer");
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+#include "ir_helpers.h"
+
+using namespace chris;
+
+class InlineCallbackTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+};
+
+TEST_F(InlineCallbackTest, LambdaLiteralsAreExpandedInPlace) {
+    auto ir = getIR(R"(
+        func main() {
+            var nums = [1, 2, 3, 4];
+            var doubled = nums.map((n: Int) => n * 2);
+            var odd = nums.filter((n: Int) => n % 2 == 1);
+            nums.forEach((n: Int) => {
+                print(n);
+            });
+            print(doubled.length + odd.length);
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(ir.find("__lambda_"), std::string::npos) << ir;
+    EXPECT_EQ(ir.find("call void @chris_array_map"), std::string::npos);
+    EXPECT_EQ(ir.find("call void @chris_array_filter"), std::string::npos);
+    EXPECT_EQ(ir.find("call void @chris_array_foreach"), std::string::npos);
+    auto body = functionBody(ir, "main");
+    EXPECT_NE(body.find("map.body:"), std::string::npos) << body;
+    EXPECT_NE(body.find("filter.keep:"), std::string::npos);
+}
+
+TEST_F(InlineCallbackTest, MapResultIsSizedOnce) {
+    auto ir = getIR(R"(
+        func main() {
+            var nums = [1, 2, 3];
+            var doubled = nums.map((n: Int) => n * 2);
+            print(doubled[0]);
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "main");
+    // One allocation for the literal, one for the result, none in the loop
+    auto loop = body.substr(body.find("map.body:"));
+    loop = loop.substr(0, loop.find("map.end:"));
+    EXPECT_EQ(loop.find("@chris_gc_alloc"), std::string::npos) << loop;
+    EXPECT_NE(body.find("%out.bytes = mul i64 %arr.len, 8"), std::string::npos) << body;
+}
+
+TEST_F(InlineCallbackTest, BlockBodyReturnsEndTheBodyNotTheFunction) {
+    auto ir = getIR(R"(
+        func bigOnes() -> Int {
+            var nums = [1, 5, 2, 7];
+            var big = nums.filter((n: Int) => {
+                if n > 3 {
+                    return true;
+                }
+                return false;
+            });
+            return big.length;
+        }
+        func main() {
+            print(bigOnes());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "bigOnes");
+    size_t rets = 0;
+    for (size_t pos = body.find("  ret "); pos != std::string::npos; pos = body.find("  ret ", pos + 1)) {
+        rets++;
+    }
+    EXPECT_EQ(rets, 1u) << body;
+    EXPECT_NE(body.find("br label %lambda.end"), std::string::npos);
+}
+
+TEST_F(InlineCallbackTest, InlinedLambdasSeeEnclosingLocals) {
+    auto ir = getIR(R"(
+        func scale(factor: Int) -> Int {
+            var nums = [1, 2, 3];
+            var scaled = nums.map((n: Int) => n * factor);
+            return scaled[2];
+        }
+        func main() {
+            print(scale(3));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(functionBody(ir, "scale").find("%factor"), std::string::npos);
+}
+
+TEST_F(InlineCallbackTest, ReduceFoldsInline) {
+    auto ir = getIR(R"(
+        func product() -> Float {
+            var fs = [1.5, 2.5];
+            return fs.reduce(1.0, (acc: Float, x: Float) => acc * x);
+        }
+        func main() {
+            print(product());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "product");
+    EXPECT_NE(body.find("fmul double"), std::string::npos) << body;
+    EXPECT_NE(body.find("%reduce.acc = alloca double"), std::string::npos);
+    EXPECT_EQ(body.find("call double"), std::string::npos);
+}
+
+TEST_F(InlineCallbackTest, FunctionValuesAreCalledFromTheLoop) {
+    auto ir = getIR(R"(
+        func add(a: Int, b: Int) -> Int {
+            return a + b;
+        }
+        func main() {
+            var nums = [1, 2, 3];
+            var double = (n: Int) => n * 2;
+            var doubled = nums.map(double);
+            print(doubled.length + nums.reduce(0, add));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "main");
+    EXPECT_NE(body.find("map.body:"), std::string::npos) << body;
+    EXPECT_NE(body.find("%map.call = call i64 %closure.code("), std::string::npos) << body;
+    EXPECT_NE(body.find("%reduce.call = call i64 @add("), std::string::npos) << body;
+}
+
+TEST_F(InlineCallbackTest, ReduceIsTypeChecked) {
+    Lexer lexer(R"(
+        func main() {
+            var nums = [1, 2, 3];
+            print(nums.reduce("", (a: Int, b: Int) => a + b));
+        }
+    )", "test.chr", diag);
+    auto tokens = lexer.tokenize();
+    Parser parser(tokens, diag);
+    auto program = parser.parse();
+    TypeChecker checker(diag);
+    checker.check(program);
+    EXPECT_TRUE(diag.hasErrors());
+}
@@ -1,4 +1,8 @@
 #include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 extern "C" {
 #include "gc.h"
@@ -148,6 +152,62 @@ TEST_F(GCTest, NestedRoots) {
     chris_gc_pop_root();
 }
 
+// ============================================================================
+// Per-thread shadow stacks
+// ============================================================================
+
+TEST_F(GCTest, ThreadsHaveIndependentRootDepths) {
+    void* mine = chris_gc_alloc(16, GC_STRING);
+    chris_gc_push_root((void**)&mine);
+    size_t mainDepth = chris_gc_root_depth();
+
+    std::thread worker([] {
+        EXPECT_EQ(chris_gc_root_depth(), 0u);
+        void* theirs = chris_gc_alloc(16, GC_STRING);
+        chris_gc_push_root((void**)&theirs);
+        EXPECT_EQ(chris_gc_root_depth(), 1u);
+        // Truncating this thread's stack leaves the main thread's alone
+        chris_gc_restore_roots(0);
+    });
+    worker.join();
+
+    EXPECT_EQ(chris_gc_root_depth(), mainDepth);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), 1u);
+    chris_gc_pop_root();
+}
+
+TEST_F(GCTest, CollectionScansOtherThreadsRoots) {
+    std::atomic<int> phase{0};
+    std::thread worker([&] {
+        void* held = chris_gc_alloc(32, GC_STRING);
+        chris_gc_push_root((void**)&held);
+        phase = 1;
+        while (phase != 2) std::this_thread::yield();
+        chris_gc_pop_root();
+    });
+    while (phase != 1) std::this_thread::yield();
+
+    chris_gc_alloc(32, GC_STRING);  // garbage
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), 1u);
+
+    phase = 2;
+    worker.join();
+}
+
+TEST_F(GCTest, ExitedThreadRootsAreReleased) {
+    std::thread worker([] {
+        static void* leaked;
+        leaked = chris_gc_alloc(32, GC_STRING);
+        chris_gc_push_root(&leaked);  // never popped
+    });
+    worker.join();
+
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), 0u);
+}
+
 // ============================================================================
 // Object with pointer fields (mark traversal)
 // ============================================================================
@@ -181,6 +241,62 @@ TEST_F(GCTest, ObjectFieldsTracedDuringMark) {
     chris_gc_pop_root();
 }
 
+TEST_F(GCTest, PointersOutsideTheHeapAreNotMarked) {
+    // A raw buffer whose tail looks like a user pointer: marking it as an
+    // object would write into the bytes before it
+    unsigned char buffer[128];
+    std::memset(buffer, 0xAB, sizeof(buffer));
+    void* raw = buffer + 64;
+    void* parent = chris_gc_alloc(2 * sizeof(void*), GC_OBJECT);
+    chris_gc_set_num_pointers(parent, 2);
+    ((void**)parent)[0] = raw;
+    ((void**)parent)[1] = (void*)(uintptr_t)0x123456789;
+
+    chris_gc_push_root((void**)&raw);
+    chris_gc_push_root((void**)&parent);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), 1u);
+    for (unsigned char byte : buffer) ASSERT_EQ(byte, 0xAB);
+
+    chris_gc_pop_roots(2);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), 0u);
+}
+
+TEST_F(GCTest, ManyObjectsStayFindable) {
+    // Enough objects to grow the heap index several times, freed in a mixed order
+    std::vector<void*> kept;
+    for (int i = 0; i < 20000; i++) {
+        void* obj = chris_gc_alloc(8, GC_STRING);
+        if (i % 3 == 0) kept.push_back(obj);
+    }
+    void* list = chris_gc_alloc(kept.size() * sizeof(void*), GC_ARRAY);
+    std::memcpy(list, kept.data(), kept.size() * sizeof(void*));
+    chris_gc_set_num_pointers(list, (uint16_t)kept.size());
+    chris_gc_push_root(&list);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), kept.size() + 1);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), kept.size() + 1);
+    chris_gc_pop_root();
+}
+
+TEST_F(GCTest, PolymorphicObjectSkipsVtablePointer) {
+    // A read-only "vtable" in slot 0 must not be written by the mark phase
+    static const void* const vtable[1] = {nullptr};
+    void* child = chris_gc_alloc(16, GC_STRING);
+    void* obj = chris_gc_alloc(sizeof(void*) * 2, GC_POLY_OBJECT);
+    chris_gc_set_num_pointers(obj, 2);
+    ((const void**)obj)[0] = vtable;
+    ((void**)obj)[1] = child;
+
+    chris_gc_push_root((void**)&obj);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), 2u);
+
+    chris_gc_pop_root();
+}
+
 // ============================================================================
 // Finalizer tests
 // ============================================================================
@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+#include "ir_helpers.h"
+
+using namespace chris;
+
+class GenericFunctionTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    void check(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+    }
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+
+    static size_t countOccurrences(const std::string& haystack, const std::string& needle) {
+        size_t count = 0;
+        for (size_t pos = haystack.find(needle); pos != std::string::npos;
+             pos = haystack.find(needle, pos + needle.size())) {
+            count++;
+        }
+        return count;
+    }
+};
+
+static const char* kLargest = R"(
+    func largest<T: Comparable>(a: T, b: T) -> T {
+        if a > b {
+            return a;
+        }
+        return b;
+    }
+)";
+
+TEST_F(GenericFunctionTest, EachTypeArgumentGetsItsOwnCopy) {
+    auto ir = getIR(std::string(kLargest) + R"(
+        func main() {
+            print(largest(3, 7));
+            print(largest(2.5, 1.5));
+            print(largest(1, 2));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("define i64 @\"largest<Int>\"(i64 %a, i64 %b)"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("define double @\"largest<Float>\"(double %a, double %b)"), std::string::npos);
+    // Repeated type arguments share one instance, and the template itself is not emitted
+    EXPECT_EQ(countOccurrences(ir, "define i64 @\"largest<Int>\""), 1u);
+    EXPECT_EQ(ir.find("@largest("), std::string::npos);
+    // Comparisons are the type's own instructions, not calls
+    auto body = functionBody(ir, "\"largest<Float>\"");
+    EXPECT_NE(body.find("fcmp"), std::string::npos) << body;
+}
+
+TEST_F(GenericFunctionTest, CallsInsideGenericBodiesAreInstantiated) {
+    auto ir = getIR(std::string(kLargest) + R"(
+        interface Shape {
+            func area() -> Int;
+        }
+        class Square : Shape {
+            public var s: Int;
+            public func area() -> Int { return this.s * this.s; }
+        }
+        func biggest<T: Shape>(a: T, b: T) -> Int {
+            return largest(a.area(), b.area());
+        }
+        func main() {
+            print(biggest(Square { s: 3 }, Square { s: 2 }));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto body = functionBody(ir, "\"biggest<Square>\"");
+    ASSERT_FALSE(body.empty()) << ir;
+    // Within the instance T is Square, so area() is a direct call
+    EXPECT_NE(body.find("call i64 @Square_area"), std::string::npos) << body;
+    EXPECT_NE(body.find("call i64 @\"largest<Int>\""), std::string::npos) << body;
+}
+
+TEST_F(GenericFunctionTest, BoundsWithSeveralImplementersCallTheArgumentsMethod) {
+    auto ir = getIR(R"(
+        interface Shape {
+            func area() -> Int;
+        }
+        class Square : Shape {
+            public var s: Int;
+            public func area() -> Int { return this.s * this.s; }
+        }
+        class Rect : Shape {
+            public var w: Int;
+            public var h: Int;
+            public func area() -> Int { return this.w * this.h; }
+        }
+        func total<T: Shape>(a: T, b: T) -> Int {
+            return a.area() + b.area();
+        }
+        func main() {
+            print(total(Square { s: 3 }, Square { s: 2 }));
+            print(total(Rect { w: 1, h: 2 }, Rect { w: 3, h: 4 }));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    // T is the argument's class, not the bound, so neither instance needs
+    // the vtable even though Shape has two implementers
+    auto squares = functionBody(ir, "\"total<Square>\"");
+    ASSERT_FALSE(squares.empty()) << ir;
+    EXPECT_NE(squares.find("call i64 @Square_area"), std::string::npos) << squares;
+    EXPECT_EQ(squares.find("vfn"), std::string::npos) << squares;
+    auto rects = functionBody(ir, "\"total<Rect>\"");
+    ASSERT_FALSE(rects.empty()) << ir;
+    EXPECT_NE(rects.find("call i64 @Rect_area"), std::string::npos) << rects;
+    EXPECT_EQ(rects.find("vfn"), std::string::npos) << rects;
+}
+
+TEST_F(GenericFunctionTest, ArrayAndLambdaParametersUseTheInferredType) {
+    auto ir = getIR(R"(
+        func sum<T: Numeric>(items: [T]) -> T {
+            var total = items[0];
+            for i in 1..items.length {
+                total = total + items[i];
+            }
+            return total;
+        }
+        func twice<T>(x: T, f: (T) -> T) -> T {
+            return f(f(x));
+        }
+        func main() {
+            print(sum([1.5, 2.25]));
+            print(twice(5, (n: Int) => n * 3));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto sum = functionBody(ir, "\"sum<Float>\"");
+    EXPECT_NE(sum.find("fadd double"), std::string::npos) << sum;
+    EXPECT_NE(ir.find("define i64 @\"twice<Int>\""), std::string::npos);
+}
+
+TEST_F(GenericFunctionTest, UnsatisfiedBoundIsAnError) {
+    check(std::string(kLargest) + R"(
+        func main() {
+            print(largest("a", "b"));
+        }
+    )");
+    EXPECT_TRUE(diag.hasErrors());
+}
+
+TEST_F(GenericFunctionTest, BodyMayOnlyUseTheBound) {
+    check(R"(
+        func add<T>(a: T, b: T) -> T {
+            return a + b;
+        }
+        func main() {
+            print(add(1, 2));
+        }
+    )");
+    EXPECT_TRUE(diag.hasErrors());
+}
+
+TEST_F(GenericFunctionTest, ConflictingArgumentsAreAnError) {
+    check(std::string(kLargest) + R"(
+        func main() {
+            print(largest(1, "b"));
+        }
+    )");
+    EXPECT_TRUE(diag.hasErrors());
+}
+
+TEST_F(GenericFunctionTest, UnknownBoundIsAnError) {
+    check(R"(
+        func id<T: Sortable>(a: T) -> T {
+            return a;
+        }
+        func main() {
+            print(id(1));
+        }
+    )");
+    EXPECT_TRUE(diag.hasErrors());
+}
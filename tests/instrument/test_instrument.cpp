@@ -0,0 +1,282 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+#include "ir_helpers.h"
+
+extern "C" {
+#include "instrument.h"
+}
+
+using namespace chris;
+
+static size_t countOccurrences(const std::string& haystack, const std::string& needle) {
+    size_t count = 0;
+    for (size_t pos = haystack.find(needle); pos != std::string::npos;
+         pos = haystack.find(needle, pos + needle.size())) {
+        count++;
+    }
+    return count;
+}
+
+// ==================== Codegen Tests ====================
+
+class InstrumentCodegenTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source, bool instrument) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        codegen.setInstrumentFunctions(instrument);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+};
+
+static const char* kProgram = R"(
+    func classify(n: Int) -> Int {
+        if n < 0 {
+            return -1;
+        }
+        return 1;
+    }
+    @NoInstrument
+    func quiet(n: Int) -> Int {
+        return n;
+    }
+    func main() {
+        print(classify(3));
+        print(quiet(2));
+    }
+)";
+
+TEST_F(InstrumentCodegenTest, NoHooksByDefault) {
+    auto ir = getIR(kProgram, false);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(ir.find("call i64 @chris_instrument_enter"), std::string::npos);
+    EXPECT_EQ(ir.find("call void @chris_instrument_register"), std::string::npos);
+}
+
+TEST_F(InstrumentCodegenTest, EveryReturnPathCallsExit) {
+    auto ir = getIR(kProgram, true);
+    ASSERT_FALSE(diag.hasErrors());
+    auto classify = functionBody(ir, "classify");
+    ASSERT_FALSE(classify.empty());
+    EXPECT_EQ(countOccurrences(classify, "= call i64 @chris_instrument_enter(i64 0)"), 1u);
+    EXPECT_EQ(countOccurrences(classify, "call void @chris_instrument_exit(i64 %instrument.depth)"), 2u);
+}
+
+TEST_F(InstrumentCodegenTest, NoInstrumentOptsOut) {
+    auto ir = getIR(kProgram, true);
+    ASSERT_FALSE(diag.hasErrors());
+    auto quiet = functionBody(ir, "quiet");
+    ASSERT_FALSE(quiet.empty());
+    EXPECT_EQ(quiet.find("chris_instrument"), std::string::npos);
+    // classify and main are listed; quiet is not
+    EXPECT_NE(ir.find("@__chris_instrument_names = private constant [2 x ptr]"), std::string::npos);
+    EXPECT_NE(ir.find("call void @chris_instrument_register(ptr @__chris_instrument_names, i64 2)"),
+              std::string::npos);
+}
+
+TEST_F(InstrumentCodegenTest, InstrumentOptsInWithoutFlag) {
+    auto ir = getIR(R"(
+        @Instrument
+        func hot(n: Int) -> Int {
+            return n * 2;
+        }
+        class Box {
+            public var v: Int;
+            @Instrument
+            public func get() -> Int {
+                return this.v;
+            }
+        }
+        func main() {
+            var b = Box { v: 1 };
+            print(hot(b.get()));
+        }
+    )", false);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(functionBody(ir, "hot").find("call i64 @chris_instrument_enter"), std::string::npos);
+    EXPECT_NE(functionBody(ir, "Box_get").find("call i64 @chris_instrument_enter"),
+              std::string::npos);
+    EXPECT_EQ(functionBody(ir, "main").find("call i64 @chris_instrument_enter"), std::string::npos);
+    EXPECT_NE(ir.find("c\"Box.get\\00\""), std::string::npos);
+}
+
+TEST_F(InstrumentCodegenTest, LambdaReturnsDoNotCloseEnclosingFunction) {
+    auto ir = getIR(R"(
+        func main() {
+            var nums = [1, 2, 3];
+            var keep = (n: Int) => {
+                return n > 1;
+            };
+            var big = nums.filter(keep);
+            print(big.length);
+        }
+    )", true);
+    ASSERT_FALSE(diag.hasErrors());
+    auto lambda = functionBody(ir, "__lambda_0");
+    ASSERT_FALSE(lambda.empty());
+    EXPECT_EQ(lambda.find("chris_instrument"), std::string::npos);
+}
+
+TEST_F(InstrumentCodegenTest, AnnotationsAreKnown) {
+    getIR(kProgram, true);
+    EXPECT_FALSE(diag.hasErrors());
+    EXPECT_EQ(diag.warningCount(), 0u);
+}
+
+// ==================== Runtime Tests ====================
+
+class InstrumentRuntimeTest : public ::testing::Test {
+protected:
+    // Static: the runtime's exit report still reads the registered names
+    static constexpr const char* names[3] = {"main", "work", "leaf"};
+
+    void SetUp() override { chris_instrument_register(names, 3); }
+
+    std::string report() {
+        char* text = nullptr;
+        size_t length = 0;
+        FILE* out = open_memstream(&text, &length);
+        chris_instrument_report(out);
+        fclose(out);
+        std::string result(text, length);
+        free(text);
+        return result;
+    }
+
+    // The report row for `name`: calls, total ms, self ms
+    bool row(const std::string& text, const std::string& name, unsigned long long* calls,
+             double* total, double* self) {
+        auto pos = text.find("  " + name + "\n");
+        if (pos == std::string::npos) return false;
+        auto start = text.rfind('\n', pos) + 1;
+        double percent = 0;
+        return std::sscanf(text.c_str() + start, "%llu %lf %lf %lf", calls, total, self,
+                           &percent) == 4;
+    }
+};
+
+static void burn() {
+    volatile long long acc = 0;
+    for (int i = 0; i < 2000000; i++) acc = acc + i;
+}
+
+TEST_F(InstrumentRuntimeTest, CountsCallsAndSplitsSelfTime) {
+    long long mainDepth = chris_instrument_enter(0);
+    for (int i = 0; i < 3; i++) {
+        long long workDepth = chris_instrument_enter(1);
+        burn();
+        chris_instrument_exit(workDepth);
+    }
+    chris_instrument_exit(mainDepth);
+
+    std::string text = report();
+    unsigned long long calls = 0;
+    double total = 0, self = 0;
+    ASSERT_TRUE(row(text, "work", &calls, &total, &self)) << text;
+    EXPECT_EQ(calls, 3u);
+    EXPECT_GT(self, 0.0);
+
+    unsigned long long mainCalls = 0;
+    double mainTotal = 0, mainSelf = 0;
+    ASSERT_TRUE(row(text, "main", &mainCalls, &mainTotal, &mainSelf)) << text;
+    EXPECT_EQ(mainCalls, 1u);
+    // main's callees account for nearly all of its time
+    EXPECT_GE(mainTotal, total);
+    EXPECT_LT(mainSelf, total);
+    // Sorted by self time: work comes first
+    EXPECT_LT(text.find("  work\n"), text.find("  main\n"));
+    EXPECT_EQ(text.find("  leaf\n"), std::string::npos);
+}
+
+TEST_F(InstrumentRuntimeTest, RecursionCountsTotalOnce) {
+    long long outer = chris_instrument_enter(1);
+    long long inner = chris_instrument_enter(1);
+    burn();
+    chris_instrument_exit(inner);
+    chris_instrument_exit(outer);
+
+    std::string text = report();
+    unsigned long long calls = 0;
+    double total = 0, self = 0;
+    ASSERT_TRUE(row(text, "work", &calls, &total, &self)) << text;
+    EXPECT_EQ(calls, 2u);
+    // Both activations' self time adds up to the outer activation's total
+    EXPECT_NEAR(total, self, total * 0.05 + 0.01);
+}
+
+TEST_F(InstrumentRuntimeTest, ExitClosesFramesSkippedByUnwinding) {
+    long long mainDepth = chris_instrument_enter(0);
+    chris_instrument_enter(1);
+    chris_instrument_enter(2);
+    // An exception thrown in leaf is caught in main: neither leaf nor work
+    // ran their exit hooks
+    chris_instrument_exit(mainDepth);
+
+    std::string text = report();
+    unsigned long long calls = 0;
+    double total = 0, self = 0;
+    ASSERT_TRUE(row(text, "leaf", &calls, &total, &self)) << text;
+    EXPECT_EQ(calls, 1u);
+    ASSERT_TRUE(row(text, "work", &calls, &total, &self)) << text;
+    EXPECT_EQ(calls, 1u);
+    ASSERT_TRUE(row(text, "main", &calls, &total, &self)) << text;
+    EXPECT_EQ(calls, 1u);
+}
+
+TEST_F(InstrumentRuntimeTest, RecursiveUnwindClosesTheCatchingFrame) {
+    long long outer = chris_instrument_enter(1);
+    chris_instrument_enter(1);
+    chris_instrument_enter(2);
+    // The inner work and leaf are unwound past and the outer work catches:
+    // its exit closes all three, not just the nearest work frame
+    chris_instrument_exit(outer);
+    long long mainDepth = chris_instrument_enter(0);
+    chris_instrument_exit(mainDepth);
+
+    std::string text = report();
+    unsigned long long calls = 0;
+    double total = 0, self = 0;
+    ASSERT_TRUE(row(text, "work", &calls, &total, &self)) << text;
+    EXPECT_EQ(calls, 2u);
+    ASSERT_TRUE(row(text, "leaf", &calls, &total, &self)) << text;
+    EXPECT_EQ(calls, 1u);
+    // main ran after work returned, so work is not its callee
+    ASSERT_TRUE(row(text, "main", &calls, &total, &self)) << text;
+    EXPECT_EQ(calls, 1u);
+    EXPECT_EQ(mainDepth, 0);
+}
+
+TEST_F(InstrumentRuntimeTest, ExitIgnoresUnregisteredIds) {
+    long long mainDepth = chris_instrument_enter(0);
+    // enter drops these, so exit must not close main for them
+    EXPECT_EQ(chris_instrument_enter(7), -1);
+    chris_instrument_exit(chris_instrument_enter(-1));
+    chris_instrument_exit(-1);
+    long long workDepth = chris_instrument_enter(1);
+    burn();
+    chris_instrument_exit(workDepth);
+    chris_instrument_exit(mainDepth);
+
+    std::string text = report();
+    unsigned long long calls = 0;
+    double workTotal = 0, mainTotal = 0, self = 0;
+    ASSERT_TRUE(row(text, "work", &calls, &workTotal, &self)) << text;
+    ASSERT_TRUE(row(text, "main", &calls, &mainTotal, &self)) << text;
+    EXPECT_EQ(calls, 1u);
+    EXPECT_GE(mainTotal, workTotal);
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+// Body of the named function in printed IR, from its define line to the
+// closing brace. Callers can come first (generic instances are emitted after
+// them), so only a define line counts.
+inline std::string functionBody(const std::string& ir, const std::string& name) {
+    for (auto pos = ir.find("@" + name + "("); pos != std::string::npos;
+         pos = ir.find("@" + name + "(", pos + 1)) {
+        auto start = ir.rfind('\n', pos) + 1;
+        if (ir.compare(start, 6, "define") != 0) continue;
+        auto end = ir.find("\n}\n", start);
+        return ir.substr(start, end - start);
+    }
+    return "";
+}
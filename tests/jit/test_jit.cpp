@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+#include "instrument.h"
+
+using namespace chris;
+
+class JitTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    bool run(const std::string& source, int& exitCode, bool instrument = false) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        codegen.setInstrumentFunctions(instrument);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.runJIT(exitCode);
+    }
+};
+
+TEST_F(JitTest, RunsMainInProcess) {
+    int exitCode = -1;
+    testing::internal::CaptureStdout();
+    bool ok = run(R"(
+        func triangle(n: Int) -> Int {
+            var total = 0;
+            for i in 1..n + 1 {
+                total = total + i;
+            }
+            return total;
+        }
+        func main() -> Int {
+            var words = ["jit", "run"];
+            print("${words[1]} ${triangle(4)}");
+            return 3;
+        }
+    )", exitCode);
+    auto output = testing::internal::GetCapturedStdout();
+    ASSERT_TRUE(ok);
+    EXPECT_FALSE(diag.hasErrors());
+    EXPECT_EQ(exitCode, 3);
+    EXPECT_EQ(output, "run 10\n");
+}
+
+TEST_F(JitTest, StackTracesShowCallSiteLines) {
+    int exitCode = -1;
+    testing::internal::CaptureStdout();
+    bool ok = run(
+        "func divide(a: Int, b: Int) -> Int {\n"
+        "    if b == 0 {\n"
+        "        throw \"Cannot divide by zero\";\n"
+        "    }\n"
+        "    return a / b;\n"
+        "}\n"
+        "func half(x: Int) -> Int {\n"
+        "    var y = x + 1;\n"
+        "    return divide(y, 0);\n"
+        "}\n"
+        "func main() -> Int {\n"
+        "    try {\n"
+        "        var result = half(10);\n"
+        "    } catch (e: Error) {\n"
+        "        print(e.stackTrace);\n"
+        "    }\n"
+        "    return 0;\n"
+        "}\n", exitCode);
+    auto output = testing::internal::GetCapturedStdout();
+    ASSERT_TRUE(ok);
+    EXPECT_NE(output.find("  at divide(a: Int, b: Int) -> Int\n     test.chr:3:9\n"), std::string::npos);
+    EXPECT_NE(output.find("  at half(x: Int) -> Int\n     test.chr:9:12\n"), std::string::npos);
+    EXPECT_NE(output.find("  at main() -> Int\n     test.chr:13:22\n"), std::string::npos);
+}
+
+TEST_F(JitTest, MissingMainIsAnError) {
+    int exitCode = -1;
+    EXPECT_FALSE(run(R"(
+        func helper() -> Int {
+            return 1;
+        }
+    )", exitCode));
+    bool found = false;
+    for (auto& d : diag.diagnostics()) {
+        if (d.code == "E4008") found = true;
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST_F(JitTest, TestHooksWriteAReport) {
+    std::string reportPath = "/tmp/chris_jit_report_" + std::to_string(getpid());
+    std::remove(reportPath.c_str());
+    setenv("CHRIS_TEST_REPORT", reportPath.c_str(), 1);
+    int exitCode = -1;
+    testing::internal::CaptureStdout();
+    bool ok = run(R"(
+        extern func chris_test_start(name: String);
+        extern func chris_test_pass(name: String);
+        extern func chris_test_fail(name: String);
+        func main() -> Int {
+            chris_test_start("test_one");
+            chris_test_pass("test_one");
+            chris_test_start("test_two");
+            chris_test_fail("test_two");
+            return 0;
+        }
+    )", exitCode);
+    auto output = testing::internal::GetCapturedStdout();
+    unsetenv("CHRIS_TEST_REPORT");
+    ASSERT_TRUE(ok);
+    EXPECT_NE(output.find("[  OK  ] test_one ("), std::string::npos) << output;
+    EXPECT_NE(output.find("[ FAIL ] test_two ("), std::string::npos) << output;
+
+    std::ifstream in(reportPath);
+    std::stringstream report;
+    report << in.rdbuf();
+    std::remove(reportPath.c_str());
+    EXPECT_EQ(report.str().rfind("pass\ttest_one\t", 0), 0u) << report.str();
+    EXPECT_NE(report.str().find("\nfail\ttest_two\t"), std::string::npos) << report.str();
+}
+
+TEST_F(JitTest, InstrumentedRunsReportBeforeTheJITIsGone) {
+    int exitCode = -1;
+    testing::internal::CaptureStderr();
+    bool ok = run(R"(
+        func square(n: Int) -> Int {
+            return n * n;
+        }
+        func main() -> Int {
+            return square(3) - 9;
+        }
+    )", exitCode, true);
+    auto report = testing::internal::GetCapturedStderr();
+    ASSERT_TRUE(ok);
+    EXPECT_EQ(exitCode, 0);
+    EXPECT_NE(report.find("Function profile"), std::string::npos) << report;
+    EXPECT_NE(report.find("square"), std::string::npos);
+    // The names table went away with the JIT; the exit report must not read it
+    EXPECT_EQ(chris_instrument_report(stderr), 0);
+}
+
+TEST_F(JitTest, MapValuesKeepTheirType) {
+    int exitCode = -1;
+    testing::internal::CaptureStdout();
+    bool ok = run(R"(
+        struct Pair {
+            public var a: Int32;
+            public var b: Float32;
+        }
+        func main() -> Int {
+            var widths: Map<String, Float32> = Map();
+            widths.set("w", 1.25);
+            var pairs: Map<String, Pair> = Map();
+            pairs.set("p", Pair { a: 7, b: 0.5 });
+            var p = pairs.get("p");
+            var missing = pairs.get("q");
+            print(widths.get("w") + p.b);
+            return p.a + missing.a;
+        }
+    )", exitCode);
+    auto output = testing::internal::GetCapturedStdout();
+    ASSERT_TRUE(ok);
+    EXPECT_FALSE(diag.hasErrors());
+    EXPECT_EQ(exitCode, 7);
+    EXPECT_EQ(output, "1.75\n");
+}
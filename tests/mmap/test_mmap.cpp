@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+
+extern "C" {
+#include "gc.h"
+void* chris_mmap_open(const char* path, int writable);
+void* chris_mmap_data(void* handle);
+long long chris_mmap_size(void* handle);
+int chris_mmap_advise(void* handle, long long advice);
+int chris_mmap_sync(void* handle);
+const char* chris_mmap_slice(void* handle, long long start, long long end);
+long long chris_mmap_index_of(void* handle, const char* needle, long long from);
+void chris_mmap_close(void* handle);
+}
+
+using namespace chris;
+
+// ==================== Type Checker Tests ====================
+
+class MmapTypeCheckerTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    void check(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+    }
+};
+
+TEST_F(MmapTypeCheckerTest, OpenAndSize) {
+    check(R"(
+        func main() {
+            var m = mmapOpen("big.log");
+            var n: Int = mmapSize(m);
+            mmapClose(m);
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(MmapTypeCheckerTest, AdviseSliceIndexOf) {
+    check(R"(
+        func main() {
+            var m = mmapOpen("big.log");
+            var ok: Bool = mmapAdvise(m, 2);
+            var nl: Int = mmapIndexOf(m, "\n", 0);
+            var line: String = mmapSlice(m, 0, nl);
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(MmapTypeCheckerTest, WritableDataAndSync) {
+    check(R"(
+        func main() {
+            var m = mmapOpenWritable("data.bin");
+            var p = mmapData(m);
+            unsafe { ptrStoreByte(p, 65); }
+            var ok: Bool = mmapSync(m);
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+// ==================== Codegen Tests ====================
+
+class MmapCodegenTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        codegen.generate(program);
+        return codegen.getIR();
+    }
+};
+
+TEST_F(MmapCodegenTest, OpenPassesWritableFlag) {
+    auto ir = getIR(R"(
+        func main() {
+            var r = mmapOpen("a.bin");
+            var w = mmapOpenWritable("b.bin");
+        }
+    )");
+    auto first = ir.find("@chris_mmap_open(");
+    ASSERT_NE(first, std::string::npos);
+    EXPECT_NE(ir.find("i32 0)", first), std::string::npos);
+    EXPECT_NE(ir.find("i32 1)", first), std::string::npos);
+}
+
+TEST_F(MmapCodegenTest, HandleIsGcRooted) {
+    auto ir = getIR(R"(func main() { var m = mmapOpen("a.bin"); mmapClose(m); })");
+    EXPECT_NE(ir.find("chris_gc_push_root"), std::string::npos);
+    EXPECT_NE(ir.find("chris_mmap_close"), std::string::npos);
+}
+
+TEST_F(MmapCodegenTest, ScanningHelpersCallRuntime) {
+    auto ir = getIR(R"(
+        func main() {
+            var m = mmapOpen("a.log");
+            mmapAdvise(m, 2);
+            var nl = mmapIndexOf(m, "\n", 0);
+            var s = mmapSlice(m, 0, nl);
+        }
+    )");
+    EXPECT_NE(ir.find("chris_mmap_advise"), std::string::npos);
+    EXPECT_NE(ir.find("chris_mmap_index_of"), std::string::npos);
+    EXPECT_NE(ir.find("chris_mmap_slice"), std::string::npos);
+}
+
+// ==================== Runtime Tests ====================
+
+class MmapRuntimeTest : public ::testing::Test {
+protected:
+    std::string path = "/tmp/chris_mmap_test.txt";
+
+    void SetUp() override {
+        chris_gc_init();
+        FILE* f = std::fopen(path.c_str(), "wb");
+        std::fputs("first line\nsecond line\nthird", f);
+        std::fclose(f);
+    }
+    void TearDown() override {
+        chris_gc_shutdown();
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(MmapRuntimeTest, MapsWholeFile) {
+    void* m = chris_mmap_open(path.c_str(), 0);
+    ASSERT_NE(m, nullptr);
+    EXPECT_EQ(chris_mmap_size(m), 28);
+    EXPECT_EQ(std::memcmp(chris_mmap_data(m), "first", 5), 0);
+    chris_mmap_close(m);
+    EXPECT_EQ(chris_mmap_data(m), nullptr);
+    chris_mmap_close(m); // idempotent
+}
+
+TEST_F(MmapRuntimeTest, MissingFileReturnsNull) {
+    EXPECT_EQ(chris_mmap_open("/tmp/chris_mmap_does_not_exist", 0), nullptr);
+    EXPECT_EQ(chris_mmap_size(nullptr), -1);
+}
+
+TEST_F(MmapRuntimeTest, IndexOfAndSlice) {
+    void* m = chris_mmap_open(path.c_str(), 0);
+    long long nl = chris_mmap_index_of(m, "\n", 0);
+    EXPECT_EQ(nl, 10);
+    EXPECT_STREQ(chris_mmap_slice(m, 0, nl), "first line");
+    long long nl2 = chris_mmap_index_of(m, "\n", nl + 1);
+    EXPECT_STREQ(chris_mmap_slice(m, nl + 1, nl2), "second line");
+    EXPECT_EQ(chris_mmap_index_of(m, "\n", nl2 + 1), -1);
+    EXPECT_STREQ(chris_mmap_slice(m, nl2 + 1, 1000), "third");
+    EXPECT_EQ(chris_mmap_index_of(m, "third", 0), 23);
+}
+
+TEST_F(MmapRuntimeTest, IndexOfPastTheEndIsNotFound) {
+    void* m = chris_mmap_open(path.c_str(), 0);
+    EXPECT_EQ(chris_mmap_index_of(m, "t", 1000), -1);
+    EXPECT_EQ(chris_mmap_index_of(m, "", 28), 28);
+    EXPECT_EQ(chris_mmap_index_of(m, "", 29), -1);
+    EXPECT_EQ(chris_mmap_index_of(m, "third", 24), -1);
+    EXPECT_EQ(chris_mmap_index_of(m, "first line\nsecond line\nthird!", 0), -1);
+}
+
+TEST_F(MmapRuntimeTest, AdviseHints) {
+    void* m = chris_mmap_open(path.c_str(), 0);
+    EXPECT_EQ(chris_mmap_advise(m, 2), 1); // sequential
+    EXPECT_EQ(chris_mmap_advise(m, 3), 1); // willneed
+    EXPECT_EQ(chris_mmap_sync(m), 0);      // read-only mapping
+}
+
+TEST_F(MmapRuntimeTest, WritableMappingReachesFile) {
+    void* m = chris_mmap_open(path.c_str(), 1);
+    ASSERT_NE(m, nullptr);
+    static_cast<char*>(chris_mmap_data(m))[0] = 'F';
+    EXPECT_EQ(chris_mmap_sync(m), 1);
+    chris_mmap_close(m);
+
+    char buf[6] = {0};
+    FILE* f = std::fopen(path.c_str(), "rb");
+    ASSERT_EQ(std::fread(buf, 1, 5, f), 5u);
+    std::fclose(f);
+    EXPECT_STREQ(buf, "First");
+}
+
+TEST_F(MmapRuntimeTest, FinalizerUnmapsUnreachableHandle) {
+    size_t before = chris_gc_object_count();
+    chris_mmap_open(path.c_str(), 0);
+    EXPECT_EQ(chris_gc_object_count(), before + 1);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_object_count(), before);
+}
+
+TEST_F(MmapRuntimeTest, CollectsWhileDataPointerIsLive) {
+    // What `var m = mmapOpen(...); var data = mmapData(m);` roots
+    void* m = chris_mmap_open(path.c_str(), 0);
+    void* data = chris_mmap_data(m);
+    chris_gc_push_root(&m);
+    chris_gc_push_root(&data);
+    chris_gc_collect();
+    chris_gc_collect();
+    EXPECT_EQ(std::memcmp(data, "first", 5), 0);
+    EXPECT_EQ(chris_mmap_size(m), 28);
+    chris_gc_pop_roots(2);
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unistd.h>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+
+extern "C" {
+#include "pgo.h"
+}
+
+using namespace chris;
+
+static const char* kProgram = R"(
+    func route(kind: Int) -> Int {
+        if kind == 0 {
+            return 1;
+        }
+        return 2;
+    }
+    func main() {
+        var total = 0;
+        for i in 0..100 {
+            total = total + route(i % 10);
+        }
+        print(total);
+    }
+)";
+
+class PgoTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+    std::string objectPath;
+
+    void SetUp() override {
+        objectPath = "/tmp/chris_pgo_test_" + std::to_string(getpid()) + ".o";
+    }
+    void TearDown() override { std::remove(objectPath.c_str()); }
+
+    // IR after the pipeline that runs when the object file is written
+    std::string compile(const std::function<void(CodeGen&)>& configure, bool* emitted = nullptr) {
+        Lexer lexer(kProgram, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        configure(codegen);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        bool ok = codegen.emitObjectFile(objectPath);
+        if (emitted) *emitted = ok;
+        return codegen.getIR();
+    }
+};
+
+TEST_F(PgoTest, NoCountersByDefault) {
+    auto ir = compile([](CodeGen&) {});
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_EQ(ir.find("__profc_"), std::string::npos);
+    EXPECT_EQ(ir.find("call void @chris_pgo_register"), std::string::npos);
+}
+
+TEST_F(PgoTest, GenerateInstrumentsAndRegistersOutput) {
+    auto ir = compile([](CodeGen& codegen) { codegen.setProfileGenerate("/tmp/profiles"); });
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("@__profc_main"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("@__llvm_profile_raw_version"), std::string::npos);
+    EXPECT_NE(ir.find("c\"/tmp/profiles/default_%p.profraw\\00\""), std::string::npos);
+    auto call = ir.find("call void @chris_pgo_register(");
+    ASSERT_NE(call, std::string::npos) << ir;
+    EXPECT_NE(ir.find("@pgo.path", call), std::string::npos);
+}
+
+TEST_F(PgoTest, MissingProfileDataIsAnError) {
+    bool emitted = true;
+    compile([](CodeGen& codegen) { codegen.setProfileUse("/nonexistent/app.profdata"); }, &emitted);
+    EXPECT_FALSE(emitted);
+    EXPECT_TRUE(diag.hasErrors());
+}
+
+TEST(PgoRuntimeTest, NothingWrittenWithoutCounters) {
+    // This test binary is not instrumented
+    std::string path = "/tmp/chris_pgo_runtime_" + std::to_string(getpid()) + ".profraw";
+    EXPECT_EQ(chris_pgo_write(path.c_str()), 0);
+    EXPECT_EQ(access(path.c_str(), F_OK), -1);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "gc.h"
+#include "profile.h"
+// Mirror of the runtime's stack-trace table entry
+typedef struct {
+    void* fn;
+    const char* signature;
+    const char* file;
+    long long line;
+    long long column;
+} chris_trace_entry;
+void chris_register_trace_table(const chris_trace_entry* table, long long count);
+}
+
+class ProfileTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = "/tmp/chris_profile_test_" + std::to_string(getpid()) + ".folded";
+        chris_gc_init();
+    }
+    void TearDown() override {
+        chris_profile_stop();
+        chris_register_trace_table(nullptr, 0);
+        chris_gc_shutdown();
+        std::remove(path.c_str());
+    }
+
+    std::string readProfile() {
+        std::ifstream in(path);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+};
+
+// Burn CPU time (the profiling timer only advances while running)
+__attribute__((noinline)) static long long spin(int millis) {
+    volatile long long acc = 0;
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(millis);
+    while (std::chrono::steady_clock::now() < until) {
+        for (int i = 0; i < 10000; i++) acc = acc + i * 7;
+    }
+    return acc;
+}
+
+TEST_F(ProfileTest, StopWithoutStartFails) {
+    EXPECT_EQ(chris_profile_stop(), -1);
+}
+
+TEST_F(ProfileTest, SecondStartFails) {
+    ASSERT_EQ(chris_profile_start(path.c_str(), 0), 0);
+    EXPECT_EQ(chris_profile_start(path.c_str(), 0), -1);
+}
+
+TEST_F(ProfileTest, AutostartNeedsTheEnvironmentVariable) {
+    unsetenv("CHRIS_PROFILE");
+    chris_profile_autostart();
+    EXPECT_EQ(chris_profile_stop(), -1);
+}
+
+TEST_F(ProfileTest, AutostartSamplesToTheNamedFile) {
+    setenv("CHRIS_PROFILE", path.c_str(), 1);
+    chris_profile_autostart();
+    unsetenv("CHRIS_PROFILE");
+    spin(50);
+    EXPECT_GE(chris_profile_stop(), 0);
+    EXPECT_TRUE(std::ifstream(path).good());
+}
+
+TEST_F(ProfileTest, WritesFoldedStacksForRegisteredFunctions) {
+    chris_trace_entry table[] = {
+        {(void*)&spin, "spin(millis: Int) -> Int", "bench.chr", 3, 1},
+    };
+    chris_register_trace_table(table, 1);
+
+    ASSERT_EQ(chris_profile_start(path.c_str(), 1000), 0);
+    spin(300);
+    long long samples = chris_profile_stop();
+    EXPECT_GT(samples, 10);
+
+    std::string text = readProfile();
+    EXPECT_NE(text.find("spin(millis: Int) -> Int"), std::string::npos) << text;
+
+    // Every line is "frame;frame;... count" and the counts add up
+    std::istringstream lines(text);
+    std::string line;
+    long long total = 0;
+    while (std::getline(lines, line)) {
+        auto space = line.rfind(' ');
+        ASSERT_NE(space, std::string::npos) << line;
+        total += std::stoll(line.substr(space + 1));
+    }
+    EXPECT_EQ(total, samples);
+}
+
+TEST_F(ProfileTest, AttributesSamplesToGcPhases) {
+    ASSERT_EQ(chris_profile_start(path.c_str(), 1000), 0);
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < until) {
+        for (int i = 0; i < 20000; i++) chris_gc_alloc(16, GC_STRING);
+        chris_gc_collect();
+    }
+    ASSERT_GT(chris_profile_stop(), 0);
+
+    std::string text = readProfile();
+    EXPECT_NE(text.find("[gc sweep]"), std::string::npos) << text;
+}
+
+TEST_F(ProfileTest, StopWaitsForHandlersOnOtherThreads) {
+    // Other threads keep taking SIGPROF while the buffer is freed under them
+    std::atomic<bool> done{false};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; i++) {
+        workers.emplace_back([&done] {
+            while (!done.load()) spin(5);
+        });
+    }
+    for (int round = 0; round < 20; round++) {
+        ASSERT_EQ(chris_profile_start(path.c_str(), 10000), 0);
+        spin(10);
+        EXPECT_GE(chris_profile_stop(), 0);
+    }
+    done = true;
+    for (auto& worker : workers) worker.join();
+}
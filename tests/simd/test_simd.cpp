@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+
+using namespace chris;
+
+class SimdTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    bool check(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        return !diag.hasErrors();
+    }
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        EXPECT_TRUE(codegen.generate(program, checker.genericInstantiations()));
+        return codegen.getIR();
+    }
+
+    bool hasCode(const std::string& code) const {
+        for (auto& d : diag.diagnostics()) {
+            if (d.code == code) return true;
+        }
+        return false;
+    }
+};
+
+TEST_F(SimdTest, VectorTypesLowerToLLVMVectors) {
+    auto ir = getIR(R"(
+        func scale(v: Float32x8, k: Float32x8) -> Float32x8 {
+            return v * k + k;
+        }
+        func main() {
+            var v = scale(Float32x8.splat(2.0), Float32x8.splat(0.5));
+            print(v.sum());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("define <8 x float> @scale(<8 x float> %v, <8 x float> %k)"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("fmul <8 x float>"), std::string::npos);
+    EXPECT_NE(ir.find("fadd <8 x float>"), std::string::npos);
+    EXPECT_NE(ir.find("call reassoc float @llvm.vector.reduce.fadd.v8f32"), std::string::npos) << ir;
+}
+
+TEST_F(SimdTest, ComparisonsProduceMasks) {
+    auto ir = getIR(R"(
+        func positive(v: Int32x4) -> Int32x4 {
+            var mask = v > Int32x4.splat(0);
+            return Int32x4.select(mask, v, Int32x4.splat(0));
+        }
+        func main() {
+            print(positive(Int32x4.splat(3)).get(0));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("icmp sgt <4 x i32>"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("select <4 x i1>"), std::string::npos) << ir;
+}
+
+TEST_F(SimdTest, ArrayLoadsCheckEveryLane) {
+    auto ir = getIR(R"(
+        func first(a: [Float]) -> Float {
+            var v = Float64x4.loadArray(a, 0);
+            return v.fma(v, v).sum();
+        }
+        func main() {
+            print(first([1.0, 2.0, 3.0, 4.0]));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("%span.fits = icmp sge i64 %arr.len, 4"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("load <4 x double>"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("@llvm.fma.v4f64"), std::string::npos);
+}
+
+TEST_F(SimdTest, ArrayLoadsUseTheCheckedElementType) {
+    auto ir = getIR(R"(
+        func ints() -> [Int32] {
+            var a: [Int32] = [1, 2, 3, 4];
+            return a;
+        }
+        func main() {
+            print(Int32x4.loadArray(ints(), 0).sum());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("load <4 x i32>, ptr %vec.elem.ptr, align 4"), std::string::npos) << ir;
+}
+
+TEST_F(SimdTest, PointerLoadsAndStoresAreUnaligned) {
+    auto ir = getIR(R"(
+        func twice(p: Ptr<Float32>) {
+            var v = Float32x8.load(p);
+            (v + v).store(p);
+        }
+        func main() { }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto lineOf = [&](const std::string& text) {
+        auto at = ir.find(text);
+        return at == std::string::npos ? std::string() : ir.substr(at, ir.find('\n', at) - at);
+    };
+    auto load = lineOf("%vec.load = load <8 x float>");
+    auto store = lineOf("store <8 x float> %addtmp");
+    EXPECT_NE(load.find(", align 1"), std::string::npos) << ir;
+    EXPECT_NE(store.find(", align 1"), std::string::npos) << ir;
+}
+
+TEST_F(SimdTest, GatherUsesMaskedGather) {
+    auto ir = getIR(R"(
+        func pick(a: [Float], idx: Int64x4) -> Float64x4 {
+            return Float64x4.gather(a, idx);
+        }
+        func main() {
+            print(pick([1.0, 2.0, 3.0, 4.0], Int64x4.splat(1)).get(0));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("@llvm.masked.gather.v4f64"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("@llvm.vector.reduce.and.v4i1"), std::string::npos);
+}
+
+TEST_F(SimdTest, ByteLanesAreBytes) {
+    auto ir = getIR(R"(
+        func add(a: Int8x16, b: Int8x16) -> Int8x16 {
+            return a + b;
+        }
+        func main() {
+            print(add(Int8x16.splat(1), Int8x16.splat(2)).get(3));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("add <16 x i8>"), std::string::npos) << ir;
+}
+
+TEST_F(SimdTest, ShuffleIsConstant) {
+    auto ir = getIR(R"(
+        func reverse(v: Int32x4) -> Int32x4 {
+            return v.shuffle(3, 2, 1, 0);
+        }
+        func main() {
+            print(reverse(Int32x4.splat(1)).get(0));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("shufflevector <4 x i32> %"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("<4 x i32> <i32 3, i32 2, i32 1, i32 0>"), std::string::npos);
+}
+
+TEST_F(SimdTest, ShuffleIndexesMustBeLiterals) {
+    EXPECT_FALSE(check(R"(
+        func f(v: Int32x4, i: Int) -> Int32x4 {
+            return v.shuffle(i, 0, 1, 9);
+        }
+    )"));
+    EXPECT_TRUE(hasCode("E3055"));
+}
+
+TEST_F(SimdTest, MismatchedVectorsAreAnError) {
+    EXPECT_FALSE(check(R"(
+        func f(a: Float32x4, b: Float32x8) -> Float32x4 {
+            return a + b;
+        }
+    )"));
+    EXPECT_TRUE(hasCode("E3010"));
+}
+
+TEST_F(SimdTest, FloatOnlyMembers) {
+    EXPECT_FALSE(check(R"(
+        func f(a: Int32x8) -> Int32x8 {
+            return a.sqrt();
+        }
+    )"));
+    EXPECT_TRUE(hasCode("E3018"));
+}
+
+TEST_F(SimdTest, ArrayMustMatchLaneKind) {
+    EXPECT_FALSE(check(R"(
+        func f(a: [Float]) -> Int32x4 {
+            return Int32x4.loadArray(a, 0);
+        }
+    )"));
+    EXPECT_TRUE(hasCode("E3014"));
+}
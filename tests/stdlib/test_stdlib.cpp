@@ -532,6 +532,53 @@ TEST_F(StdlibCodegenTest, SetMethodsCompile) {
     ));
 }
 
+// ============================================================================
+// Map Tests
+// ============================================================================
+
+TEST_F(StdlibTypeCheckerTest, MapTakesItsDeclaredValueType) {
+    parseAndCheck(
+        "struct Pair { public var a: Int32; public var b: Float32; }\n"
+        "func main() -> Int {\n"
+        "    var widths: Map<String, Float32> = Map();\n"
+        "    widths.set(\"a\", 1.5);\n"
+        "    var w: Float32 = widths.get(\"a\");\n"
+        "    var pairs: Map<String, Pair> = Map();\n"
+        "    pairs.set(\"p\", Pair { a: 1, b: 2.0 });\n"
+        "    return 0;\n"
+        "}\n"
+    );
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(StdlibTypeCheckerTest, MapRejectsReferenceValues) {
+    parseAndCheck(
+        "func main() -> Int {\n"
+        "    var names: Map<String, String> = Map();\n"
+        "    return 0;\n"
+        "}\n"
+    );
+    bool found = false;
+    for (const auto& d : diag.diagnostics()) {
+        if (d.code == "E3056") found = true;
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST_F(StdlibCodegenTest, MapValueTypesCompile) {
+    EXPECT_TRUE(compiles(
+        "struct Pair { public var a: Int32; public var b: Float32; }\n"
+        "func main() -> Int {\n"
+        "    var flags: Map<String, Bool> = Map();\n"
+        "    flags.set(\"on\", true);\n"
+        "    var pairs: Map<String, Pair> = Map();\n"
+        "    pairs.set(\"p\", Pair { a: 1, b: 2.0 });\n"
+        "    var p = pairs.get(\"p\");\n"
+        "    return p.a;\n"
+        "}\n"
+    ));
+}
+
 // ============================================================================
 // Networking Type Checker Tests
 // ============================================================================
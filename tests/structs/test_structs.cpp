@@ -4,6 +4,7 @@
 #include "sema/type_checker.h"
 #include "codegen/codegen.h"
 #include "common/diagnostic.h"
+#include "ir_helpers.h"
 
 using namespace chris;
 
@@ -164,3 +165,151 @@ TEST_F(StructsCodegenTest, TopLevelConstant) {
     )");
     EXPECT_NE(ir.find("WIDTH"), std::string::npos);
 }
+
+// ==================== Value-Type Structs ====================
+
+static const char* kValueStructs = R"(
+    struct Vec2 {
+        public var x: Float;
+        public var y: Float;
+        public func scale(k: Float) {
+            this.x = this.x * k;
+            this.y = this.y * k;
+        }
+    }
+    struct Particle {
+        public var pos: Vec2;
+        public var id: Int;
+    }
+    func add(a: Vec2, b: Vec2) -> Vec2 {
+        return Vec2 { x: a.x + b.x, y: a.y + b.y };
+    }
+    func step(ps: [Particle]) {
+        for i in 0..ps.length {
+            ps[i].pos.x = ps[i].pos.x + 1.0;
+        }
+    }
+    func main() {
+        var a = Vec2 { x: 1.0, y: 2.0 };
+        var b = a;
+        b.scale(2.0);
+        var ps = [Particle { pos: add(a, b), id: 1 }];
+        step(ps);
+        print(ps[0].pos.x);
+    }
+)";
+
+TEST_F(StructsTypeCheckerTest, ValueStructAccepted) {
+    check(kValueStructs);
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(StructsTypeCheckerTest, StructFieldsMustBeValueTypes) {
+    check(R"(
+        class Node {
+            public var v: Int;
+        }
+        struct Bad {
+            public var name: String;
+            public var node: Node;
+        }
+    )");
+    EXPECT_EQ(diag.errorCount(), 2u);
+}
+
+TEST_F(StructsTypeCheckerTest, StructCannotInheritOrContainItself) {
+    check(R"(
+        class Base {
+            public var v: Int;
+        }
+        struct Derived : Base {
+            public var w: Int;
+        }
+        struct Loop {
+            public var next: Loop;
+        }
+    )");
+    EXPECT_EQ(diag.errorCount(), 2u);
+}
+
+TEST_F(StructsTypeCheckerTest, StructCannotBeNullable) {
+    check(R"(
+        struct Vec2 {
+            public var x: Float;
+        }
+        func f(v: Vec2?) {}
+    )");
+    EXPECT_TRUE(diag.hasErrors());
+}
+
+TEST_F(StructsTypeCheckerTest, StructArraysRejectCallbackMethods) {
+    check(R"(
+        struct Vec2 {
+            public var x: Float;
+        }
+        func main() {
+            var vs = [Vec2 { x: 1.0 }];
+            vs.forEach((v: Vec2) => {
+                print(v.x);
+            });
+        }
+    )");
+    EXPECT_TRUE(diag.hasErrors());
+}
+
+TEST_F(StructsCodegenTest, StructsAreNeverHeapAllocated) {
+    auto ir = getIR(kValueStructs);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("%Vec2 = type { double, double }"), std::string::npos);
+    EXPECT_NE(ir.find("%Particle = type { %Vec2, i64 }"), std::string::npos);
+    // Passed and returned as aggregates
+    EXPECT_NE(ir.find("define %Vec2 @add(%Vec2 %a, %Vec2 %b)"), std::string::npos);
+    EXPECT_EQ(functionBody(ir, "add").find("chris_gc_alloc"), std::string::npos);
+    // Only the array buffer is allocated in main
+    auto main = functionBody(ir, "main");
+    EXPECT_EQ(main.find("call ptr @chris_gc_alloc"), std::string::npos);
+    EXPECT_NE(main.find("call ptr @chris_array_alloc(i64 24, i64 1)"), std::string::npos);
+}
+
+TEST_F(StructsCodegenTest, ArrayElementsUpdatedInPlace) {
+    auto ir = getIR(kValueStructs);
+    ASSERT_FALSE(diag.hasErrors());
+    auto step = functionBody(ir, "step");
+    // ps[i].pos.x addresses the element inline: no copy of the whole struct
+    EXPECT_NE(step.find("getelementptr %Particle, ptr"), std::string::npos);
+    EXPECT_NE(step.find("%Vec2, ptr"), std::string::npos);
+    EXPECT_EQ(step.find("store %Particle"), std::string::npos);
+}
+
+TEST_F(StructsCodegenTest, MethodsReceiveTheStructsAddress) {
+    auto ir = getIR(kValueStructs);
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("define void @Vec2_scale(ptr %this, double %k)"), std::string::npos);
+    // b.scale() updates b's own stack slot
+    EXPECT_NE(functionBody(ir, "main").find("call void @Vec2_scale(ptr %b"), std::string::npos);
+}
+
+TEST_F(StructsCodegenTest, ReturnedArraysHoldStructElements) {
+    auto ir = getIR(R"(
+        struct Vec2 {
+            public var x: Float;
+            public var y: Float;
+        }
+        func points() -> [Vec2] {
+            return [Vec2 { x: 1.0, y: 2.0 }];
+        }
+        func main() {
+            var ps = points();
+            print(ps[0].x);
+            for p in points() {
+                print(p.y);
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto main = functionBody(ir, "main");
+    // Both arrays step through 16-byte Vec2 elements, not 8-byte words
+    EXPECT_NE(main.find("getelementptr %Vec2, ptr"), std::string::npos) << main;
+    EXPECT_NE(main.find("load %Vec2, ptr %elem.ptr"), std::string::npos);
+    EXPECT_EQ(main.find("getelementptr i64, ptr"), std::string::npos);
+}
@@ -43,6 +43,27 @@ TEST_F(TypedArraysTypeCheckerTest, PtrStoreInt16) {
     EXPECT_FALSE(diag.hasErrors());
 }
 
+TEST_F(TypedArraysTypeCheckerTest, PtrLoadStoreFloat64) {
+    check("func test(p: Ptr, v: Float) -> Float { ptrStoreFloat64(p, v); return ptrLoadFloat64(p); }");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(TypedArraysTypeCheckerTest, PtrLoadStoreFixedEndian) {
+    check(R"(
+        func test(p: Ptr) -> Int {
+            var total = 0;
+            unsafe {
+                ptrStoreU32BE(p, 1);
+                ptrStoreU16LE(p + 4, 2);
+                ptrStoreU64LE(p + 6, 3);
+                total = ptrLoadU32BE(p) + ptrLoadU16LE(p + 4) + ptrLoadU64BE(p + 6);
+            }
+            return total;
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
 TEST_F(TypedArraysTypeCheckerTest, Memcpy) {
     check("func test(dst: Ptr, src: Ptr, n: Int) { memcpy(dst, src, n); }");
     EXPECT_FALSE(diag.hasErrors());
@@ -71,6 +92,20 @@ TEST_F(TypedArraysTypeCheckerTest, PixelBufferPattern) {
 
 // ==================== Codegen Tests ====================
 
+TEST_F(TypedArraysTypeCheckerTest, PtrAccessTakesAnAlignment) {
+    check("func test(p: Ptr, v: Int) -> Int { ptrStoreU32LE(p, v, 4); return ptrLoadInt32(p, 4); }");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(TypedArraysTypeCheckerTest, PtrAccessAlignmentMustBeAPowerOfTwoLiteral) {
+    check("func test(p: Ptr, n: Int) -> Int { ptrStoreInt16(p, 1, 3); return ptrLoadInt32(p, n); }");
+    int errors = 0;
+    for (const auto& d : diag.diagnostics()) {
+        if (d.code == "E3057") errors++;
+    }
+    EXPECT_EQ(errors, 2);
+}
+
 class TypedArraysCodegenTest : public ::testing::Test {
 protected:
     DiagnosticEngine diag;
@@ -86,26 +121,77 @@ protected:
         codegen.generate(program);
         return codegen.getIR();
     }
+
+    // Returns the IR line containing `needle`, or "" if absent.
+    static std::string lineWith(const std::string& ir, const std::string& needle) {
+        auto pos = ir.find(needle);
+        if (pos == std::string::npos) return "";
+        auto start = ir.rfind('\n', pos);
+        auto end = ir.find('\n', pos);
+        start = (start == std::string::npos) ? 0 : start + 1;
+        return ir.substr(start, end - start);
+    }
 };
 
-TEST_F(TypedArraysCodegenTest, PtrLoadInt32CallsRuntime) {
+TEST_F(TypedArraysCodegenTest, PtrLoadInt32IsInline) {
     auto ir = getIR("func test(p: Ptr) -> Int { return ptrLoadInt32(p); }");
-    EXPECT_NE(ir.find("chris_ptr_load_i32"), std::string::npos);
+    EXPECT_NE(lineWith(ir, "%ptr.load = load i32").find("align 1"), std::string::npos);
+    EXPECT_NE(ir.find("sext i32"), std::string::npos);
+    EXPECT_EQ(ir.find("chris_ptr_load_i32"), std::string::npos);
 }
 
-TEST_F(TypedArraysCodegenTest, PtrStoreInt32CallsRuntime) {
+TEST_F(TypedArraysCodegenTest, PtrStoreInt32IsInline) {
     auto ir = getIR("func test(p: Ptr, v: Int) { ptrStoreInt32(p, v); }");
-    EXPECT_NE(ir.find("chris_ptr_store_i32"), std::string::npos);
+    EXPECT_NE(ir.find("trunc i64"), std::string::npos);
+    EXPECT_NE(lineWith(ir, "store i32").find("align 1"), std::string::npos);
+    EXPECT_EQ(ir.find("chris_ptr_store_i32"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, PtrLoadInt16IsInline) {
+    auto ir = getIR("func test(p: Ptr) -> Int { return ptrLoadInt16(p); }");
+    EXPECT_NE(lineWith(ir, "%ptr.load = load i16").find("align 1"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, PtrLoadFloat64IsInline) {
+    auto ir = getIR("func test(p: Ptr) -> Float { return ptrLoadFloat64(p); }");
+    EXPECT_NE(lineWith(ir, "%ptr.load = load double").find("align 1"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, PtrLoadBigEndianIsUnalignedAndSwapped) {
+    auto ir = getIR("func test(p: Ptr) -> Int { return ptrLoadU32BE(p); }");
+    EXPECT_NE(lineWith(ir, "%ptr.load = load i32").find("align 1"), std::string::npos);
+    EXPECT_NE(ir.find("llvm.bswap.i32"), std::string::npos);
+    EXPECT_NE(ir.find("zext i32"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, PtrLoadLittleEndianHasNoSwap) {
+    auto ir = getIR("func test(p: Ptr) -> Int { return ptrLoadU16LE(p); }");
+    EXPECT_NE(lineWith(ir, "%ptr.load = load i16").find("align 1"), std::string::npos);
+    EXPECT_EQ(ir.find("llvm.bswap"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, PtrStoreBigEndianSwaps) {
+    auto ir = getIR("func test(p: Ptr, v: Int) { ptrStoreU64BE(p, v); }");
+    EXPECT_NE(ir.find("llvm.bswap.i64"), std::string::npos);
+    EXPECT_NE(ir.find("align 1"), std::string::npos);
 }
 
-TEST_F(TypedArraysCodegenTest, MemcpyCallsRuntime) {
+TEST_F(TypedArraysCodegenTest, PtrAccessEmitsTheStatedAlignment) {
+    auto ir = getIR("func test(p: Ptr, v: Float) -> Int { ptrStoreFloat64(p, v, 8); return ptrLoadU32BE(p, 4); }");
+    EXPECT_NE(lineWith(ir, "store double").find("align 8"), std::string::npos);
+    EXPECT_NE(lineWith(ir, "%ptr.load = load i32").find("align 4"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, MemcpyUsesIntrinsic) {
     auto ir = getIR("func test(d: Ptr, s: Ptr, n: Int) { memcpy(d, s, n); }");
-    EXPECT_NE(ir.find("chris_memcpy"), std::string::npos);
+    EXPECT_NE(ir.find("llvm.memcpy"), std::string::npos);
+    EXPECT_EQ(ir.find("chris_memcpy"), std::string::npos);
 }
 
-TEST_F(TypedArraysCodegenTest, MemsetCallsRuntime) {
+TEST_F(TypedArraysCodegenTest, MemsetUsesIntrinsic) {
     auto ir = getIR("func test(d: Ptr, v: Int, n: Int) { memset(d, v, n); }");
-    EXPECT_NE(ir.find("chris_memset"), std::string::npos);
+    EXPECT_NE(ir.find("llvm.memset"), std::string::npos);
+    EXPECT_EQ(ir.find("chris_memset"), std::string::npos);
 }
 
 TEST_F(TypedArraysCodegenTest, AllocPlusArithmeticPattern) {
@@ -120,6 +206,171 @@ TEST_F(TypedArraysCodegenTest, AllocPlusArithmeticPattern) {
         }
     )");
     EXPECT_NE(ir.find("chris_alloc"), std::string::npos);
-    EXPECT_NE(ir.find("chris_ptr_store_i32"), std::string::npos);
+    EXPECT_NE(ir.find("store i32"), std::string::npos);
     EXPECT_NE(ir.find("getelementptr"), std::string::npos);
 }
+
+// ==================== Element-Width Arrays ====================
+
+TEST_F(TypedArraysTypeCheckerTest, LiteralsTakeTheDeclaredElementType) {
+    check(R"(
+        func total(xs: [Int32]) -> Int32 {
+            var t: Int32 = 0;
+            for x in xs {
+                t = t + x;
+            }
+            return t;
+        }
+        func main() {
+            var xs: [Int32] = [1, 2, 3];
+            var fs: [Float32] = [1.5, 2.5];
+            var bytes: Bytes = [200, 100];
+            print(total([4, 5]));
+            xs = [6, 7];
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(TypedArraysTypeCheckerTest, LiteralElementsMustFitTheDeclaredType) {
+    check(R"(
+        func main() {
+            var xs: [Int32] = [1, "two"];
+        }
+    )");
+    ASSERT_TRUE(diag.hasErrors());
+    bool found = false;
+    for (auto& d : diag.diagnostics()) {
+        if (d.code == "E3025") found = true;
+    }
+    EXPECT_TRUE(found);
+}
+
+TEST_F(TypedArraysCodegenTest, ByteArraysUseOneBytePerElement) {
+    auto ir = getIR(R"(
+        func main() {
+            var bytes: Bytes = [200, 100];
+            bytes[0] = 7;
+            print(bytes[1]);
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("call ptr @chris_array_alloc(i64 1, i64 2)"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("store i8 -56"), std::string::npos);
+    EXPECT_NE(ir.find("store i8 7"), std::string::npos);
+    EXPECT_NE(ir.find("zext i8 %elem to i16"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, SignedBytesAreSignExtended) {
+    auto ir = getIR(R"(
+        func first(xs: [Int8]) -> Int8 {
+            return xs[0];
+        }
+        func main() {
+            print(first([-3, 4]));
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("load i8, ptr %elem.ptr"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("sext i8 %elem to i16"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, PushAndPopUseTheElementWidth) {
+    auto ir = getIR(R"(
+        func main() {
+            var xs: [Float32] = [1.5];
+            xs.push(2.5);
+            print(xs.pop());
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("call ptr @chris_array_push_slot(ptr %arr, i64 4)"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("store float 2.500000e+00, ptr %arr.slot"), std::string::npos);
+    EXPECT_NE(ir.find("load float, ptr %arr.slot"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, FunctionCallbacksTakeTheElementType) {
+    auto ir = getIR(R"(
+        func halve(x: Float) -> Float {
+            return x / 2.0;
+        }
+        func big(x: Int32) -> Bool {
+            return x > 10;
+        }
+        func main() {
+            var fs = [1.0, 3.0];
+            var hs = fs.map(halve);
+            var xs: [Int32] = [5, 20];
+            var bs = xs.filter(big);
+            print(hs.length + bs.length);
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("%map.call = call double @halve(double %elem)"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("%filter.call = call i1 @big(i32 %elem"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("store i32 %elem"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, AliasesKeepTheElementWidth) {
+    auto ir = getIR(R"(
+        func main() {
+            var xs: [Int32] = [5, 20];
+            var ys = xs;
+            print(ys[1]);
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("load i32, ptr %elem.ptr"), std::string::npos) << ir;
+    EXPECT_EQ(ir.find("load i64, ptr %elem.ptr"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, MethodResultsKeepTheElementWidth) {
+    auto ir = getIR(R"(
+        func main() {
+            var xs: [Int32] = [5, 20];
+            for x in xs.filter((n: Int32) => n > 10) {
+                print(x);
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("getelementptr i32, ptr %arr.data"), std::string::npos) << ir;
+    EXPECT_EQ(ir.find("load i64, ptr %elem.ptr"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, ReturnedArraysKeepTheElementWidth) {
+    auto ir = getIR(R"(
+        func makeBytes() -> Bytes {
+            var b: Bytes = [200, 7];
+            return b;
+        }
+        func main() {
+            var bs = makeBytes();
+            print(bs[0]);
+            print(makeBytes()[1]);
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    auto load = ir.find("load i8, ptr %elem.ptr");
+    ASSERT_NE(load, std::string::npos) << ir;
+    EXPECT_NE(ir.find("load i8, ptr %elem.ptr", load + 1), std::string::npos);
+    EXPECT_NE(ir.find("zext i8 %elem to i16"), std::string::npos);
+    EXPECT_EQ(ir.find("load i64, ptr %elem.ptr"), std::string::npos);
+}
+
+TEST_F(TypedArraysCodegenTest, ForInOverACallKeepsTheElementWidth) {
+    auto ir = getIR(R"(
+        func makeBytes() -> Bytes {
+            var b: Bytes = [200, 7];
+            return b;
+        }
+        func main() {
+            for b in makeBytes() {
+                print(b);
+            }
+        }
+    )");
+    ASSERT_FALSE(diag.hasErrors());
+    EXPECT_NE(ir.find("getelementptr i8, ptr %arr.data"), std::string::npos) << ir;
+    EXPECT_NE(ir.find("zext i8 %elem to i16"), std::string::npos);
+}
@@ -0,0 +1,260 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "lexer/lexer.h"
+#include "parser/parser.h"
+#include "sema/type_checker.h"
+#include "codegen/codegen.h"
+#include "common/diagnostic.h"
+
+extern "C" {
+#include "gc.h"
+typedef struct { long long length; void* data; } ChrisArray;
+int chris_file_exists(const char* path);
+long long chris_file_size(const char* path);
+long long chris_file_mtime(const char* path);
+int chris_is_directory(const char* path);
+void chris_list_dir(const char* path, ChrisArray* out);
+void* chris_walk_open(const char* root, const char* pattern);
+const char* chris_walk_next(void* handle);
+void chris_walk_close(void* handle);
+long long chris_parallel_for_each_file(const char* root, const char* pattern, void* fn);
+}
+
+using namespace chris;
+
+// ==================== Type Checker Tests ====================
+
+class WalkTypeCheckerTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    void check(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+    }
+};
+
+TEST_F(WalkTypeCheckerTest, MetadataCalls) {
+    check(R"(
+        func main() {
+            var size: Int = fileSize("a.txt");
+            var mtime: Int = fileModifiedTime("a.txt");
+            var dir: Bool = isDirectory("src");
+            var names: [String] = listDir("src");
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(WalkTypeCheckerTest, WalkLoopVariableIsString) {
+    check(R"(
+        func main() {
+            var total = 0;
+            for path in walkMatching("/data", "*.log") {
+                total = total + path.length;
+            }
+            var w = walk("/data");
+            var first: String? = walkNext(w);
+            walkClose(w);
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+TEST_F(WalkTypeCheckerTest, ParallelForEachFileInfersPathType) {
+    check(R"(
+        func main() {
+            var n: Int = parallelForEachFile("/data", "*.csv", (path) => {
+                var len = path.length;
+            });
+        }
+    )");
+    EXPECT_FALSE(diag.hasErrors());
+}
+
+// ==================== Codegen Tests ====================
+
+class WalkCodegenTest : public ::testing::Test {
+protected:
+    DiagnosticEngine diag;
+
+    std::string getIR(const std::string& source) {
+        Lexer lexer(source, "test.chr", diag);
+        auto tokens = lexer.tokenize();
+        Parser parser(tokens, diag);
+        auto program = parser.parse();
+        TypeChecker checker(diag);
+        checker.check(program);
+        CodeGen codegen("test_module", diag);
+        codegen.generate(program);
+        return codegen.getIR();
+    }
+};
+
+TEST_F(WalkCodegenTest, WalkLoopStreamsPaths) {
+    auto ir = getIR(R"(
+        func main() {
+            for path in walk("/data") {
+                print(path);
+            }
+        }
+    )");
+    EXPECT_NE(ir.find("call ptr @chris_walk_open"), std::string::npos);
+    EXPECT_NE(ir.find("call ptr @chris_walk_next"), std::string::npos);
+    EXPECT_NE(ir.find("streamcond"), std::string::npos);
+}
+
+TEST_F(WalkCodegenTest, ListDirReturnsStringArray) {
+    auto ir = getIR(R"(
+        func main() {
+            for name in listDir("/data") {
+                print(name);
+            }
+        }
+    )");
+    EXPECT_NE(ir.find("@chris_list_dir"), std::string::npos);
+    EXPECT_NE(ir.find("load ptr, ptr %elem.ptr"), std::string::npos);
+}
+
+TEST_F(WalkCodegenTest, ParallelCallbackTakesPtr) {
+    auto ir = getIR(R"(
+        func main() {
+            parallelForEachFile("/data", "*", (path) => {
+                print(path);
+            });
+        }
+    )");
+    EXPECT_NE(ir.find("@chris_parallel_for_each_file"), std::string::npos);
+    EXPECT_NE(ir.find("@__lambda_0(ptr %path, ptr %env)"), std::string::npos);
+}
+
+// ==================== Runtime Tests ====================
+
+static std::atomic<int> g_visited{0};
+static void countPath(const char* path, void* /*env*/) {
+    if (path && std::strstr(path, ".log")) g_visited++;
+}
+// Closure record for countPath: the callback is called with it as env
+static void* countPathClosure[1] = {reinterpret_cast<void*>(&countPath)};
+
+// Asks for a collection before reading the path it was handed
+static void collectThenCountPath(const char* path, void* env) {
+    chris_gc_collect();
+    countPath(path, env);
+}
+static void* collectingClosure[1] = {reinterpret_cast<void*>(&collectThenCountPath)};
+
+class WalkRuntimeTest : public ::testing::Test {
+protected:
+    std::string root = "/tmp/chris_walk_test_" + std::to_string(getpid());
+
+    void write(const std::string& rel, const std::string& text) {
+        FILE* f = std::fopen((root + "/" + rel).c_str(), "wb");
+        std::fputs(text.c_str(), f);
+        std::fclose(f);
+    }
+
+    void SetUp() override {
+        chris_gc_init();
+        mkdir(root.c_str(), 0755);
+        mkdir((root + "/a").c_str(), 0755);
+        mkdir((root + "/a/deep").c_str(), 0755);
+        mkdir((root + "/b").c_str(), 0755);
+        write("top.log", "1234");
+        write("a/one.log", "x");
+        write("a/deep/two.log", "xy");
+        write("a/deep/skip.txt", "z");
+        write("b/three.log", "xyz");
+    }
+    void TearDown() override {
+        chris_gc_shutdown();
+        std::remove((root + "/b/three.log").c_str());
+        std::remove((root + "/a/deep/skip.txt").c_str());
+        std::remove((root + "/a/deep/two.log").c_str());
+        std::remove((root + "/a/one.log").c_str());
+        std::remove((root + "/top.log").c_str());
+        rmdir((root + "/b").c_str());
+        rmdir((root + "/a/deep").c_str());
+        rmdir((root + "/a").c_str());
+        rmdir(root.c_str());
+    }
+};
+
+TEST_F(WalkRuntimeTest, StatHelpers) {
+    EXPECT_EQ(chris_file_size((root + "/top.log").c_str()), 4);
+    EXPECT_EQ(chris_file_size((root + "/missing").c_str()), -1);
+    EXPECT_GT(chris_file_mtime((root + "/top.log").c_str()), 0);
+    EXPECT_EQ(chris_is_directory((root + "/a").c_str()), 1);
+    EXPECT_EQ(chris_is_directory((root + "/top.log").c_str()), 0);
+    EXPECT_EQ(chris_file_exists((root + "/a").c_str()), 1);
+    EXPECT_EQ(chris_file_exists((root + "/missing").c_str()), 0);
+}
+
+TEST_F(WalkRuntimeTest, ListDirIsSortedWithoutDotEntries) {
+    ChrisArray arr;
+    chris_list_dir(root.c_str(), &arr);
+    ASSERT_EQ(arr.length, 3);
+    auto** names = static_cast<const char**>(arr.data);
+    EXPECT_STREQ(names[0], "a");
+    EXPECT_STREQ(names[1], "b");
+    EXPECT_STREQ(names[2], "top.log");
+
+    chris_list_dir((root + "/missing").c_str(), &arr);
+    EXPECT_EQ(arr.length, 0);
+}
+
+TEST_F(WalkRuntimeTest, WalkVisitsEveryFileRecursively) {
+    void* w = chris_walk_open((root + "/").c_str(), nullptr);
+    ASSERT_NE(w, nullptr);
+    std::set<std::string> seen;
+    while (const char* p = chris_walk_next(w)) seen.insert(p);
+    std::set<std::string> expected = {
+        root + "/top.log", root + "/a/one.log", root + "/a/deep/two.log",
+        root + "/a/deep/skip.txt", root + "/b/three.log"};
+    EXPECT_EQ(seen, expected);
+    EXPECT_EQ(chris_walk_next(w), nullptr);
+    chris_walk_close(w);
+    chris_walk_close(w); // idempotent
+}
+
+TEST_F(WalkRuntimeTest, WalkFiltersByPattern) {
+    void* w = chris_walk_open(root.c_str(), "*.txt");
+    ASSERT_NE(w, nullptr);
+    const char* p = chris_walk_next(w);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(std::string(p), root + "/a/deep/skip.txt");
+    EXPECT_EQ(chris_walk_next(w), nullptr);
+}
+
+TEST_F(WalkRuntimeTest, WalkMissingRootReturnsNull) {
+    EXPECT_EQ(chris_walk_open((root + "/missing").c_str(), nullptr), nullptr);
+}
+
+TEST_F(WalkRuntimeTest, ParallelForEachFileVisitsMatches) {
+    g_visited = 0;
+    long long n = chris_parallel_for_each_file(root.c_str(), "*.log", countPathClosure);
+    EXPECT_EQ(n, 4);
+    EXPECT_EQ(g_visited.load(), 4);
+    EXPECT_EQ(chris_parallel_for_each_file((root + "/missing").c_str(), "*", countPathClosure), -1);
+}
+
+TEST_F(WalkRuntimeTest, ParallelForEachFileDefersCollection) {
+    g_visited = 0;
+    size_t before = chris_gc_total_collections();
+    EXPECT_EQ(chris_parallel_for_each_file(root.c_str(), "*.log", collectingClosure), 4);
+    // Workers run while other workers allocate, so none of them collects
+    EXPECT_EQ(g_visited.load(), 4);
+    EXPECT_EQ(chris_gc_total_collections(), before);
+    chris_gc_collect();
+    EXPECT_EQ(chris_gc_total_collections(), before + 1);
+}